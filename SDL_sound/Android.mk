@@ -16,12 +16,15 @@ LOCAL_CFLAGS :=
 LOCAL_SRC_FILES := $(LOCAL_PATH)/src/SDL_sound.c \
 				$(LOCAL_PATH)/src/SDL_sound_aiff.c \
 				$(LOCAL_PATH)/src/SDL_sound_au.c \
+				$(LOCAL_PATH)/src/SDL_sound_cache.c \
+				$(LOCAL_PATH)/src/SDL_sound_convert.c \
 				$(LOCAL_PATH)/src/SDL_sound_coreaudio.c \
 				$(LOCAL_PATH)/src/SDL_sound_flac.c \
 				$(LOCAL_PATH)/src/SDL_sound_mp3.c \
 				$(LOCAL_PATH)/src/SDL_sound_midi.c \
 				$(LOCAL_PATH)/src/SDL_sound_modplug.c \
 				$(LOCAL_PATH)/src/SDL_sound_raw.c \
+				$(LOCAL_PATH)/src/SDL_sound_resample.c \
 				$(LOCAL_PATH)/src/SDL_sound_shn.c \
 				$(LOCAL_PATH)/src/SDL_sound_voc.c \
 				$(LOCAL_PATH)/src/SDL_sound_vorbis.c \
@@ -0,0 +1,268 @@
+/**
+ * SDL_sound; An abstract sound format decoding API.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+/**
+ * This times SDL_sound's own format conversion (used when the sample rate
+ *  doesn't change) against pushing the same PCM data through an
+ *  SDL_AudioStream, and reports the largest difference between the two.
+ *
+ * It builds its test data in memory, so it doesn't need any files.
+ *
+ * Usage: bench_convert [seconds] [runs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#define SDL_MAIN_HANDLED /* this is a console-only app */
+#endif
+#include "SDL.h"
+#include "SDL_sound.h"
+#include "bench_wav.h"
+
+#define BENCH_RATE 44100
+#define BENCH_BUFFER_SIZE (64 * 1024)
+
+typedef struct
+{
+    const char *name;
+    Uint16 bits;   /* 8 or 16, as a .wav file stores them. */
+    Uint8 src_channels;
+    Uint16 dst_format;
+    Uint8 dst_channels;
+} ConvertCase;
+
+static const ConvertCase cases[] =
+{
+    { "S16 stereo -> F32 stereo", 16, 2, AUDIO_F32SYS, 2 },
+    { "S16 mono   -> F32 stereo", 16, 1, AUDIO_F32SYS, 2 },
+    { "S16 stereo -> F32 mono  ", 16, 2, AUDIO_F32SYS, 1 },
+    { "U8 stereo  -> F32 stereo",  8, 2, AUDIO_F32SYS, 2 },
+    { "S16 mono   -> S16 stereo", 16, 1, AUDIO_S16SYS, 2 },
+    { "S16 stereo -> S16MSB    ", 16, 2, AUDIO_S16MSB, 2 }
+};
+
+
+/* A .wav file in memory, a sine wave per channel, at a different pitch in each. */
+static Uint8 *build_wav(const ConvertCase *c, Uint32 frames, Uint32 *len)
+{
+    const double tones[2] = { 440.0, 550.0 };
+    return bench_build_wav(BENCH_RATE, c->bits, c->src_channels, frames,
+                           tones, 0.8, len);
+} /* build_wav */
+
+
+/* Decode through SDL_sound; returns elapsed seconds, or -1.0 on failure. */
+static double via_sdlsound(const ConvertCase *c, Uint8 *wav, Uint32 wavlen,
+                           Uint8 **output, Uint32 *outlen)
+{
+    Sound_AudioInfo desired;
+    Sound_Sample *sample;
+    Uint64 start, end;
+    Uint32 len;
+
+    desired.format = c->dst_format;
+    desired.channels = c->dst_channels;
+    desired.rate = BENCH_RATE;
+
+    sample = Sound_NewSampleFromMem(wav, wavlen, "wav", &desired, BENCH_BUFFER_SIZE);
+    if (sample == NULL)
+    {
+        fprintf(stderr, "Couldn't load test data: %s\n", Sound_GetError());
+        return -1.0;
+    } /* if */
+
+    start = SDL_GetPerformanceCounter();
+    len = Sound_DecodeAll(sample);
+    end = SDL_GetPerformanceCounter();
+
+    if (sample->flags & SOUND_SAMPLEFLAG_ERROR)
+    {
+        fprintf(stderr, "Error decoding test data: %s\n", Sound_GetError());
+        Sound_FreeSample(sample);
+        return -1.0;
+    } /* if */
+
+    *output = (Uint8 *) malloc(len ? len : 1);
+    if (*output != NULL)
+        memcpy(*output, sample->buffer, len);
+    *outlen = len;
+    Sound_FreeSample(sample);
+    return (*output == NULL) ? -1.0 : ((double) (end - start)) / ((double) SDL_GetPerformanceFrequency());
+} /* via_sdlsound */
+
+
+/* Same data through an SDL_AudioStream, the way SDL_sound used to do it. */
+static double via_audiostream(const ConvertCase *c, const Uint8 *pcm,
+                              Uint32 pcmlen, Uint8 **output, Uint32 *outlen)
+{
+    const Uint16 srcfmt = (c->bits == 8) ? AUDIO_U8 : AUDIO_S16LSB;
+    SDL_AudioStream *stream;
+    Uint64 start, end;
+    Uint32 pos = 0;
+    int len = 0;
+    int avail;
+
+    stream = SDL_NewAudioStream(srcfmt, c->src_channels, BENCH_RATE,
+                                c->dst_format, c->dst_channels, BENCH_RATE);
+    if (stream == NULL)
+    {
+        fprintf(stderr, "SDL_NewAudioStream() failed: %s\n", SDL_GetError());
+        return -1.0;
+    } /* if */
+
+    start = SDL_GetPerformanceCounter();
+    while (pos < pcmlen)  /* feed it a decode buffer at a time, like Sound_Decode would. */
+    {
+        const Uint32 chunk = ((pcmlen - pos) < BENCH_BUFFER_SIZE) ? (pcmlen - pos) : BENCH_BUFFER_SIZE;
+        SDL_AudioStreamPut(stream, pcm + pos, (int) chunk);
+        pos += chunk;
+    } /* while */
+    SDL_AudioStreamFlush(stream);
+
+    avail = SDL_AudioStreamAvailable(stream);
+    *output = (Uint8 *) malloc(avail ? avail : 1);
+    if (*output != NULL)
+        len = SDL_AudioStreamGet(stream, *output, avail);
+    end = SDL_GetPerformanceCounter();
+
+    SDL_FreeAudioStream(stream);
+    *outlen = (len > 0) ? (Uint32) len : 0;
+    return (*output == NULL) ? -1.0 : ((double) (end - start)) / ((double) SDL_GetPerformanceFrequency());
+} /* via_audiostream */
+
+
+/* Largest difference between two buffers, as a fraction of full scale. */
+static double max_difference(Uint16 fmt, const Uint8 *a, const Uint8 *b,
+                             Uint32 len)
+{
+    double retval = 0.0;
+    Uint32 i;
+
+    if (fmt == AUDIO_F32SYS)
+    {
+        for (i = 0; i < len / sizeof (float); i++)
+        {
+            float x, y;
+            memcpy(&x, a + (i * sizeof (float)), sizeof (float));
+            memcpy(&y, b + (i * sizeof (float)), sizeof (float));
+            if (fabs(x - y) > retval)
+                retval = fabs(x - y);
+        } /* for */
+    } /* if */
+    else
+    {
+        const int msb = SDL_AUDIO_ISBIGENDIAN(fmt) ? 1 : 0;
+        for (i = 0; i < len / 2; i++)
+        {
+            const Sint16 x = (Sint16) (a[(i * 2) + msb] | (a[(i * 2) + (1 - msb)] << 8));
+            const Sint16 y = (Sint16) (b[(i * 2) + msb] | (b[(i * 2) + (1 - msb)] << 8));
+            const double diff = fabs((double) (x - y)) / 32768.0;
+            if (diff > retval)
+                retval = diff;
+        } /* for */
+    } /* else */
+
+    return retval;
+} /* max_difference */
+
+
+int main(int argc, char **argv)
+{
+    const int seconds = (argc > 1) ? atoi(argv[1]) : 60;
+    int runs = (argc > 2) ? atoi(argv[2]) : 3;
+    int rc = 0;
+    size_t i;
+
+    if (runs < 1)
+        runs = 1;
+
+    if (SDL_Init(0) != 0)
+    {
+        fprintf(stderr, "SDL_Init() failed: %s\n", SDL_GetError());
+        return 1;
+    } /* if */
+
+    if (!Sound_Init())
+    {
+        fprintf(stderr, "Sound_Init() failed: %s\n", Sound_GetError());
+        SDL_Quit();
+        return 1;
+    } /* if */
+
+    printf("%d seconds of audio at %d Hz, best of %d runs.\n", seconds, BENCH_RATE, runs);
+
+    for (i = 0; (rc == 0) && (i < SDL_arraysize(cases)); i++)
+    {
+        const ConvertCase *c = &cases[i];
+        const Uint32 frames = (Uint32) (seconds > 0 ? seconds : 1) * BENCH_RATE;
+        double best_sound = -1.0;
+        double best_stream = -1.0;
+        double diff = 0.0;
+        Uint32 wavlen = 0;
+        Uint8 *wav = build_wav(c, frames, &wavlen);
+        const Uint8 *pcm = wav + BENCH_WAV_HEADER_SIZE;
+        const Uint32 pcmlen = wavlen - BENCH_WAV_HEADER_SIZE;
+        int run;
+
+        if (wav == NULL)
+        {
+            fprintf(stderr, "Out of memory!\n");
+            rc = 1;
+            break;
+        } /* if */
+
+        for (run = 0; (rc == 0) && (run < runs); run++)
+        {
+            Uint8 *a = NULL;
+            Uint8 *b = NULL;
+            Uint32 alen = 0;
+            Uint32 blen = 0;
+            const double t1 = via_sdlsound(c, wav, wavlen, &a, &alen);
+            const double t2 = via_audiostream(c, pcm, pcmlen, &b, &blen);
+
+            if ((t1 < 0.0) || (t2 < 0.0))
+                rc = 1;
+            else if (alen != blen)
+            {
+                fprintf(stderr, "%s: %u bytes from SDL_sound, %u from SDL_AudioStream!\n",
+                        c->name, (unsigned int) alen, (unsigned int) blen);
+                rc = 1;
+            } /* else if */
+            else
+            {
+                const double d = max_difference(c->dst_format, a, b, alen);
+                if (d > diff)
+                    diff = d;
+                if ((best_sound < 0.0) || (t1 < best_sound))
+                    best_sound = t1;
+                if ((best_stream < 0.0) || (t2 < best_stream))
+                    best_stream = t2;
+            } /* else */
+
+            free(a);
+            free(b);
+        } /* for */
+
+        free(wav);
+
+        if (rc == 0)
+        {
+            printf("  %s:  SDL_sound %8.3f ms   SDL_AudioStream %8.3f ms   %5.2fx   max diff %g\n",
+                   c->name, best_sound * 1000.0, best_stream * 1000.0,
+                   (best_sound > 0.0) ? (best_stream / best_sound) : 0.0, diff);
+        } /* if */
+    } /* for */
+
+    Sound_Quit();
+    SDL_Quit();
+    return rc;
+} /* main */
+
+/* end of bench_convert.c ... */
@@ -0,0 +1,181 @@
+/**
+ * SDL_sound; An abstract sound format decoding API.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+/**
+ * This times Sound_DecodeAll() against Sound_DecodeAllParallel() with
+ *  increasing thread counts, and makes sure every parallel decode matches
+ *  the serial one byte-for-byte.
+ *
+ * Usage: bench_decodeall <file> [maxthreads] [runs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define SDL_MAIN_HANDLED /* this is a console-only app */
+#endif
+#include "SDL.h"
+#include "SDL_sound.h"
+
+#define BENCH_BUFFER_SIZE (64 * 1024)
+
+/* Decode (fname) once; returns elapsed seconds, or -1.0 on failure. */
+static double decode_once(const char *fname, int threads,
+                          Uint8 **output, Uint32 *outlen)
+{
+    Sound_Sample *sample = Sound_NewSampleFromFile(fname, NULL, BENCH_BUFFER_SIZE);
+    Uint64 start, end;
+    Uint32 len;
+
+    if (sample == NULL)
+    {
+        fprintf(stderr, "Couldn't load \"%s\": %s\n", fname, Sound_GetError());
+        return -1.0;
+    } /* if */
+
+    start = SDL_GetPerformanceCounter();
+    if (threads == 0)
+        len = Sound_DecodeAll(sample);
+    else
+        len = Sound_DecodeAllParallel(sample, threads);
+    end = SDL_GetPerformanceCounter();
+
+    if (sample->flags & SOUND_SAMPLEFLAG_ERROR)
+    {
+        fprintf(stderr, "Error decoding \"%s\": %s\n", fname, Sound_GetError());
+        Sound_FreeSample(sample);
+        return -1.0;
+    } /* if */
+
+    if (output != NULL)
+    {
+        *output = (Uint8 *) malloc(len ? len : 1);
+        if (*output == NULL)
+        {
+            fprintf(stderr, "Out of memory!\n");
+            Sound_FreeSample(sample);
+            return -1.0;
+        } /* if */
+        memcpy(*output, sample->buffer, len);
+    } /* if */
+
+    *outlen = len;
+    Sound_FreeSample(sample);
+    return ((double) (end - start)) / ((double) SDL_GetPerformanceFrequency());
+} /* decode_once */
+
+
+/* best of (runs), to keep the disk cache and the scheduler out of it. */
+static double best_time(const char *fname, int threads, int runs,
+                        const Uint8 *expected, Uint32 expectedlen,
+                        int *mismatch)
+{
+    double best = -1.0;
+    int i;
+
+    for (i = 0; i < runs; i++)
+    {
+        Uint8 *output = NULL;
+        Uint32 len = 0;
+        const double t = decode_once(fname, threads, &output, &len);
+        if (t < 0.0)
+            return -1.0;
+
+        if ((len != expectedlen) || (memcmp(output, expected, len) != 0))
+            *mismatch = 1;
+        free(output);
+
+        if ((best < 0.0) || (t < best))
+            best = t;
+    } /* for */
+
+    return best;
+} /* best_time */
+
+
+int main(int argc, char **argv)
+{
+    const char *fname;
+    int maxthreads;
+    int runs;
+    Uint8 *serial = NULL;
+    Uint32 seriallen = 0;
+    double serialtime;
+    int rc = 0;
+    int i;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "USAGE: %s <file> [maxthreads] [runs]\n", argv[0]);
+        return 1;
+    } /* if */
+
+    fname = argv[1];
+    maxthreads = (argc > 2) ? atoi(argv[2]) : 0;
+    runs = (argc > 3) ? atoi(argv[3]) : 3;
+    if (runs < 1)
+        runs = 1;
+
+    if (SDL_Init(0) != 0)
+    {
+        fprintf(stderr, "SDL_Init() failed: %s\n", SDL_GetError());
+        return 1;
+    } /* if */
+
+    if (!Sound_Init())
+    {
+        fprintf(stderr, "Sound_Init() failed: %s\n", Sound_GetError());
+        SDL_Quit();
+        return 1;
+    } /* if */
+
+    Sound_SetMapFiles(1);  /* nobody's changing the file while we time it. */
+
+    if (maxthreads <= 0)
+        maxthreads = SDL_GetCPUCount();
+
+    serialtime = decode_once(fname, 0, &serial, &seriallen);
+    if (serialtime >= 0.0)
+    {
+        int mismatch = 0;
+        serialtime = best_time(fname, 0, runs, serial, seriallen, &mismatch);
+    } /* if */
+
+    if (serialtime < 0.0)
+        rc = 1;
+    else
+    {
+        printf("%s: %u bytes decoded, best of %d runs.\n", fname,
+               (unsigned int) seriallen, runs);
+        printf("  serial:     %8.3f ms\n", serialtime * 1000.0);
+
+        for (i = 1; i <= maxthreads; i++)
+        {
+            int mismatch = 0;
+            const double t = best_time(fname, i, runs, serial, seriallen, &mismatch);
+            if (t < 0.0)
+            {
+                rc = 1;
+                break;
+            } /* if */
+
+            printf("  %2d threads: %8.3f ms  %5.2fx%s\n", i, t * 1000.0,
+                   (t > 0.0) ? (serialtime / t) : 0.0,
+                   mismatch ? "  OUTPUT DIFFERS FROM SERIAL DECODE!" : "");
+            if (mismatch)
+                rc = 1;
+        } /* for */
+    } /* else */
+
+    free(serial);
+    Sound_Quit();
+    SDL_Quit();
+    return rc;
+} /* main */
+
+/* end of bench_decodeall.c ... */
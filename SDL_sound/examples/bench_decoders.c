@@ -0,0 +1,222 @@
+/**
+ * SDL_sound; An abstract sound format decoding API.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+/**
+ * This measures decoding throughput for each SIMD tier this CPU has, by
+ *  setting the SDL_SOUND_SIMD environment variable and restarting SDL_sound
+ *  between tiers. Give it some MP3 and FLAC files (anything SDL_sound reads
+ *  will do). It reports megabytes per second of decoded audio, and of the
+ *  file, for each one.
+ *
+ * The FLAC decoder switches tiers at runtime. The MP3 decoder's SIMD is
+ *  fixed when SDL_sound is built on x86-64 and ARM64, so to see what it buys
+ *  there, compare against a build with SDLSOUND_DECODER_SIMD=NONE.
+ *
+ * Files are loaded into memory first, so this doesn't time the disk.
+ *
+ * Usage: bench_decoders <file> [file ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define SDL_MAIN_HANDLED /* this is a console-only app */
+#endif
+#include "SDL.h"
+#include "SDL_sound.h"
+
+#define BENCH_BUFFER_SIZE (64 * 1024)
+#define BENCH_RUNS 3
+
+typedef struct
+{
+    const char *fname;
+    const char *ext;
+    Uint8 *data;
+    Uint32 len;
+} BenchFile;
+
+
+static SDL_bool have_tier(const char *tier)
+{
+    if (strcmp(tier, "none") == 0)
+        return SDL_TRUE;
+    else if (strcmp(tier, "sse2") == 0)
+        return SDL_HasSSE2();
+    else if (strcmp(tier, "sse41") == 0)
+        return SDL_HasSSE41();
+    else if (strcmp(tier, "neon") == 0)
+        return SDL_HasNEON();
+    return SDL_FALSE;
+} /* have_tier */
+
+
+static int load_file(BenchFile *file)
+{
+    SDL_RWops *rw = SDL_RWFromFile(file->fname, "rb");
+    Sint64 len;
+
+    if (rw == NULL)
+    {
+        fprintf(stderr, "Couldn't open \"%s\": %s\n", file->fname, SDL_GetError());
+        return 0;
+    } /* if */
+
+    len = SDL_RWsize(rw);
+    if ((len <= 0) || (len > 0x7FFFFFFF))
+    {
+        fprintf(stderr, "Couldn't get the size of \"%s\".\n", file->fname);
+        SDL_RWclose(rw);
+        return 0;
+    } /* if */
+
+    file->data = (Uint8 *) malloc((size_t) len);
+    if (file->data == NULL)
+    {
+        fprintf(stderr, "Out of memory!\n");
+        SDL_RWclose(rw);
+        return 0;
+    } /* if */
+
+    file->len = (Uint32) len;
+    if (SDL_RWread(rw, file->data, 1, (size_t) len) != (size_t) len)
+    {
+        fprintf(stderr, "Couldn't read \"%s\": %s\n", file->fname, SDL_GetError());
+        SDL_RWclose(rw);
+        return 0;
+    } /* if */
+
+    SDL_RWclose(rw);
+
+    file->ext = strrchr(file->fname, '.');
+    file->ext = (file->ext != NULL) ? (file->ext + 1) : NULL;
+    return 1;
+} /* load_file */
+
+
+/* Returns elapsed seconds, or -1.0 on failure. */
+static double decode_once(const BenchFile *file, Uint32 *outlen)
+{
+    Sound_Sample *sample;
+    Uint64 start, end;
+
+    sample = Sound_NewSampleFromMem(file->data, file->len, file->ext, NULL, BENCH_BUFFER_SIZE);
+    if (sample == NULL)
+    {
+        fprintf(stderr, "Couldn't load \"%s\": %s\n", file->fname, Sound_GetError());
+        return -1.0;
+    } /* if */
+
+    start = SDL_GetPerformanceCounter();
+    *outlen = Sound_DecodeAll(sample);
+    end = SDL_GetPerformanceCounter();
+
+    if (sample->flags & SOUND_SAMPLEFLAG_ERROR)
+    {
+        fprintf(stderr, "Error decoding \"%s\": %s\n", file->fname, Sound_GetError());
+        Sound_FreeSample(sample);
+        return -1.0;
+    } /* if */
+
+    Sound_FreeSample(sample);
+    return ((double) (end - start)) / ((double) SDL_GetPerformanceFrequency());
+} /* decode_once */
+
+
+int main(int argc, char **argv)
+{
+    static const char *tiers[] = { "none", "sse2", "sse41", "neon" };
+    const int total = argc - 1;
+    BenchFile *files;
+    int rc = 0;
+    size_t t;
+    int i;
+
+    if (total < 1)
+    {
+        fprintf(stderr, "Usage: %s <file> [file ...]\n", argv[0]);
+        return 1;
+    } /* if */
+
+    if (SDL_Init(0) != 0)
+    {
+        fprintf(stderr, "SDL_Init() failed: %s\n", SDL_GetError());
+        return 1;
+    } /* if */
+
+    files = (BenchFile *) calloc(total, sizeof (BenchFile));
+    if (files == NULL)
+    {
+        fprintf(stderr, "Out of memory!\n");
+        SDL_Quit();
+        return 1;
+    } /* if */
+
+    for (i = 0; (rc == 0) && (i < total); i++)
+    {
+        files[i].fname = argv[i + 1];
+        if (!load_file(&files[i]))
+            rc = 1;
+    } /* for */
+
+    printf("Best of %d runs per file.\n", BENCH_RUNS);
+
+    for (t = 0; (rc == 0) && (t < SDL_arraysize(tiers)); t++)
+    {
+        if (!have_tier(tiers[t]))
+            continue;
+
+        SDL_setenv("SDL_SOUND_SIMD", tiers[t], 1);
+        if (!Sound_Init())
+        {
+            fprintf(stderr, "Sound_Init() failed: %s\n", Sound_GetError());
+            rc = 1;
+            break;
+        } /* if */
+
+        printf("%s:\n", tiers[t]);
+        for (i = 0; (rc == 0) && (i < total); i++)
+        {
+            double best = -1.0;
+            Uint32 outlen = 0;
+            int run;
+
+            for (run = 0; run < BENCH_RUNS; run++)
+            {
+                const double secs = decode_once(&files[i], &outlen);
+                if (secs < 0.0)
+                {
+                    rc = 1;
+                    break;
+                } /* if */
+
+                if ((best < 0.0) || (secs < best))
+                    best = secs;
+            } /* for */
+
+            if ((rc == 0) && (best > 0.0))
+            {
+                printf("  %-40s %9.3f ms  %9.2f MB/s decoded  %8.2f MB/s in\n",
+                       files[i].fname, best * 1000.0,
+                       (((double) outlen) / (1024.0 * 1024.0)) / best,
+                       (((double) files[i].len) / (1024.0 * 1024.0)) / best);
+            } /* if */
+        } /* for */
+
+        Sound_Quit();
+    } /* for */
+
+    for (i = 0; i < total; i++)
+        free(files[i].data);
+    free(files);
+
+    SDL_Quit();
+    return rc;
+} /* main */
+
+/* end of bench_decoders.c ... */
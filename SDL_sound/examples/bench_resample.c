@@ -0,0 +1,226 @@
+/**
+ * SDL_sound; An abstract sound format decoding API.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+/**
+ * This compares the resampling modes (see Sound_SetResampleMode()) for
+ *  speed and quality. It resamples pure tones, generated in memory, and
+ *  reports the time taken and the signal-to-noise ratio of the result.
+ *  Anything the resampler adds that isn't the original tone (aliasing,
+ *  imaging, interpolation error) counts as noise.
+ *
+ * Usage: bench_resample [seconds] [runs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#define SDL_MAIN_HANDLED /* this is a console-only app */
+#endif
+#include "SDL.h"
+#include "SDL_sound.h"
+#include "bench_wav.h"
+
+#define BENCH_BUFFER_SIZE (64 * 1024)
+#define BENCH_PI 3.14159265358979323846
+
+static const struct { const char *name; Sound_ResampleMode mode; } modes[] =
+{
+    { "default", SOUND_RESAMPLE_DEFAULT },
+    { "linear ", SOUND_RESAMPLE_LINEAR },
+    { "sinc   ", SOUND_RESAMPLE_SINC }
+};
+
+static const struct { Uint32 src; Uint32 dst; double tone; } cases[] =
+{
+    { 44100, 48000, 1000.0 },
+    { 44100, 48000, 15000.0 },
+    { 48000, 44100, 1000.0 },
+    { 48000, 44100, 18000.0 },
+    { 22050, 48000, 8000.0 }
+};
+
+
+/* A stereo S16 .wav file in memory, the same tone in both channels. */
+static Uint8 *build_wav(Uint32 rate, double tone, Uint32 frames, Uint32 *len)
+{
+    const double tones[2] = { tone, tone };
+    return bench_build_wav(rate, 16, 2, frames, tones, 0.5, len);
+} /* build_wav */
+
+
+/*
+ * Fit a sine and cosine at (tone) to the left channel, so the resampler's
+ *  delay doesn't matter, and call whatever is left over noise. The first
+ *  and last bit of the output are skipped, since the filters ramp up there.
+ */
+static double signal_to_noise(const float *buf, Uint32 frames, Uint32 rate,
+                              double tone)
+{
+    const Uint32 skip = rate / 100;
+    double ss = 0.0, cc = 0.0, sc = 0.0, xs = 0.0, xc = 0.0;
+    double det, a, b;
+    double signal = 0.0, noise = 0.0;
+    Uint32 i;
+
+    if (frames <= skip * 2)
+        return 0.0;
+
+    for (i = skip; i < frames - skip; i++)
+    {
+        const double s = sin((2.0 * BENCH_PI * tone * i) / rate);
+        const double c = cos((2.0 * BENCH_PI * tone * i) / rate);
+        ss += s * s;
+        cc += c * c;
+        sc += s * c;
+        xs += buf[i * 2] * s;
+        xc += buf[i * 2] * c;
+    } /* for */
+
+    det = (ss * cc) - (sc * sc);
+    a = ((xs * cc) - (xc * sc)) / det;
+    b = ((xc * ss) - (xs * sc)) / det;
+
+    for (i = skip; i < frames - skip; i++)
+    {
+        const double s = sin((2.0 * BENCH_PI * tone * i) / rate);
+        const double c = cos((2.0 * BENCH_PI * tone * i) / rate);
+        const double fit = (a * s) + (b * c);
+        const double err = buf[i * 2] - fit;
+        signal += fit * fit;
+        noise += err * err;
+    } /* for */
+
+    return (noise > 0.0) ? (10.0 * log10(signal / noise)) : 999.0;
+} /* signal_to_noise */
+
+
+/* Returns elapsed seconds, or -1.0 on failure. */
+static double resample_once(Uint8 *wav, Uint32 wavlen, Uint32 rate,
+                            Sound_ResampleMode mode, double tone,
+                            double *snr)
+{
+    Sound_AudioInfo desired;
+    Sound_Sample *sample;
+    Uint64 start, end;
+    Uint32 len;
+
+    desired.format = AUDIO_F32SYS;
+    desired.channels = 2;
+    desired.rate = rate;
+
+    sample = Sound_NewSampleFromMem(wav, wavlen, "wav", &desired, BENCH_BUFFER_SIZE);
+    if (sample == NULL)
+    {
+        fprintf(stderr, "Couldn't load test data: %s\n", Sound_GetError());
+        return -1.0;
+    } /* if */
+
+    if (!Sound_SetResampleMode(sample, mode))
+    {
+        fprintf(stderr, "Couldn't set resample mode: %s\n", Sound_GetError());
+        Sound_FreeSample(sample);
+        return -1.0;
+    } /* if */
+
+    start = SDL_GetPerformanceCounter();
+    len = Sound_DecodeAll(sample);
+    end = SDL_GetPerformanceCounter();
+
+    if (sample->flags & SOUND_SAMPLEFLAG_ERROR)
+    {
+        fprintf(stderr, "Error decoding test data: %s\n", Sound_GetError());
+        Sound_FreeSample(sample);
+        return -1.0;
+    } /* if */
+
+    *snr = signal_to_noise((const float *) sample->buffer, len / 8, rate, tone);
+    Sound_FreeSample(sample);
+    return ((double) (end - start)) / ((double) SDL_GetPerformanceFrequency());
+} /* resample_once */
+
+
+int main(int argc, char **argv)
+{
+    const int seconds = (argc > 1) ? atoi(argv[1]) : 30;
+    int runs = (argc > 2) ? atoi(argv[2]) : 3;
+    int rc = 0;
+    size_t i, j;
+
+    if (runs < 1)
+        runs = 1;
+
+    if (SDL_Init(0) != 0)
+    {
+        fprintf(stderr, "SDL_Init() failed: %s\n", SDL_GetError());
+        return 1;
+    } /* if */
+
+    if (!Sound_Init())
+    {
+        fprintf(stderr, "Sound_Init() failed: %s\n", Sound_GetError());
+        SDL_Quit();
+        return 1;
+    } /* if */
+
+    printf("%d seconds of stereo audio, best of %d runs.\n", seconds, runs);
+
+    for (i = 0; (rc == 0) && (i < SDL_arraysize(cases)); i++)
+    {
+        const Uint32 frames = ((Uint32) ((seconds > 0) ? seconds : 1)) * cases[i].src;
+        Uint32 wavlen = 0;
+        Uint8 *wav = build_wav(cases[i].src, cases[i].tone, frames, &wavlen);
+
+        if (wav == NULL)
+        {
+            fprintf(stderr, "Out of memory!\n");
+            rc = 1;
+            break;
+        } /* if */
+
+        printf("%u Hz -> %u Hz, %g Hz tone:\n", (unsigned int) cases[i].src,
+               (unsigned int) cases[i].dst, cases[i].tone);
+
+        for (j = 0; (rc == 0) && (j < SDL_arraysize(modes)); j++)
+        {
+            double best = -1.0;
+            double snr = 0.0;
+            int run;
+
+            for (run = 0; run < runs; run++)
+            {
+                const double t = resample_once(wav, wavlen, cases[i].dst,
+                                               modes[j].mode, cases[i].tone,
+                                               &snr);
+                if (t < 0.0)
+                {
+                    rc = 1;
+                    break;
+                } /* if */
+
+                if ((best < 0.0) || (t < best))
+                    best = t;
+            } /* for */
+
+            if (rc == 0)
+            {
+                printf("  %s  %8.3f ms  (%6.1fx realtime)  SNR %6.1f dB\n",
+                       modes[j].name, best * 1000.0,
+                       (best > 0.0) ? (((double) seconds) / best) : 0.0, snr);
+            } /* if */
+        } /* for */
+
+        free(wav);
+    } /* for */
+
+    Sound_Quit();
+    SDL_Quit();
+    return rc;
+} /* main */
+
+/* end of bench_resample.c ... */
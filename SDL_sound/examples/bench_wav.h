@@ -0,0 +1,90 @@
+/**
+ * SDL_sound; An abstract sound format decoding API.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ */
+
+/**
+ * Test data for the benchmark programs: a PCM .wav file built in memory,
+ *  so they don't need any files. Include this after SDL.h.
+ */
+
+#ifndef _INCLUDE_BENCH_WAV_H_
+#define _INCLUDE_BENCH_WAV_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define BENCH_WAV_HEADER_SIZE 44
+
+static void bench_put16(Uint8 *ptr, Uint16 val)
+{
+    ptr[0] = (Uint8) (val & 0xFF);
+    ptr[1] = (Uint8) (val >> 8);
+} /* bench_put16 */
+
+
+static void bench_put32(Uint8 *ptr, Uint32 val)
+{
+    bench_put16(ptr, (Uint16) (val & 0xFFFF));
+    bench_put16(ptr + 2, (Uint16) (val >> 16));
+} /* bench_put32 */
+
+
+/*
+ * A U8 or S16 (bits is 8 or 16) .wav file in memory, with a sine wave of
+ *  (tones[ch]) Hz at (amplitude) in each channel. The sample data starts
+ *  BENCH_WAV_HEADER_SIZE bytes in. Returns NULL if out of memory; free()
+ *  the result.
+ */
+static Uint8 *bench_build_wav(Uint32 rate, Uint16 bits, Uint8 channels,
+                              Uint32 frames, const double *tones,
+                              double amplitude, Uint32 *len)
+{
+    const Uint32 bytes = bits / 8;
+    const Uint32 datalen = frames * bytes * channels;
+    Uint8 *retval = (Uint8 *) malloc(BENCH_WAV_HEADER_SIZE + datalen);
+    Uint8 *ptr;
+    Uint32 i;
+    int ch;
+
+    if (retval == NULL)
+        return NULL;
+
+    memcpy(retval, "RIFF", 4);
+    bench_put32(retval + 4, 36 + datalen);
+    memcpy(retval + 8, "WAVEfmt ", 8);
+    bench_put32(retval + 16, 16);
+    bench_put16(retval + 20, 1);  /* PCM */
+    bench_put16(retval + 22, channels);
+    bench_put32(retval + 24, rate);
+    bench_put32(retval + 28, rate * bytes * channels);
+    bench_put16(retval + 32, (Uint16) (bytes * channels));
+    bench_put16(retval + 34, bits);
+    memcpy(retval + 36, "data", 4);
+    bench_put32(retval + 40, datalen);
+
+    ptr = retval + BENCH_WAV_HEADER_SIZE;
+    for (i = 0; i < frames; i++)
+    {
+        for (ch = 0; ch < channels; ch++)
+        {
+            const double val = sin((6.283185307179586 * tones[ch] * i) / rate) * amplitude;
+            if (bits == 8)
+                *(ptr++) = (Uint8) ((int) (val * 127.0) + 128);
+            else
+            {
+                bench_put16(ptr, (Uint16) ((Sint16) (val * 32767.0)));
+                ptr += 2;
+            } /* else */
+        } /* for */
+    } /* for */
+
+    *len = BENCH_WAV_HEADER_SIZE + datalen;
+    return retval;
+} /* bench_build_wav */
+
+#endif  /* _INCLUDE_BENCH_WAV_H_ */
+
+/* end of bench_wav.h ... */
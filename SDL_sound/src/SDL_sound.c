@@ -13,6 +13,19 @@
  * Documentation is in SDL_sound.h ... It's verbose, honest.  :)
  */
 
+/* For mapping files into memory in Sound_NewSampleFromFile()...
+   (before SDL_sound_internal.h, so these don't get hidden visibility.) */
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define SOUND_HAVE_MMAP 1
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#define SOUND_HAVE_MMAP 0
+#endif
+
 #define __SDL_SOUND_INTERNAL__
 #include "SDL_sound_internal.h"
 
@@ -32,52 +45,178 @@ extern const Sound_DecoderFunctions __Sound_DecoderFunctions_SHN;
 extern const Sound_DecoderFunctions __Sound_DecoderFunctions_FLAC;
 extern const Sound_DecoderFunctions __Sound_DecoderFunctions_CoreAudio;
 
+/* Not a real decoder, and not in the table below. See SDL_sound_cache.c. */
+extern const Sound_DecoderFunctions __Sound_DecoderFunctions_CACHE;
+
+/*
+ * Signature probes. Before we start throwing a stream at every decoder's
+ *  open() method (which can mean a lot of reading, seeking and allocating
+ *  on a slow RWops), we read the first PROBE_WINDOW_SIZE bytes once and let
+ *  each decoder say how plausible it looks. These only have to be right
+ *  about PROBE_NO: if they say no, open() would have said no, too.
+ */
+#define PROBE_NO     0  /* this decoder will definitely reject the stream. */
+#define PROBE_MAYBE  1  /* can't tell from the header; let open() decide.  */
+#define PROBE_YES    2  /* signature matched, so try this decoder first.    */
+
+#define PROBE_WINDOW_SIZE 64
+
+typedef int (*probe_func)(const Uint8 *hdr, Uint32 len);
+
+static SDL_INLINE int probe_magic(const Uint8 *hdr, Uint32 len, Uint32 offset,
+                                  const char *magic)
+{
+    const Uint32 magiclen = (Uint32) SDL_strlen(magic);
+    return ( (len >= offset + magiclen) &&
+             (SDL_memcmp(hdr + offset, magic, magiclen) == 0) );
+} /* probe_magic */
+
+#if SOUND_SUPPORTS_MIDI
+static int probe_midi(const Uint8 *hdr, Uint32 len)
+{
+    if (probe_magic(hdr, len, 0, "MThd"))
+        return PROBE_YES;
+    else if (probe_magic(hdr, len, 0, "RIFF") && probe_magic(hdr, len, 8, "RMID"))
+        return PROBE_YES;
+    return PROBE_NO;
+} /* probe_midi */
+#endif
+
+#if SOUND_SUPPORTS_MODPLUG
+static int probe_modplug(const Uint8 *hdr, Uint32 len)
+{
+    return PROBE_NO;  /* MODPLUG_open() only goes by file extension. */
+} /* probe_modplug */
+#endif
+
+#if SOUND_SUPPORTS_MP3
+static int probe_mp3(const Uint8 *hdr, Uint32 len)
+{
+    if (probe_magic(hdr, len, 0, "ID3"))
+        return PROBE_YES;
+    else if ((len >= 2) && (hdr[0] == 0xFF) && ((hdr[1] & 0xE0) == 0xE0))
+        return PROBE_YES;  /* frame sync right at the start. */
+    return PROBE_MAYBE;  /* dr_mp3 will skip junk to find a sync word. */
+} /* probe_mp3 */
+#endif
+
+#if SOUND_SUPPORTS_WAV
+static int probe_wav(const Uint8 *hdr, Uint32 len)
+{
+    if (probe_magic(hdr, len, 0, "RIFF") && probe_magic(hdr, len, 8, "WAVE"))
+        return PROBE_YES;
+    return PROBE_NO;
+} /* probe_wav */
+#endif
+
+#if SOUND_SUPPORTS_AIFF
+static int probe_aiff(const Uint8 *hdr, Uint32 len)
+{
+    if (probe_magic(hdr, len, 0, "FORM") &&
+        (probe_magic(hdr, len, 8, "AIFF") || probe_magic(hdr, len, 8, "AIFC")))
+        return PROBE_YES;
+    return PROBE_NO;
+} /* probe_aiff */
+#endif
+
+#if SOUND_SUPPORTS_AU
+static int probe_au(const Uint8 *hdr, Uint32 len)
+{
+    /* headerless .au files are only accepted by extension. */
+    return probe_magic(hdr, len, 0, ".snd") ? PROBE_YES : PROBE_NO;
+} /* probe_au */
+#endif
+
+#if SOUND_SUPPORTS_VORBIS
+static int probe_vorbis(const Uint8 *hdr, Uint32 len)
+{
+    return probe_magic(hdr, len, 0, "OggS") ? PROBE_YES : PROBE_NO;
+} /* probe_vorbis */
+#endif
+
+#if SOUND_SUPPORTS_VOC
+static int probe_voc(const Uint8 *hdr, Uint32 len)
+{
+    if (probe_magic(hdr, len, 0, "Creative Voice File\032"))
+        return PROBE_YES;
+    return PROBE_NO;
+} /* probe_voc */
+#endif
+
+#if SOUND_SUPPORTS_RAW
+static int probe_raw(const Uint8 *hdr, Uint32 len)
+{
+    return PROBE_NO;  /* RAW_open() only goes by file extension. */
+} /* probe_raw */
+#endif
+
+#if SOUND_SUPPORTS_SHN
+static int probe_shn(const Uint8 *hdr, Uint32 len)
+{
+    /* SHN_open() only searches past offset zero for a ".shn" extension. */
+    return probe_magic(hdr, len, 0, "ajkg") ? PROBE_YES : PROBE_NO;
+} /* probe_shn */
+#endif
+
+#if SOUND_SUPPORTS_FLAC
+static int probe_flac(const Uint8 *hdr, Uint32 len)
+{
+    if (probe_magic(hdr, len, 0, "fLaC"))
+        return PROBE_YES;
+    else if (probe_magic(hdr, len, 0, "ID3") || probe_magic(hdr, len, 0, "OggS"))
+        return PROBE_MAYBE;  /* dr_flac skips ID3 tags and reads Ogg FLAC. */
+    return PROBE_NO;
+} /* probe_flac */
+#endif
+
+
 typedef struct
 {
     SDL_bool available;
     const Sound_DecoderFunctions *funcs;
+    probe_func probe;  /* NULL means always PROBE_MAYBE. */
 } decoder_element;
 
 static decoder_element decoders[] =
 {
 #if SOUND_SUPPORTS_MIDI
-    { 0, &__Sound_DecoderFunctions_MIDI },
+    { 0, &__Sound_DecoderFunctions_MIDI, probe_midi },
 #endif
 #if SOUND_SUPPORTS_MODPLUG
-    { 0, &__Sound_DecoderFunctions_MODPLUG },
+    { 0, &__Sound_DecoderFunctions_MODPLUG, probe_modplug },
 #endif
 #if SOUND_SUPPORTS_MP3
-    { 0, &__Sound_DecoderFunctions_MP3 },
+    { 0, &__Sound_DecoderFunctions_MP3, probe_mp3 },
 #endif
 #if SOUND_SUPPORTS_WAV
-    { 0, &__Sound_DecoderFunctions_WAV },
+    { 0, &__Sound_DecoderFunctions_WAV, probe_wav },
 #endif
 #if SOUND_SUPPORTS_AIFF
-    { 0, &__Sound_DecoderFunctions_AIFF },
+    { 0, &__Sound_DecoderFunctions_AIFF, probe_aiff },
 #endif
 #if SOUND_SUPPORTS_AU
-    { 0, &__Sound_DecoderFunctions_AU },
+    { 0, &__Sound_DecoderFunctions_AU, probe_au },
 #endif
 #if SOUND_SUPPORTS_VORBIS
-    { 0, &__Sound_DecoderFunctions_VORBIS },
+    { 0, &__Sound_DecoderFunctions_VORBIS, probe_vorbis },
 #endif
 #if SOUND_SUPPORTS_VOC
-    { 0, &__Sound_DecoderFunctions_VOC },
+    { 0, &__Sound_DecoderFunctions_VOC, probe_voc },
 #endif
 #if SOUND_SUPPORTS_RAW
-    { 0, &__Sound_DecoderFunctions_RAW },
+    { 0, &__Sound_DecoderFunctions_RAW, probe_raw },
 #endif
 #if SOUND_SUPPORTS_SHN
-    { 0, &__Sound_DecoderFunctions_SHN },
+    { 0, &__Sound_DecoderFunctions_SHN, probe_shn },
 #endif
 #if SOUND_SUPPORTS_FLAC
-    { 0, &__Sound_DecoderFunctions_FLAC },
+    { 0, &__Sound_DecoderFunctions_FLAC, probe_flac },
 #endif
 #if SOUND_SUPPORTS_COREAUDIO
-    { 0, &__Sound_DecoderFunctions_CoreAudio },
+    { 0, &__Sound_DecoderFunctions_CoreAudio, NULL },
 #endif
 
-    { 0, NULL }
+    { 0, NULL, NULL }
 };
 
 
@@ -98,6 +237,42 @@ static SDL_mutex *samplelist_mutex = NULL;
 static const Sound_DecoderInfo **available_decoders = NULL;
 static int initialized = 0;
 
+/* for Sound_SetStatsEnabled() and Sound_GetSampleStats(). */
+static int stats_enabled = 0;
+
+/* for Sound_SetMapFiles(). */
+static int map_files = 0;
+static Uint64 perf_frequency = 1;
+
+static Uint32 simd_flags = 0;  /* see __Sound_SIMDFlags(). */
+
+
+/* Pools of recycled sample allocations ... */
+
+typedef struct
+{
+    void *buffer;
+    Uint32 size;
+} PooledBuffer;
+
+typedef struct
+{
+    SDL_AudioStream *stream;
+    Sound_AudioInfo src;
+    Sound_AudioInfo dst;
+} PooledStream;
+
+#define DEFAULT_POOL_LIMITS { 64, 64, 256 * 1024, 16 }
+
+static Sound_PoolLimits pool_limits = DEFAULT_POOL_LIMITS;
+static Sound_PoolStats pool_stats;
+static SDL_mutex *pool_mutex = NULL;
+static Sound_Sample *pooled_samples = NULL;  /* linked through internal->next. */
+static PooledBuffer *pooled_buffers = NULL;
+static PooledStream *pooled_streams = NULL;
+static Uint32 pooled_buffers_allocated = 0;
+static Uint32 pooled_streams_allocated = 0;
+
 
 /* functions ... */
 
@@ -112,6 +287,367 @@ void Sound_GetLinkedVersion(Sound_Version *ver)
 } /* Sound_GetLinkedVersion */
 
 
+/* Free pooled items until each pool fits in the given limit. */
+static void trim_pools(Uint32 max_samples, Uint32 max_buffers,
+                       Uint32 max_streams)
+{
+    SDL_LockMutex(pool_mutex);
+
+    while (pool_stats.pooled_samples > max_samples)
+    {
+        Sound_Sample *sample = pooled_samples;
+        Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+        pooled_samples = internal->next;
+        pool_stats.pooled_samples--;
+        SDL_free(internal);
+        SDL_free(sample);
+    } /* while */
+
+    while (pool_stats.pooled_buffers > max_buffers)
+    {
+        pool_stats.pooled_buffers--;
+        __Sound_SIMDFree(pooled_buffers[pool_stats.pooled_buffers].buffer);
+    } /* while */
+
+    while (pool_stats.pooled_streams > max_streams)
+    {
+        pool_stats.pooled_streams--;
+        SDL_FreeAudioStream(pooled_streams[pool_stats.pooled_streams].stream);
+    } /* while */
+
+    SDL_UnlockMutex(pool_mutex);
+} /* trim_pools */
+
+
+/* Returns a zeroed Sound_Sample with its internal struct attached, or NULL. */
+static Sound_Sample *pool_get_sample(void)
+{
+    Sound_Sample *retval;
+    Sound_SampleInternal *internal;
+
+    SDL_LockMutex(pool_mutex);
+    retval = pooled_samples;
+    if (retval == NULL)
+        pool_stats.sample_misses++;
+    else
+    {
+        internal = (Sound_SampleInternal *) retval->opaque;
+        pooled_samples = internal->next;
+        pool_stats.pooled_samples--;
+        pool_stats.sample_hits++;
+    } /* else */
+    SDL_UnlockMutex(pool_mutex);
+
+    if (retval != NULL)
+    {
+        SDL_zerop(internal);
+        SDL_zerop(retval);
+        retval->opaque = internal;
+    } /* if */
+
+    return retval;
+} /* pool_get_sample */
+
+
+static void pool_put_sample(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+
+    SDL_LockMutex(pool_mutex);
+    if (pool_stats.pooled_samples < pool_limits.max_samples)
+    {
+        internal->next = pooled_samples;
+        pooled_samples = sample;
+        pool_stats.pooled_samples++;
+        sample = NULL;
+    } /* if */
+    SDL_UnlockMutex(pool_mutex);
+
+    if (sample != NULL)  /* pool is full. */
+    {
+        SDL_free(internal);
+        SDL_free(sample);
+    } /* if */
+} /* pool_put_sample */
+
+
+/*
+ * Returns a recycled decode buffer of exactly (size) bytes, or NULL. These
+ *  are NOT cleared; nothing reads a decode buffer before a decoder fills it.
+ */
+static void *pool_get_buffer(Uint32 size)
+{
+    void *retval = NULL;
+    Uint32 i;
+
+    SDL_LockMutex(pool_mutex);
+    for (i = 0; i < pool_stats.pooled_buffers; i++)
+    {
+        if (pooled_buffers[i].size == size)
+        {
+            retval = pooled_buffers[i].buffer;
+            pool_stats.pooled_buffers--;
+            pooled_buffers[i] = pooled_buffers[pool_stats.pooled_buffers];
+            break;
+        } /* if */
+    } /* for */
+
+    if (retval != NULL)
+        pool_stats.buffer_hits++;
+    else
+        pool_stats.buffer_misses++;
+    SDL_UnlockMutex(pool_mutex);
+
+    return retval;
+} /* pool_get_buffer */
+
+
+static void pool_put_buffer(void *buffer, Uint32 size)
+{
+    SDL_LockMutex(pool_mutex);
+    if ( (buffer != NULL) && (size <= pool_limits.max_buffer_size) &&
+         (pool_stats.pooled_buffers < pool_limits.max_buffers) )
+    {
+        if (pool_stats.pooled_buffers >= pooled_buffers_allocated)
+        {
+            const Uint32 newlen = pool_limits.max_buffers;
+            void *ptr = SDL_realloc(pooled_buffers, newlen * sizeof (PooledBuffer));
+            if (ptr != NULL)
+            {
+                pooled_buffers = (PooledBuffer *) ptr;
+                pooled_buffers_allocated = newlen;
+            } /* if */
+        } /* if */
+
+        if (pool_stats.pooled_buffers < pooled_buffers_allocated)
+        {
+            pooled_buffers[pool_stats.pooled_buffers].buffer = buffer;
+            pooled_buffers[pool_stats.pooled_buffers].size = size;
+            pool_stats.pooled_buffers++;
+            buffer = NULL;
+        } /* if */
+    } /* if */
+    SDL_UnlockMutex(pool_mutex);
+
+    if (buffer != NULL)  /* too big, or pool is full. */
+        __Sound_SIMDFree(buffer);
+} /* pool_put_buffer */
+
+
+static SDL_INLINE int audioinfo_equal(const Sound_AudioInfo *a,
+                                      const Sound_AudioInfo *b)
+{
+    return ( (a->format == b->format) &&
+             (a->channels == b->channels) &&
+             (a->rate == b->rate) );
+} /* audioinfo_equal */
+
+
+/* Returns an empty stream that converts (src) to (dst), or NULL. */
+static SDL_AudioStream *pool_get_stream(const Sound_AudioInfo *src,
+                                        const Sound_AudioInfo *dst)
+{
+    SDL_AudioStream *retval = NULL;
+    Uint32 i;
+
+    SDL_LockMutex(pool_mutex);
+    for (i = 0; i < pool_stats.pooled_streams; i++)
+    {
+        if ( audioinfo_equal(&pooled_streams[i].src, src) &&
+             audioinfo_equal(&pooled_streams[i].dst, dst) )
+        {
+            retval = pooled_streams[i].stream;
+            pool_stats.pooled_streams--;
+            pooled_streams[i] = pooled_streams[pool_stats.pooled_streams];
+            break;
+        } /* if */
+    } /* for */
+
+    if (retval != NULL)
+        pool_stats.stream_hits++;
+    else
+        pool_stats.stream_misses++;
+    SDL_UnlockMutex(pool_mutex);
+
+    return retval;
+} /* pool_get_stream */
+
+
+static void pool_put_stream(SDL_AudioStream *stream,
+                            const Sound_AudioInfo *src,
+                            const Sound_AudioInfo *dst)
+{
+    if (stream == NULL)
+        return;
+
+    SDL_AudioStreamClear(stream);
+
+    SDL_LockMutex(pool_mutex);
+    if (pool_stats.pooled_streams < pool_limits.max_streams)
+    {
+        if (pool_stats.pooled_streams >= pooled_streams_allocated)
+        {
+            const Uint32 newlen = pool_limits.max_streams;
+            void *ptr = SDL_realloc(pooled_streams, newlen * sizeof (PooledStream));
+            if (ptr != NULL)
+            {
+                pooled_streams = (PooledStream *) ptr;
+                pooled_streams_allocated = newlen;
+            } /* if */
+        } /* if */
+
+        if (pool_stats.pooled_streams < pooled_streams_allocated)
+        {
+            PooledStream *item = &pooled_streams[pool_stats.pooled_streams];
+            item->stream = stream;
+            SDL_memcpy(&item->src, src, sizeof (Sound_AudioInfo));
+            SDL_memcpy(&item->dst, dst, sizeof (Sound_AudioInfo));
+            pool_stats.pooled_streams++;
+            stream = NULL;
+        } /* if */
+    } /* if */
+    SDL_UnlockMutex(pool_mutex);
+
+    if (stream != NULL)  /* pool is full. */
+        SDL_FreeAudioStream(stream);
+} /* pool_put_stream */
+
+
+/* Give the sample its own sample->buffer back, if it's the cached copy. */
+static void unshare_buffer(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+
+    if (internal->private_buffer != NULL)
+    {
+        sample->buffer = internal->private_buffer;
+        sample->buffer_size = internal->private_buffer_size;
+        internal->private_buffer = NULL;
+        internal->private_buffer_size = 0;
+    } /* if */
+} /* unshare_buffer */
+
+
+/* Drop whatever converts the decoder's output to the desired format. */
+static void teardown_conversion(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+
+    pool_put_stream(internal->stream, &sample->actual, &sample->desired);
+    internal->stream = NULL;
+
+    __Sound_DestroyResampler(internal->resampler);
+    internal->resampler = NULL;
+
+    SDL_zero(internal->converter);
+
+    /* converting samples have a separate buffer for the decoder. */
+    if ((internal->buffer != NULL) && (internal->buffer != sample->buffer))
+        pool_put_buffer(internal->buffer, internal->buffer_size);
+    internal->buffer = NULL;
+} /* teardown_conversion */
+
+
+/* Hand everything a sample owns (except the decoder's state) to the pools. */
+static void release_sample(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+
+    if (internal != NULL)
+    {
+        unshare_buffer(sample);
+        teardown_conversion(sample);
+    } /* if */
+
+    pool_put_buffer(sample->buffer, sample->buffer_size);
+    sample->buffer = NULL;
+
+    if (internal != NULL)
+    {
+        __Sound_CacheRelease(internal->cache_entry);
+        __Sound_DestroyCacheKey(internal->cache_key);
+        internal->cache_entry = NULL;
+        internal->cache_key = NULL;
+        pool_put_sample(sample);
+    } /* if */
+    else
+    {
+        SDL_free(sample);
+    } /* else */
+} /* release_sample */
+
+
+void Sound_SetPoolLimits(const Sound_PoolLimits *limits)
+{
+    static const Sound_PoolLimits default_limits = DEFAULT_POOL_LIMITS;
+
+    SDL_LockMutex(pool_mutex);
+    if (limits == NULL)
+        limits = &default_limits;
+    SDL_memcpy(&pool_limits, limits, sizeof (Sound_PoolLimits));
+    SDL_UnlockMutex(pool_mutex);
+
+    /* buffers over the new size limit will just sit there until reused, but
+       the next pool_put_buffer() of that size will free it. Fine. */
+    trim_pools(limits->max_samples, limits->max_buffers, limits->max_streams);
+} /* Sound_SetPoolLimits */
+
+
+void Sound_GetPoolLimits(Sound_PoolLimits *limits)
+{
+    if (limits != NULL)
+    {
+        SDL_LockMutex(pool_mutex);
+        SDL_memcpy(limits, &pool_limits, sizeof (Sound_PoolLimits));
+        SDL_UnlockMutex(pool_mutex);
+    } /* if */
+} /* Sound_GetPoolLimits */
+
+
+void Sound_GetPoolStats(Sound_PoolStats *stats)
+{
+    if (stats != NULL)
+    {
+        SDL_LockMutex(pool_mutex);
+        SDL_memcpy(stats, &pool_stats, sizeof (Sound_PoolStats));
+        SDL_UnlockMutex(pool_mutex);
+    } /* if */
+} /* Sound_GetPoolStats */
+
+
+/*
+ * What SDL says the CPU has, limited by the SDL_SOUND_SIMD environment
+ *  variable: "none", "sse2", "sse41" or "neon" is the most the decoders and
+ *  converters may use. This is mostly for benchmarking and chasing bugs.
+ */
+static Uint32 detect_simd(void)
+{
+    const char *env = SDL_getenv("SDL_SOUND_SIMD");
+    Uint32 allowed = SOUND_SIMD_SSE2 | SOUND_SIMD_SSE41 | SOUND_SIMD_NEON;
+    Uint32 retval = 0;
+
+    if (SDL_HasSSE2())
+        retval |= SOUND_SIMD_SSE2;
+    if (SDL_HasSSE41())
+        retval |= SOUND_SIMD_SSE41;
+    if (SDL_HasNEON())
+        retval |= SOUND_SIMD_NEON;
+
+    if (env == NULL)
+        return retval;
+    else if (SDL_strcasecmp(env, "none") == 0)
+        allowed = 0;
+    else if (SDL_strcasecmp(env, "sse2") == 0)
+        allowed = SOUND_SIMD_SSE2;
+    else if (SDL_strcasecmp(env, "sse41") == 0)
+        allowed = SOUND_SIMD_SSE2 | SOUND_SIMD_SSE41;
+    else if (SDL_strcasecmp(env, "neon") == 0)
+        allowed = SOUND_SIMD_NEON;
+
+    return retval & allowed;
+} /* detect_simd */
+
+
 int Sound_Init(void)
 {
     size_t i;
@@ -130,6 +666,11 @@ int Sound_Init(void)
     tlsid_errmsg = SDL_TLSCreate();
 
     samplelist_mutex = SDL_CreateMutex();
+    pool_mutex = SDL_CreateMutex();
+    SDL_zero(pool_stats);
+    __Sound_InitCache();
+    perf_frequency = SDL_GetPerformanceFrequency();
+    simd_flags = detect_simd();  /* before the decoders' init() methods run. */
 
     for (i = 0; decoders[i].funcs != NULL; i++)
     {
@@ -161,6 +702,17 @@ int Sound_Quit(void)
     samplelist_mutex = NULL;
     sample_list = NULL;
 
+    trim_pools(0, 0, 0);
+    SDL_free(pooled_buffers);
+    SDL_free(pooled_streams);
+    pooled_buffers = NULL;
+    pooled_streams = NULL;
+    pooled_buffers_allocated = pooled_streams_allocated = 0;
+    SDL_DestroyMutex(pool_mutex);
+    pool_mutex = NULL;
+
+    __Sound_QuitCache();
+
     for (i = 0; decoders[i].funcs != NULL; i++)
     {
         if (decoders[i].available)
@@ -247,16 +799,37 @@ void __Sound_SetError(const char *str)
 } /* __Sound_SetError */
 
 
-Uint32 __Sound_convertMsToBytePos(Sound_AudioInfo *info, Uint32 ms)
+Uint64 __Sound_convertMsToFrames(Uint32 rate, Uint32 ms)
 {
     /* "frames" == "sample frames" */
-    float frames_per_ms = ((float) info->rate) / 1000.0f;
-    Uint32 frame_offset = (Uint32) (frames_per_ms * ((float) ms));
-    Uint32 frame_size = (Uint32) ((info->format & 0xFF) / 8) * info->channels;
-    return frame_offset * frame_size;
+    return (((Uint64) ms) * rate) / 1000;
+} /* __Sound_convertMsToFrames */
+
+
+Uint32 __Sound_convertMsToBytePos(Sound_AudioInfo *info, Uint32 ms)
+{
+    const Uint64 frame_offset = __Sound_convertMsToFrames(info->rate, ms);
+    const Uint32 frame_size = (Uint32) ((info->format & 0xFF) / 8) * info->channels;
+    return (Uint32) (frame_offset * frame_size);
 } /* __Sound_convertMsToBytePos */
 
 
+/* For Sound_GetSampleStats(): a timestamp, if we're collecting stats. */
+static SDL_INLINE Uint64 stats_clock(const Sound_SampleInternal *internal)
+{
+    return internal->collect_stats ? SDL_GetPerformanceCounter() : 0;
+} /* stats_clock */
+
+
+/* For Sound_GetSampleStats(): add the time since (start) to (*ticks). */
+static SDL_INLINE void stats_elapsed(const Sound_SampleInternal *internal,
+                                     Uint64 *ticks, const Uint64 start)
+{
+    if (internal->collect_stats)
+        *ticks += SDL_GetPerformanceCounter() - start;
+} /* stats_elapsed */
+
+
 /*
  * Allocate a Sound_Sample, and fill in most of its fields. Those that need
  *  to be filled in later, by a decoder, will be initialized to zero.
@@ -264,51 +837,110 @@ Uint32 __Sound_convertMsToBytePos(Sound_AudioInfo *info, Uint32 ms)
 static Sound_Sample *alloc_sample(SDL_RWops *rw, Sound_AudioInfo *desired,
                                     Uint32 bufferSize)
 {
-    /*
-     * !!! FIXME: We're going to need to pool samples, since the mixer
-     * !!! FIXME:  might be allocating tons of these on a regular basis.
-     */
-    Sound_Sample *retval = SDL_calloc(1, sizeof (Sound_Sample));
-    Sound_SampleInternal *internal = SDL_calloc(1, sizeof (Sound_SampleInternal));
-    if ((retval == NULL) || (internal == NULL))
+    Sound_Sample *retval = pool_get_sample();
+    Sound_SampleInternal *internal = NULL;
+
+    if (retval != NULL)
+        internal = (Sound_SampleInternal *) retval->opaque;
+    else
     {
-        __Sound_SetError(ERR_OUT_OF_MEMORY);
-        if (retval)
-            SDL_free(retval);
-        if (internal)
-            SDL_free(internal);
+        retval = SDL_calloc(1, sizeof (Sound_Sample));
+        internal = SDL_calloc(1, sizeof (Sound_SampleInternal));
+        if ((retval == NULL) || (internal == NULL))
+        {
+            __Sound_SetError(ERR_OUT_OF_MEMORY);
+            if (retval)
+                SDL_free(retval);
+            if (internal)
+                SDL_free(internal);
 
-        return NULL;
-    } /* if */
+            return NULL;
+        } /* if */
+        retval->opaque = internal;
+    } /* else */
 
     SDL_assert(bufferSize > 0);
 
-    retval->buffer = __Sound_SIMDAlloc(bufferSize);
+    retval->buffer = pool_get_buffer(bufferSize);
     if (!retval->buffer)
     {
-        __Sound_SetError(ERR_OUT_OF_MEMORY);
-        SDL_free(internal);
-        SDL_free(retval);
-        return NULL;
+        retval->buffer = __Sound_SIMDAlloc(bufferSize);
+        if (!retval->buffer)
+        {
+            __Sound_SetError(ERR_OUT_OF_MEMORY);
+            release_sample(retval);
+            return NULL;
+        } /* if */
+        SDL_memset(retval->buffer, '\0', bufferSize);
     } /* if */
-    SDL_memset(retval->buffer, '\0', bufferSize);
     retval->buffer_size = bufferSize;
 
     if (desired != NULL)
         SDL_memcpy(&retval->desired, desired, sizeof (Sound_AudioInfo));
 
     internal->rw = rw;
-    retval->opaque = internal;
+    internal->collect_stats = stats_enabled ? SDL_TRUE : SDL_FALSE;
     return retval;
 } /* alloc_sample */
 
 
-#if (defined DEBUG_CHATTER)
-static SDL_INLINE const char *fmt_to_str(Uint16 fmt)
+/*
+ * Point the decoder at the buffer it should fill. That's the app's buffer,
+ *  unless we convert without an SDL_AudioStream, in which case the decoder
+ *  gets scratch space: enough to fill sample->buffer after conversion, or
+ *  one chunk of resampler input.
+ */
+static int sync_decode_buffer(Sound_Sample *sample)
 {
-    switch(fmt) {
-        case AUDIO_U8:
-            return "U8";
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Sound_Converter *cvt = &internal->converter;
+    Uint32 frames;
+    Uint32 size;
+    void *scratch;
+
+    if (internal->resampler != NULL)
+    {
+        size = SOUND_RESAMPLE_CHUNK_FRAMES * sample->actual.channels *
+               (SDL_AUDIO_BITSIZE(sample->actual.format) / 8);
+    } /* if */
+
+    else if (cvt->func != NULL)
+    {
+        frames = sample->buffer_size / cvt->dst_framesize;
+        size = (frames ? frames : 1) * cvt->src_framesize;
+    } /* else if */
+
+    else
+    {
+        internal->buffer = sample->buffer;
+        internal->buffer_size = sample->buffer_size;
+        return 1;
+    } /* else */
+
+    if ( (internal->buffer != NULL) && (internal->buffer != sample->buffer) &&
+         (internal->buffer_size == size) )
+        return 1;  /* already have the right thing. */
+
+    scratch = pool_get_buffer(size);
+    if (scratch == NULL)
+        scratch = __Sound_SIMDAlloc(size);
+    BAIL_IF_MACRO(scratch == NULL, ERR_OUT_OF_MEMORY, 0);
+
+    if ((internal->buffer != NULL) && (internal->buffer != sample->buffer))
+        pool_put_buffer(internal->buffer, internal->buffer_size);
+
+    internal->buffer = scratch;
+    internal->buffer_size = size;
+    return 1;
+} /* sync_decode_buffer */
+
+
+#if (defined DEBUG_CHATTER)
+static SDL_INLINE const char *fmt_to_str(Uint16 fmt)
+{
+    switch(fmt) {
+        case AUDIO_U8:
+            return "U8";
         case AUDIO_S8:
             return "S8";
         case AUDIO_U16LSB:
@@ -333,6 +965,62 @@ static SDL_INLINE const char *fmt_to_str(Uint16 fmt)
 #endif
 
 
+/*
+ * Set up whatever converts the decoder's output to sample->desired, given
+ *  sample->actual and the sample's resample mode. If the rate doesn't
+ *  change, we can usually convert in one pass ourselves, and only need
+ *  something else for resampling. On failure, the error is set and the
+ *  sample has no conversion at all.
+ */
+static int setup_conversion(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Sound_AudioInfo *actual = &sample->actual;
+    Sound_AudioInfo *desired = &sample->desired;
+
+    internal->stream = NULL;
+    internal->resampler = NULL;
+    SDL_zero(internal->converter);
+    internal->buffer = NULL;
+
+    if (internal->resample_mode == SOUND_RESAMPLE_NONE)
+        desired->rate = actual->rate;
+    else
+        desired->rate = internal->requested_rate;
+
+    if ( (!audioinfo_equal(actual, desired)) &&
+         (!__Sound_SetupConverter(&internal->converter, actual, desired)) )
+    {
+        internal->resampler = __Sound_CreateResampler(internal->resample_mode,
+                                                      actual, desired);
+        if (internal->resampler == NULL)
+        {
+            internal->stream = pool_get_stream(actual, desired);
+            if (internal->stream == NULL)
+            {
+                internal->stream = SDL_NewAudioStream(actual->format,
+                                                      actual->channels,
+                                                      actual->rate,
+                                                      desired->format,
+                                                      desired->channels,
+                                                      desired->rate);
+            } /* if */
+
+            BAIL_IF_MACRO(internal->stream == NULL, SDL_GetError(), 0);
+        } /* if */
+    } /* if */
+
+        /* these pointers are all one and the same, unless we're converting. */
+    if (!sync_decode_buffer(sample))
+    {
+        teardown_conversion(sample);
+        return 0;
+    } /* if */
+
+    return 1;
+} /* setup_conversion */
+
+
 /*
  * The bulk of the Sound_NewSample() work is done here...
  *  Ask the specified decoder to handle the data in (rw), and if
@@ -346,11 +1034,18 @@ static int init_sample(const Sound_DecoderFunctions *funcs,
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     Sound_AudioInfo desired;
     const Sint64 pos = SDL_RWtell(internal->rw);
+    const Uint64 start = stats_clock(internal);
+    int rc;
 
         /* fill in the funcs for this decoder... */
     sample->decoder = &funcs->info;
     internal->funcs = funcs;
-    if (!funcs->open(sample, ext))
+    internal->fast_seek_frame = SDL_FALSE;
+    rc = funcs->open(sample, ext);
+    stats_elapsed(internal, &internal->stats.open_ns, start);
+    if (internal->collect_stats)
+        internal->stats.open_attempts++;
+    if (!rc)
     {
         SDL_RWseek(internal->rw, pos, RW_SEEK_SET);     /* set for next try... */
         return 0;
@@ -358,9 +1053,6 @@ static int init_sample(const Sound_DecoderFunctions *funcs,
 
     /* success; we've got a decoder! */
 
-    /* Now we need to set up an audio stream for data conversion if necessary... */
-    internal->stream = NULL;
-
     if (_desired == NULL)
         SDL_memcpy(&desired, &sample->actual, sizeof (Sound_AudioInfo));
     else
@@ -368,32 +1060,19 @@ static int init_sample(const Sound_DecoderFunctions *funcs,
         desired.format = _desired->format ? _desired->format : sample->actual.format;
         desired.channels = _desired->channels ? _desired->channels : sample->actual.channels;
         desired.rate = _desired->rate ? _desired->rate : sample->actual.rate;
-
-        if ( (sample->actual.format != desired.format) ||
-             (sample->actual.channels != desired.channels) ||
-             (sample->actual.rate != desired.rate) )
-        {
-            internal->stream = SDL_NewAudioStream(sample->actual.format,
-                                                  sample->actual.channels,
-                                                  sample->actual.rate,
-                                                  desired.format,
-                                                  desired.channels,
-                                                  desired.rate);
-
-            if (internal->stream == NULL)
-            {
-                __Sound_SetError(SDL_GetError());
-                funcs->close(sample);
-                SDL_RWseek(internal->rw, pos, RW_SEEK_SET);     /* set for next try... */
-                return 0;
-            } /* if */
-        } /* if */
     } /* else */
 
-        /* these pointers are all one and the same. */
     SDL_memcpy(&sample->desired, &desired, sizeof (Sound_AudioInfo));
-    internal->buffer = sample->buffer;
-    internal->buffer_size = sample->buffer_size;
+    internal->requested_rate = desired.rate;
+    internal->resample_mode = SOUND_RESAMPLE_DEFAULT;
+
+    /* Now we need to set up data conversion if necessary... */
+    if (!setup_conversion(sample))
+    {
+        funcs->close(sample);
+        SDL_RWseek(internal->rw, pos, RW_SEEK_SET);     /* set for next try... */
+        return 0;
+    } /* if */
 
     /* Prepend our new Sound_Sample to the sample_list... */
     SDL_LockMutex(samplelist_mutex);
@@ -414,17 +1093,47 @@ static int init_sample(const Sound_DecoderFunctions *funcs,
             sample->actual.channels));
 
     SNDDBG(("On-the-fly conversion: %s.\n",
-            (internal->stream != NULL) ? "ENABLED" : "DISABLED"));
+            (internal->stream != NULL) ? "ENABLED" :
+            (internal->resampler != NULL) ? "ENABLED (SDL_sound resampler)" :
+            (internal->converter.func != NULL) ? "ENABLED (no resampling)" :
+            "DISABLED"));
 
     return 1;
 } /* init_sample */
 
 
+/*
+ * Read the start of the stream for the signature probes, and put the RWops
+ *  back where it was. Returns zero if we couldn't, in which case every
+ *  decoder is treated as PROBE_MAYBE, same as before we had probes.
+ */
+static int read_probe_window(SDL_RWops *rw, Uint8 *header, Uint32 *len)
+{
+    const Sint64 pos = SDL_RWtell(rw);
+    size_t br;
+
+    *len = 0;
+    if (pos < 0)
+        return 0;
+
+    br = SDL_RWread(rw, header, 1, PROBE_WINDOW_SIZE);
+    if (SDL_RWseek(rw, pos, RW_SEEK_SET) != pos)
+        return 0;
+
+    *len = (Uint32) br;
+    return 1;
+} /* read_probe_window */
+
+
 Sound_Sample *Sound_NewSample(SDL_RWops *rw, const char *ext,
                               Sound_AudioInfo *desired, Uint32 bSize)
 {
     Sound_Sample *retval;
     decoder_element *decoder;
+    Uint8 header[PROBE_WINDOW_SIZE];
+    Uint32 headerlen = 0;
+    int probed;
+    int score;
 
     /* sanity checks. */
     BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, NULL);
@@ -455,53 +1164,163 @@ Sound_Sample *Sound_NewSample(SDL_RWops *rw, const char *ext,
         } /* for */
     } /* if */
 
-    /* no direct extension match? Try everything we've got... */
-    for (decoder = &decoders[0]; decoder->funcs != NULL; decoder++)
+    /* no direct extension match? Sniff the header once, then try the
+       decoders whose signatures matched, then the ones that can't tell. */
+    probed = read_probe_window(rw, header, &headerlen);
+    for (score = PROBE_YES; score > PROBE_NO; score--)
     {
-        if (decoder->available)
+        for (decoder = &decoders[0]; decoder->funcs != NULL; decoder++)
         {
-            int should_try = 1;
-            const char **decoderExt = decoder->funcs->info.extensions;
-
-                /* skip if we would have tried decoder above... */
-            while (*decoderExt)
+            if (decoder->available)
             {
-                if (ext && SDL_strcasecmp(*decoderExt, ext) == 0)
+                int should_try = 1;
+                const char **decoderExt = decoder->funcs->info.extensions;
+
+                    /* skip if we would have tried decoder above... */
+                while (*decoderExt)
                 {
-                    should_try = 0;
-                    break;
-                } /* if */
-                decoderExt++;
-            } /* while */
+                    if (ext && SDL_strcasecmp(*decoderExt, ext) == 0)
+                    {
+                        should_try = 0;
+                        break;
+                    } /* if */
+                    decoderExt++;
+                } /* while */
 
-            if (should_try)
-            {
-                if (init_sample(decoder->funcs, retval, ext, desired))
-                    return retval;
+                if ((should_try) && (probed) && (decoder->probe != NULL))
+                    should_try = (decoder->probe(header, headerlen) == score);
+                else if (should_try)
+                    should_try = (score == PROBE_MAYBE);
+
+                if (should_try)
+                {
+                    if (init_sample(decoder->funcs, retval, ext, desired))
+                        return retval;
+                } /* if */
             } /* if */
-        } /* if */
+        } /* for */
     } /* for */
 
     /* nothing could handle the sound data... */
-    /* !!! FIXME: can we just push this through Sound_FreeSample() ? */
-    if (retval->opaque != NULL)
-    {
-        SDL_FreeAudioStream(((Sound_SampleInternal *) retval->opaque)->stream);
-        SDL_free(retval->opaque);
-    } /* if */
-
-    __Sound_SIMDFree(retval->buffer);
-    SDL_free(retval);
+    release_sample(retval);
     SDL_RWclose(rw);
     __Sound_SetError(ERR_UNSUPPORTED_FORMAT);
     return NULL;
 } /* Sound_NewSample */
 
 
+/*
+ * Make a new sample that reads (entry), which was decoded in the same
+ *  format we want. This takes over the caller's reference to (entry).
+ */
+static Sound_Sample *new_cached_sample(Sound_CacheEntry *entry,
+                                       Sound_AudioInfo *desired,
+                                       Uint32 bufferSize)
+{
+    Sound_Sample *retval;
+    SDL_RWops *rw;
+    Uint32 len;
+    const Uint8 *data = __Sound_CacheData(entry, &len, NULL);
+
+    rw = SDL_RWFromConstMem(data, len);
+    if (rw == NULL)
+    {
+        __Sound_CacheRelease(entry);
+        BAIL_MACRO(SDL_GetError(), NULL);
+    } /* if */
+
+    retval = alloc_sample(rw, desired, bufferSize);
+    if (retval == NULL)
+    {
+        __Sound_CacheRelease(entry);
+        SDL_RWclose(rw);
+        return NULL;  /* alloc_sample() sets error message... */
+    } /* if */
+
+    ((Sound_SampleInternal *) retval->opaque)->cache_entry = entry;
+    if (!init_sample(&__Sound_DecoderFunctions_CACHE, retval, NULL, desired))
+    {
+        release_sample(retval);  /* this releases (entry), too. */
+        SDL_RWclose(rw);
+        return NULL;
+    } /* if */
+
+    return retval;
+} /* new_cached_sample */
+
+
+#if SOUND_HAVE_MMAP
+static int SDLCALL mapped_close(SDL_RWops *rw)
+{
+    if (rw != NULL)
+    {
+        munmap(rw->hidden.mem.base, (size_t) (rw->hidden.mem.stop - rw->hidden.mem.base));
+        SDL_FreeRW(rw);
+    } /* if */
+    return 0;
+} /* mapped_close */
+#endif
+
+
+/*
+ * If the app turned on Sound_SetMapFiles(), map (fname) into memory and wrap
+ *  that in a read-only memory RWops, so decoders that can work straight from
+ *  memory (see __Sound_RWopsMemory()) never read the file at all, and the
+ *  rest read it with a memcpy(). Otherwise, or if the file can't be mapped,
+ *  it's just SDL_RWFromFile().
+ */
+static SDL_RWops *open_file(const char *fname)
+{
+#if SOUND_HAVE_MMAP
+    const int fd = map_files ? open(fname, O_RDONLY) : -1;
+    if (fd != -1)
+    {
+        SDL_RWops *rw = NULL;
+        struct stat statbuf;
+
+        /* SDL_RWFromConstMem() takes an int, and won't do empty files. */
+        if ((fstat(fd, &statbuf) == 0) && (S_ISREG(statbuf.st_mode)) &&
+            (statbuf.st_size > 0) && (statbuf.st_size <= 0x7FFFFFFF))
+        {
+            const size_t len = (size_t) statbuf.st_size;
+            void *ptr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr != MAP_FAILED)
+            {
+                rw = SDL_RWFromConstMem(ptr, (int) len);
+                if (rw == NULL)
+                    munmap(ptr, len);
+                else
+                    rw->close = mapped_close;
+            } /* if */
+        } /* if */
+
+        close(fd);  /* the mapping keeps the file alive. */
+        if (rw != NULL)
+            return rw;
+    } /* if */
+#endif
+
+    return SDL_RWFromFile(fname, "rb");
+} /* open_file */
+
+
+const Uint8 *__Sound_RWopsMemory(SDL_RWops *rw, size_t *len)
+{
+    if ((rw->type != SDL_RWOPS_MEMORY) && (rw->type != SDL_RWOPS_MEMORY_RO))
+        return NULL;
+
+    *len = (size_t) (rw->hidden.mem.stop - rw->hidden.mem.here);
+    return rw->hidden.mem.here;
+} /* __Sound_RWopsMemory */
+
+
 Sound_Sample *Sound_NewSampleFromFile(const char *filename,
                                       Sound_AudioInfo *desired,
                                       Uint32 bufferSize)
 {
+    Sound_Sample *retval;
+    Sound_CacheKey *key;
+    Sound_CacheEntry *entry;
     const char *ext;
     SDL_RWops *rw;
 
@@ -509,13 +1328,35 @@ Sound_Sample *Sound_NewSampleFromFile(const char *filename,
     BAIL_IF_MACRO(filename == NULL, ERR_INVALID_ARGUMENT, NULL);
 
     ext = SDL_strrchr(filename, '.');
-    rw = SDL_RWFromFile(filename, "rb");
-    BAIL_IF_MACRO(rw == NULL, SDL_GetError(), NULL);
-
     if (ext != NULL)
         ext++;
 
-    return Sound_NewSample(rw, ext, desired, bufferSize);
+    key = __Sound_CreateCacheKey(filename, NULL, 0, ext, desired);
+    entry = (key != NULL) ? __Sound_CacheLookup(key) : NULL;
+    if (entry != NULL)  /* already decoded; don't even open the file. */
+    {
+        __Sound_DestroyCacheKey(key);
+        return new_cached_sample(entry, desired, bufferSize);
+    } /* if */
+
+    rw = open_file(filename);
+    if (rw == NULL)
+    {
+        __Sound_DestroyCacheKey(key);
+        BAIL_MACRO(SDL_GetError(), NULL);
+    } /* if */
+
+    retval = Sound_NewSample(rw, ext, desired, bufferSize);
+    if (retval == NULL)
+        __Sound_DestroyCacheKey(key);
+    else  /* so Sound_DecodeAllParallel() can open it again. */
+    {
+        Sound_SampleInternal *internal = (Sound_SampleInternal *) retval->opaque;
+        internal->reopen_fname = SDL_strdup(filename);
+        internal->cache_key = key;
+    } /* else */
+
+    return retval;
 } /* Sound_NewSampleFromFile */
 
 
@@ -525,16 +1366,42 @@ Sound_Sample *Sound_NewSampleFromMem(const Uint8 *data,
                                      Sound_AudioInfo *desired,
                                      Uint32 bufferSize)
 {
+    Sound_Sample *retval;
+    Sound_CacheKey *key;
+    Sound_CacheEntry *entry;
     SDL_RWops *rw;
 
     BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, NULL);
     BAIL_IF_MACRO(data == NULL, ERR_INVALID_ARGUMENT, NULL);
     BAIL_IF_MACRO(size == 0, ERR_INVALID_ARGUMENT, NULL);
 
+    key = __Sound_CreateCacheKey(NULL, data, size, ext, desired);
+    entry = (key != NULL) ? __Sound_CacheLookup(key) : NULL;
+    if (entry != NULL)  /* already decoded. */
+    {
+        __Sound_DestroyCacheKey(key);
+        return new_cached_sample(entry, desired, bufferSize);
+    } /* if */
+
     rw = SDL_RWFromConstMem(data, size);
-    BAIL_IF_MACRO(rw == NULL, SDL_GetError(), NULL);
+    if (rw == NULL)
+    {
+        __Sound_DestroyCacheKey(key);
+        BAIL_MACRO(SDL_GetError(), NULL);
+    } /* if */
+
+    retval = Sound_NewSample(rw, ext, desired, bufferSize);
+    if (retval == NULL)
+        __Sound_DestroyCacheKey(key);
+    else  /* so Sound_DecodeAllParallel() can open it again. */
+    {
+        Sound_SampleInternal *internal = (Sound_SampleInternal *) retval->opaque;
+        internal->reopen_mem = data;
+        internal->reopen_memsize = size;
+        internal->cache_key = key;
+    } /* else */
 
-    return Sound_NewSample(rw, ext, desired, bufferSize);
+    return retval;
 } /* Sound_NewSampleFromMem */
 
 
@@ -586,59 +1453,216 @@ void Sound_FreeSample(Sound_Sample *sample)
     if (internal->rw != NULL)  /* this condition is a "just in case" thing. */
         SDL_RWclose(internal->rw);
 
-    SDL_FreeAudioStream(internal->stream);
-    SDL_free(internal);
-    __Sound_SIMDFree(sample->buffer);
-    SDL_free(sample);
+    SDL_free(internal->reopen_fname);
+    release_sample(sample);
 } /* Sound_FreeSample */
 
 
 int Sound_SetBufferSize(Sound_Sample *sample, Uint32 newSize)
 {
     void *newBuf = NULL;
-    Sound_SampleInternal *internal = NULL;
 
     BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, 0);
     BAIL_IF_MACRO(sample == NULL, ERR_INVALID_ARGUMENT, 0);
-    internal = ((Sound_SampleInternal *) sample->opaque);
+    unshare_buffer(sample);
     newBuf = __Sound_SIMDRealloc(sample->buffer, newSize);
     BAIL_IF_MACRO(newBuf == NULL, ERR_OUT_OF_MEMORY, 0);
 
-    internal->buffer = sample->buffer = newBuf;
-    internal->buffer_size = sample->buffer_size = newSize;
+    sample->buffer = newBuf;
+    sample->buffer_size = newSize;
 
-    return 1;
+    return sync_decode_buffer(sample);
 } /* Sound_SetBufferSize */
 
 
-Uint32 Sound_Decode(Sound_Sample *sample)
+/* Count one decoder call that took (ticks), and what came of it. */
+static void stats_decoder_call(Sound_Sample *sample, const Uint64 ticks,
+                               const Uint32 bytes)
 {
-    Sound_SampleInternal *internal = NULL;
-    int available;
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    Sound_SampleStats *stats = &internal->stats;
+    const Uint64 usecs = (ticks * 1000000) / perf_frequency;
+    Uint32 bucket = 0;
 
-        /* a boatload of sanity checks... */
-    BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, 0);
-    BAIL_IF_MACRO(sample == NULL, ERR_INVALID_ARGUMENT, 0);
-    BAIL_IF_MACRO(sample->flags & SOUND_SAMPLEFLAG_ERROR, ERR_PREV_ERROR, 0);
-    BAIL_IF_MACRO(sample->flags & SOUND_SAMPLEFLAG_EOF, ERR_PREV_EOF, 0);
+    while ((bucket < SOUND_STATS_HISTOGRAM_SIZE - 1) && ((((Uint64) 1) << bucket) <= usecs))
+        bucket++;
 
-    internal = (Sound_SampleInternal *) sample->opaque;
+    stats->decoder_calls++;
+    stats->decoder_ns += ticks;
+    stats->bytes_decoded += bytes;
+    stats->decoder_histogram[bucket]++;
+    if (sample->flags & SOUND_SAMPLEFLAG_EAGAIN)
+        stats->eagain_count++;
+} /* stats_decoder_call */
 
-    SDL_assert(sample->buffer != NULL);
-    SDL_assert(sample->buffer_size > 0);
-    SDL_assert(internal->buffer != NULL);
-    SDL_assert(internal->buffer_size > 0);
 
-    /* No AudioStream? No conversion. Decode right into the buffer and return it. */
-    if (!internal->stream)
+/*
+ * Every call into the decoder goes through here. Decode at most (len)
+ *  bytes, in the actual format, into (buf), and keep track of where the
+ *  decoder is, for Sound_TellFrames().
+ */
+static Uint32 decoder_read(Sound_Sample *sample, void *buf, const Uint32 len)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Uint32 framesize = (SDL_AUDIO_BITSIZE(sample->actual.format) / 8) *
+                             sample->actual.channels;
+    const Uint64 start = stats_clock(internal);
+    Uint32 retval;
+
+    /* reset EAGAIN. Decoder can flip it back on if it needs to. */
+    sample->flags &= ~SOUND_SAMPLEFLAG_EAGAIN;
+
+    /* if the decoder can write anywhere, no copies at all. */
+    if (internal->funcs->read_into != NULL)
+        retval = internal->funcs->read_into(sample, buf, len);
+    else
     {
-        /* reset EAGAIN. Decoder can flip it back on if it needs to. */
-        sample->flags &= ~SOUND_SAMPLEFLAG_EAGAIN;
-        return internal->funcs->read(sample);
+        /* Otherwise, decode no more than we asked for, and copy it over. */
+        const Uint32 origsize = internal->buffer_size;
+        internal->buffer_size = SDL_min(len, origsize);
+        retval = internal->funcs->read(sample);
+        internal->buffer_size = origsize;
+
+        if ((retval > 0) && (buf != internal->buffer))
+            SDL_memcpy(buf, internal->buffer, retval);
+    } /* else */
+
+    internal->frame_position += retval / framesize;
+
+    if (internal->collect_stats)
+        stats_decoder_call(sample, SDL_GetPerformanceCounter() - start, retval);
+
+    return retval;
+} /* decoder_read */
+
+
+/* Decode at most (len) bytes, in the actual format, into our scratch space. */
+static Uint32 read_scratch(Sound_Sample *sample, const Uint32 len)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    SDL_assert(len <= internal->buffer_size);
+    return decoder_read(sample, internal->buffer, len);
+} /* read_scratch */
+
+
+/* Decode into our scratch space and convert straight into (buf). */
+static Uint32 decode_via_converter(Sound_Sample *sample, void *buf, Uint32 len)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Sound_Converter *cvt = &internal->converter;
+    const Uint32 maxframes = internal->buffer_size / cvt->src_framesize;
+    Uint8 *dst = (Uint8 *) buf;
+    Uint32 retval = 0;
+
+    while (len >= cvt->dst_framesize)
+    {
+        Uint32 frames = SDL_min(len / cvt->dst_framesize, maxframes);
+        const Uint32 want = frames * cvt->src_framesize;
+        const Uint32 br = read_scratch(sample, want);
+        const Uint64 start = stats_clock(internal);
+
+        frames = br / cvt->src_framesize;
+        cvt->func(cvt, internal->buffer, dst, frames);
+        stats_elapsed(internal, &internal->stats.convert_ns, start);
+        dst += frames * cvt->dst_framesize;
+        len -= frames * cvt->dst_framesize;
+        retval += frames * cvt->dst_framesize;
+
+        /* a short read means the decoder has nothing more for now. */
+        if ((br < want) || (sample->flags & (SOUND_SAMPLEFLAG_EOF | SOUND_SAMPLEFLAG_ERROR | SOUND_SAMPLEFLAG_EAGAIN)))
+            break;
+    } /* while */
+
+    return retval;
+} /* decode_via_converter */
+
+
+/* Like decode_via_stream(), but with our own resampler. */
+static Uint32 decode_via_resampler(Sound_Sample *sample, void *buf, Uint32 len)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Uint32 framesize = (SDL_AUDIO_BITSIZE(sample->desired.format) / 8) *
+                             sample->desired.channels;
+    const Uint32 srcframesize = (SDL_AUDIO_BITSIZE(sample->actual.format) / 8) *
+                                sample->actual.channels;
+    Uint8 *dst = (Uint8 *) buf;
+    Uint32 retval = 0;
+
+    while (len >= framesize)
+    {
+        Uint64 start = stats_clock(internal);
+        const Uint32 got = __Sound_ResamplerGet(internal->resampler, dst, len / framesize);
+        SDL_bool flush = SDL_FALSE;
+        Uint32 br;
+
+        stats_elapsed(internal, &internal->stats.convert_ns, start);
+
+        if (got > 0)
+        {
+            dst += got * framesize;
+            len -= got * framesize;
+            retval += got * framesize;
+            continue;
+        } /* if */
+
+        if (internal->pending_eof || internal->pending_error)
+            break;  /* resampler is drained. */
+
+        br = read_scratch(sample, internal->buffer_size);
+
+        /* if the sample hit an error or EOF, note it, but don't let these flags
+           be set for the calling app until the resampler is empty too. */
+        if (sample->flags & SOUND_SAMPLEFLAG_EOF)
+        {
+            sample->flags &= ~SOUND_SAMPLEFLAG_EOF;
+            internal->pending_eof = SDL_TRUE;
+            flush = SDL_TRUE;
+        } /* if */
+
+        if (sample->flags & SOUND_SAMPLEFLAG_ERROR)
+        {
+            sample->flags &= ~SOUND_SAMPLEFLAG_ERROR;
+            internal->pending_error = SDL_TRUE;
+            flush = SDL_TRUE;
+        } /* if */
+
+        start = stats_clock(internal);
+        if (br >= srcframesize)
+            __Sound_ResamplerPut(internal->resampler, internal->buffer, br / srcframesize);
+        if (flush)
+            __Sound_ResamplerFlush(internal->resampler);
+        stats_elapsed(internal, &internal->stats.convert_ns, start);
+
+        if ((!flush) && ((br == 0) || (sample->flags & SOUND_SAMPLEFLAG_EAGAIN)))
+            break;  /* try again later. */
+    } /* while */
+
+    /* resampler is empty, set final flags. */
+    if ((retval == 0) && (internal->pending_eof || internal->pending_error))
+    {
+        if (internal->pending_eof)
+            sample->flags |= SOUND_SAMPLEFLAG_EOF;
+
+        if (internal->pending_error)
+            sample->flags |= SOUND_SAMPLEFLAG_ERROR;
+
+        internal->pending_eof = internal->pending_error = SDL_FALSE;
     } /* if */
 
+    return retval;
+} /* decode_via_resampler */
+
+
+/* Refill the conversion stream until it holds (len) bytes or the decoder
+ *  runs dry, then pull what we can straight out into (buf). */
+static Uint32 decode_via_stream(Sound_Sample *sample, void *buf, Uint32 len)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    Uint64 start;
+    int available;
+
     /* call into the decoder several times until we have enough data. */
-    while ((available = SDL_AudioStreamAvailable(internal->stream)) < internal->buffer_size)
+    while ((available = SDL_AudioStreamAvailable(internal->stream)) < (int) len)
     {
         SDL_bool flush_stream = SDL_FALSE;
         Uint32 br;
@@ -646,9 +1670,7 @@ Uint32 Sound_Decode(Sound_Sample *sample)
         if (internal->pending_eof || internal->pending_error)
             break;
 
-        /* reset EAGAIN. Decoder can flip it back on if it needs to. */
-        sample->flags &= ~SOUND_SAMPLEFLAG_EAGAIN;
-        br = internal->funcs->read(sample);
+        br = read_scratch(sample, internal->buffer_size);
 
         /* if the sample hit an error or EOF, note it, but don't let these flags
            be set for the calling app until the stream is empty too. */
@@ -666,6 +1688,7 @@ Uint32 Sound_Decode(Sound_Sample *sample)
             flush_stream = SDL_TRUE;
         } /* if */
 
+        start = stats_clock(internal);
         if ((br > 0) && (SDL_AudioStreamPut(internal->stream, internal->buffer, (int) br) == -1))
         {
             __Sound_SetError(SDL_GetError());
@@ -675,13 +1698,18 @@ Uint32 Sound_Decode(Sound_Sample *sample)
 
         if (flush_stream)
             SDL_AudioStreamFlush(internal->stream);
+        stats_elapsed(internal, &internal->stats.convert_ns, start);
     } /* while */
 
     /* if we hit eof or error, drain the stream before reporting that. */
     if (available > 0)
     {
-        const int readlen = SDL_min(available, sample->buffer_size);
-        const int br = SDL_AudioStreamGet(internal->stream, sample->buffer, readlen);
+        const int readlen = SDL_min(available, (int) len);
+        int br;
+
+        start = stats_clock(internal);
+        br = SDL_AudioStreamGet(internal->stream, buf, readlen);
+        stats_elapsed(internal, &internal->stats.convert_ns, start);
         if (br != readlen)
         {
             __Sound_SetError(SDL_GetError());
@@ -703,63 +1731,627 @@ Uint32 Sound_Decode(Sound_Sample *sample)
     internal->pending_eof = internal->pending_error = SDL_FALSE;
 
     return 0;
-} /* Sound_Decode */
+} /* decode_via_stream */
 
 
-Uint32 Sound_DecodeAll(Sound_Sample *sample)
+Uint32 Sound_Decode(Sound_Sample *sample)
 {
     Sound_SampleInternal *internal = NULL;
-    void *buf = NULL;
-    Uint32 newBufSize = 0;
+    Uint32 retval;
 
+        /* a boatload of sanity checks... */
     BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(sample == NULL, ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(sample->flags & SOUND_SAMPLEFLAG_ERROR, ERR_PREV_ERROR, 0);
     BAIL_IF_MACRO(sample->flags & SOUND_SAMPLEFLAG_EOF, ERR_PREV_EOF, 0);
+
+    internal = (Sound_SampleInternal *) sample->opaque;
+
+    unshare_buffer(sample);  /* in case Sound_DecodeAll() gave out the cached copy. */
+
+    SDL_assert(sample->buffer != NULL);
+    SDL_assert(sample->buffer_size > 0);
+    SDL_assert(internal->buffer != NULL);
+    SDL_assert(internal->buffer_size > 0);
+
+    /* Converting without resampling? One pass from our scratch buffer. */
+    if (internal->converter.func != NULL)
+        retval = decode_via_converter(sample, sample->buffer, sample->buffer_size);
+    else if (internal->resampler != NULL)
+        retval = decode_via_resampler(sample, sample->buffer, sample->buffer_size);
+    else if (internal->stream != NULL)
+        retval = decode_via_stream(sample, sample->buffer, sample->buffer_size);
+    else  /* No conversion. Decode right into the buffer and return it. */
+        retval = decoder_read(sample, sample->buffer, sample->buffer_size);
+
+    if (internal->collect_stats)
+    {
+        internal->stats.decode_calls++;
+        internal->stats.bytes_output += retval;
+    } /* if */
+    return retval;
+} /* Sound_Decode */
+
+
+Uint32 Sound_DecodeInto(Sound_Sample *sample, void *buffer, Uint32 len)
+{
+    Sound_SampleInternal *internal = NULL;
+    Uint32 framesize;
+    Uint32 retval;
+
+        /* a boatload of sanity checks... */
+    BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(sample == NULL, ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(buffer == NULL, ERR_INVALID_ARGUMENT, 0);
     BAIL_IF_MACRO(sample->flags & SOUND_SAMPLEFLAG_ERROR, ERR_PREV_ERROR, 0);
+    BAIL_IF_MACRO(sample->flags & SOUND_SAMPLEFLAG_EOF, ERR_PREV_EOF, 0);
 
     internal = (Sound_SampleInternal *) sample->opaque;
 
+    SDL_assert(internal->buffer != NULL);
+    SDL_assert(internal->buffer_size > 0);
+
+    /* only ever hand out whole sample frames. */
+    framesize = (SDL_AUDIO_BITSIZE(sample->desired.format) / 8) *
+                sample->desired.channels;
+    len -= len % framesize;
+    BAIL_IF_MACRO(len == 0, ERR_INVALID_ARGUMENT, 0);
+
+    /* Conversion still has to go through the stream, but the stream can
+       drop its output directly in the app's buffer. */
+    if (internal->stream)
+        retval = decode_via_stream(sample, buffer, len);
+    else if (internal->converter.func != NULL)
+        retval = decode_via_converter(sample, buffer, len);
+    else if (internal->resampler != NULL)
+        retval = decode_via_resampler(sample, buffer, len);
+    else  /* No conversion; straight from the decoder. */
+        retval = decoder_read(sample, buffer, len);
+
+    if (internal->collect_stats)
+    {
+        internal->stats.decode_calls++;
+        internal->stats.bytes_output += retval;
+    } /* if */
+    return retval;
+} /* Sound_DecodeInto */
+
+
+/* Guess how many bytes the rest of the sample will decode to, or 0. */
+static Uint32 estimate_decoded_size(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Uint64 framesize = (SDL_AUDIO_BITSIZE(sample->desired.format) / 8) *
+                             sample->desired.channels;
+    Uint64 total;
+
+    if (internal->total_time <= 0)
+        return 0;  /* decoder doesn't know. */
+
+    total = (((Uint64) internal->total_time) * sample->desired.rate) / 1000;
+    total *= framesize;
+    total += sample->buffer_size;  /* slack for rounding, and so we can see EOF. */
+    return (total > 0xFFFFFFFF) ? 0xFFFFFFFF : (Uint32) total;
+} /* estimate_decoded_size */
+
+
+/*
+ * If the rest of (sample) is in the cache, make sample->buffer point at it,
+ *  put the sample at EOF, and return non-zero. The decoder doesn't move;
+ *  the next Sound_Rewind() or Sound_Seek() will put it somewhere sensible.
+ */
+static int decode_all_from_cache(Sound_Sample *sample, Uint32 *decoded)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Uint32 framesize = (SDL_AUDIO_BITSIZE(sample->desired.format) / 8) *
+                             sample->desired.channels;
+    Sound_AudioInfo info;
+    const Uint8 *data;
+    Uint64 offset;
+    Uint32 len;
+
+    if (internal->cache_entry == NULL)
+        return 0;
+
+    /* the cached copy has to be exactly what decoding would give us. */
+    data = __Sound_CacheData(internal->cache_entry, &len, &info);
+    if (!audioinfo_equal(&info, &sample->desired))
+        return 0;  /* Sound_SetResampleMode(SOUND_RESAMPLE_NONE) changed it. */
+    else if ( (internal->resample_mode != SOUND_RESAMPLE_DEFAULT) &&
+              (sample->actual.rate != sample->desired.rate) )
+        return 0;
+
+    /* we can only tell where we are in it if nothing's held up in conversion. */
+    if (internal->frame_position == 0)
+        offset = 0;
+    else if ( (sample->actual.rate == sample->desired.rate) &&
+              (internal->stream == NULL) && (internal->resampler == NULL) )
+        offset = internal->frame_position * framesize;
+    else
+        return 0;
+
+    if (offset > len)
+        offset = len;
+
+    if (internal->private_buffer == NULL)  /* hold on to our own buffer. */
+    {
+        internal->private_buffer = sample->buffer;
+        internal->private_buffer_size = sample->buffer_size;
+    } /* if */
+
+    sample->buffer = (void *) (data + offset);  /* it's read-only, app! */
+    sample->buffer_size = len - (Uint32) offset;
+    internal->frame_position = (((Uint64) (len / framesize)) * sample->actual.rate) / sample->desired.rate;
+    sample->flags |= SOUND_SAMPLEFLAG_EOF;
+
+    *decoded = sample->buffer_size;
+    return 1;
+} /* decode_all_from_cache */
+
+
+/*
+ * (*buf) is all of (sample), decoded from the start. Offer it to the cache.
+ *  If the cache takes it, sample->buffer is the cached copy from now on,
+ *  and this returns non-zero. Otherwise, (*buf) is still yours (and may
+ *  have moved).
+ */
+static int cache_decoded(Sound_Sample *sample, Uint8 **buf, Uint32 len)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    void *ptr;
+
+    if ( (internal->cache_key == NULL) || (len == 0) ||
+         (internal->resample_mode != SOUND_RESAMPLE_DEFAULT) ||
+         (sample->flags & SOUND_SAMPLEFLAG_ERROR) )
+    {
+        return 0;
+    } /* if */
+
+    /* the cache counts every byte it keeps; don't give it the slack. */
+    ptr = __Sound_SIMDRealloc(*buf, len);
+    if (ptr != NULL)
+        *buf = (Uint8 *) ptr;
+
+    internal->cache_entry = __Sound_CacheInsert(internal->cache_key, *buf, len, sample);
+    if (internal->cache_entry == NULL)
+        return 0;
+
+    internal->cache_key = NULL;  /* the cache owns this now. */
+
+    SDL_assert(internal->private_buffer == NULL);
+    internal->private_buffer = sample->buffer;
+    internal->private_buffer_size = sample->buffer_size;
+    sample->buffer = *buf;
+    sample->buffer_size = len;
+    return 1;
+} /* cache_decoded */
+
+
+Uint32 Sound_DecodeAllEx(Sound_Sample *sample, Uint32 flags)
+{
+    Sound_SampleInternal *internal = NULL;
+    Uint8 *buf = NULL;
+    Uint32 capacity = 0;
+    Uint32 newBufSize = 0;
+    SDL_bool from_start;
+
+    BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(sample->flags & SOUND_SAMPLEFLAG_EOF, ERR_PREV_EOF, 0);
+    BAIL_IF_MACRO(sample->flags & SOUND_SAMPLEFLAG_ERROR, ERR_PREV_ERROR, 0);
+
+    internal = (Sound_SampleInternal *) sample->opaque;
+
+    /* decoded this before? Then there's nothing to do. */
+    if (decode_all_from_cache(sample, &newBufSize))
+        return newBufSize;
+
+    unshare_buffer(sample);
+    from_start = (internal->frame_position == 0) ? SDL_TRUE : SDL_FALSE;
+
+    /* if we know how long this is, get it all in one shot. */
+    capacity = estimate_decoded_size(sample);
+    if (capacity < sample->buffer_size)
+        capacity = sample->buffer_size * 4;
+
+    buf = (Uint8 *) __Sound_SIMDAlloc(capacity);
+    if (buf == NULL)
+    {
+        __Sound_SetError(ERR_OUT_OF_MEMORY);
+        return sample->buffer_size;
+    } /* if */
+
     while ( ((sample->flags & SOUND_SAMPLEFLAG_EOF) == 0) &&
             ((sample->flags & SOUND_SAMPLEFLAG_ERROR) == 0) )
     {
-        Uint32 br = Sound_Decode(sample);
-        void *ptr = __Sound_SIMDRealloc(buf, newBufSize + br);
-        if (ptr == NULL)
+        Uint32 avail = capacity - newBufSize;
+        Uint32 br;
+
+        /* always leave room for a full decode buffer. Grow geometrically,
+           so long files with no known duration don't go quadratic. */
+        if (avail < sample->buffer_size)
         {
-            sample->flags |= SOUND_SAMPLEFLAG_ERROR;
-            __Sound_SetError(ERR_OUT_OF_MEMORY);
+            Uint64 newcap = ((Uint64) capacity) * 2;
+            void *ptr;
+
+            if (newcap > 0xFFFFFFFF)
+                newcap = 0xFFFFFFFF;
+
+            ptr = (newcap > capacity) ? __Sound_SIMDRealloc(buf, (size_t) newcap) : NULL;
+            if (ptr == NULL)
+            {
+                sample->flags |= SOUND_SAMPLEFLAG_ERROR;
+                __Sound_SetError(ERR_OUT_OF_MEMORY);
+                break;
+            } /* if */
+
+            buf = (Uint8 *) ptr;
+            capacity = (Uint32) newcap;
+            avail = capacity - newBufSize;
         } /* if */
-        else
-        {
-            buf = ptr;
-            SDL_memcpy( ((char *) buf) + newBufSize, sample->buffer, br );
-            newBufSize += br;
-        } /* else */
+
+        /* conversion goes through an SDL_AudioStream; don't let that
+           balloon by asking for everything at once. */
+        if ((internal->stream != NULL) && (avail > sample->buffer_size))
+            avail = sample->buffer_size;
+
+        /* no intermediate copy through sample->buffer. */
+        br = Sound_DecodeInto(sample, buf + newBufSize, avail);
+        newBufSize += br;
     } /* while */
 
-    if (buf == NULL)  /* ...in case first call to __Sound_SIMDRealloc() fails... */
-        return sample->buffer_size;
+    /* all of it, start to finish? Then keep it for next time. */
+    if ( (from_start) && (sample->flags & SOUND_SAMPLEFLAG_EOF) &&
+         (cache_decoded(sample, &buf, newBufSize)) )
+    {
+        return newBufSize;
+    } /* if */
 
-    __Sound_SIMDFree(sample->buffer);
+    if ((flags & SOUND_DECODEALL_TRIM) && (newBufSize < capacity))
+    {
+        void *ptr = __Sound_SIMDRealloc(buf, newBufSize ? newBufSize : 1);
+        if (ptr != NULL)  /* if this fails, the bigger buffer is still fine. */
+            buf = (Uint8 *) ptr;
+    } /* if */
+
+    if (internal->buffer == sample->buffer)  /* otherwise, the decoder keeps its scratch buffer. */
+    {
+        internal->buffer = buf;
+        internal->buffer_size = newBufSize;
+    } /* if */
 
-    internal->buffer = sample->buffer = buf;
-    internal->buffer_size = sample->buffer_size = newBufSize;
+    pool_put_buffer(sample->buffer, sample->buffer_size);  /* the old decode buffer is likely reusable. */
+    sample->buffer = buf;
+    sample->buffer_size = newBufSize;
 
     return newBufSize;
+} /* Sound_DecodeAllEx */
+
+
+Uint32 Sound_DecodeAll(Sound_Sample *sample)
+{
+    return Sound_DecodeAllEx(sample, 0);
 } /* Sound_DecodeAll */
 
 
+/*
+ * Parallel whole-file decoding...
+ *
+ * The timeline is cut into one span of sample frames per thread. Each
+ *  thread gets its own decoder instance, on its own RWops, seeks it to the
+ *  start of its span with the decoder's seek_frame() method, and decodes
+ *  straight into its slice of the final buffer. The final buffer has some
+ *  slack past the end, since the duration might be a little off, and the
+ *  last thread runs to EOF; if it overruns the slack too, it carries on in
+ *  a buffer of its own, and that gets appended at the end.
+ *
+ * This only works if the pieces are bit-identical to a serial decode, so we
+ *  need exact seeks, and no resampling (SDL_AudioStream's resampler keeps
+ *  state between calls; format and channel conversion don't).
+ */
+typedef struct
+{
+    Sound_Sample *sample;
+    Uint64 start_frame;
+    Uint8 *dst;
+    Uint32 len;            /* room at (dst). */
+    Uint32 done;           /* bytes written to (dst). */
+    SDL_bool to_eof;       /* last span: keep going past (len) until EOF. */
+    Uint8 *extra;          /* where the last span goes once (dst) is full. */
+    Uint32 extra_len;
+    Uint32 extra_capacity;
+    SDL_bool failed;
+} DecodeSpan;
+
+
+static SDL_RWops *reopen_rwops(Sound_SampleInternal *internal)
+{
+    if (internal->reopen_fname != NULL)
+        return open_file(internal->reopen_fname);
+    else if (internal->reopen_mem != NULL)
+        return SDL_RWFromConstMem(internal->reopen_mem, internal->reopen_memsize);
+    return NULL;
+} /* reopen_rwops */
+
+
+/* Open another instance of (sample) with the same decoder and formats. */
+static Sound_Sample *clone_sample(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    SDL_RWops *rw = reopen_rwops(internal);
+    Sound_Sample *retval;
+
+    if (rw == NULL)
+        return NULL;
+
+    retval = alloc_sample(rw, &sample->desired, sample->buffer_size);
+    if (retval == NULL)
+    {
+        SDL_RWclose(rw);
+        return NULL;
+    } /* if */
+
+    /* (only decoders with seek_frame() get here, and none of them care
+       about the extension.) */
+    if (!init_sample(internal->funcs, retval, NULL, &sample->desired))
+    {
+        release_sample(retval);
+        SDL_RWclose(rw);
+        return NULL;
+    } /* if */
+
+    return retval;
+} /* clone_sample */
+
+
+/* Decode into (dst) until it's full, or we hit EOF or an error. */
+static Uint32 decode_span_into(Sound_Sample *sample, Uint8 *dst, Uint32 len)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    Uint32 total = 0;
+
+    while ( (total < len) &&
+            ((sample->flags & (SOUND_SAMPLEFLAG_EOF | SOUND_SAMPLEFLAG_ERROR)) == 0) )
+    {
+        Uint32 avail = len - total;
+        if ((internal->stream != NULL) && (avail > sample->buffer_size))
+            avail = sample->buffer_size;
+        total += Sound_DecodeInto(sample, dst + total, avail);
+    } /* while */
+
+    return total;
+} /* decode_span_into */
+
+
+static int SDLCALL decode_span_thread(void *data)
+{
+    DecodeSpan *span = (DecodeSpan *) data;
+    Sound_Sample *sample = span->sample;
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+
+    if (!internal->funcs->seek_frame(sample, span->start_frame))
+    {
+        span->failed = SDL_TRUE;
+        return 0;
+    } /* if */
+
+    sample->flags &= ~(SOUND_SAMPLEFLAG_EOF | SOUND_SAMPLEFLAG_ERROR | SOUND_SAMPLEFLAG_EAGAIN);
+
+    span->done = decode_span_into(sample, span->dst, span->len);
+
+    if (!span->to_eof)
+    {
+        /* a short span means the duration was wrong; can't stitch that. */
+        span->failed = (span->done != span->len) ? SDL_TRUE : SDL_FALSE;
+        return 0;
+    } /* if */
+
+    /* the duration was short, and we ran out of slack. Grow our own. */
+    while ((sample->flags & (SOUND_SAMPLEFLAG_EOF | SOUND_SAMPLEFLAG_ERROR)) == 0)
+    {
+        if ((span->extra_capacity - span->extra_len) < sample->buffer_size)
+        {
+            const Uint64 newcap = span->extra_capacity ? (((Uint64) span->extra_capacity) * 2) : (((Uint64) sample->buffer_size) * 4);
+            void *ptr = (newcap <= 0xFFFFFFFF) ? __Sound_SIMDRealloc(span->extra, (size_t) newcap) : NULL;
+            if (ptr == NULL)
+            {
+                span->failed = SDL_TRUE;
+                return 0;
+            } /* if */
+            span->extra = (Uint8 *) ptr;
+            span->extra_capacity = (Uint32) newcap;
+        } /* if */
+
+        span->extra_len += decode_span_into(sample, span->extra + span->extra_len,
+                                            span->extra_capacity - span->extra_len);
+    } /* while */
+
+    span->failed = (sample->flags & SOUND_SAMPLEFLAG_ERROR) ? SDL_TRUE : SDL_FALSE;
+    return 0;
+} /* decode_span_thread */
+
+
+static Uint32 decode_all_parallel(Sound_Sample *sample, int threads)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Uint32 outframesize = (SDL_AUDIO_BITSIZE(sample->desired.format) / 8) *
+                                sample->desired.channels;
+    const Uint64 total_frames = (((Uint64) internal->total_time) * sample->actual.rate) / 1000;
+    DecodeSpan *spans = NULL;
+    SDL_Thread **workers = NULL;
+    Uint8 *buf = NULL;
+    Uint64 capacity;
+    Uint32 retval = 0;
+    SDL_bool failed = SDL_FALSE;
+    int i;
+
+    /* everything gets written in place, plus slack (like Sound_DecodeAll()
+       gives itself) in case the duration is short, so it all has to fit in
+       the Uint32 that Sound_Sample uses. */
+    capacity = (total_frames * outframesize) + sample->buffer_size;
+    capacity -= capacity % outframesize;
+    if ((total_frames < (Uint64) threads) || (capacity > 0x7FFFFFFF))
+        return 0;
+
+    spans = (DecodeSpan *) SDL_calloc(threads, sizeof (DecodeSpan));
+    workers = (SDL_Thread **) SDL_calloc(threads, sizeof (SDL_Thread *));
+    buf = (Uint8 *) __Sound_SIMDAlloc((size_t) capacity);
+    if ((spans == NULL) || (workers == NULL) || (buf == NULL))
+        failed = SDL_TRUE;
+
+    for (i = 0; (!failed) && (i < threads); i++)
+    {
+        const Uint64 start = (total_frames * i) / threads;
+        const Uint64 end = (i == threads - 1) ? (capacity / outframesize) : ((total_frames * (i + 1)) / threads);
+        spans[i].start_frame = start;
+        spans[i].dst = buf + (start * outframesize);
+        spans[i].len = (Uint32) ((end - start) * outframesize);
+        spans[i].to_eof = (i == threads - 1) ? SDL_TRUE : SDL_FALSE;
+        spans[i].sample = clone_sample(sample);
+        if (spans[i].sample == NULL)
+            failed = SDL_TRUE;
+    } /* for */
+
+    for (i = 0; (!failed) && (i < threads); i++)
+    {
+        workers[i] = SDL_CreateThread(decode_span_thread, "SDL_sound decode", &spans[i]);
+        if (workers[i] == NULL)
+            failed = SDL_TRUE;
+    } /* for */
+
+    for (i = 0; (workers != NULL) && (i < threads); i++)
+    {
+        if (workers[i] != NULL)
+        {
+            SDL_WaitThread(workers[i], NULL);
+            if (spans[i].failed)
+                failed = SDL_TRUE;
+        } /* if */
+    } /* for */
+
+    if (!failed)
+    {
+        const DecodeSpan *last = &spans[threads - 1];
+        const Uint64 fixedlen = last->dst - buf;
+        const Uint64 total = fixedlen + last->done + last->extra_len;
+        void *ptr = buf;
+
+        /* only if the last span overran the slack. */
+        if (last->extra_len > 0)
+            ptr = (total <= 0xFFFFFFFF) ? __Sound_SIMDRealloc(buf, (size_t) total) : NULL;
+
+        if (ptr == NULL)
+            failed = SDL_TRUE;
+        else
+        {
+            buf = (Uint8 *) ptr;
+            if (last->extra_len > 0)
+                SDL_memcpy(buf + fixedlen + last->done, last->extra, last->extra_len);
+            retval = (Uint32) total;
+
+            if (!cache_decoded(sample, &buf, retval))
+            {
+                if (internal->buffer == sample->buffer)
+                {
+                    internal->buffer = buf;
+                    internal->buffer_size = retval;
+                } /* if */
+                pool_put_buffer(sample->buffer, sample->buffer_size);
+                sample->buffer = buf;
+                sample->buffer_size = retval;
+            } /* if */
+            buf = NULL;
+
+            /* the original sample is at EOF now, same as after DecodeAll. */
+            internal->frame_position = retval / outframesize;
+            sample->flags |= SOUND_SAMPLEFLAG_EOF;
+        } /* else */
+    } /* if */
+
+    for (i = 0; (spans != NULL) && (i < threads); i++)
+    {
+        if (spans[i].sample != NULL)
+            Sound_FreeSample(spans[i].sample);
+        __Sound_SIMDFree(spans[i].extra);
+    } /* for */
+
+    __Sound_SIMDFree(buf);
+    SDL_free(workers);
+    SDL_free(spans);
+
+    return failed ? 0 : retval;
+} /* decode_all_parallel */
+
+
+Uint32 Sound_DecodeAllParallel(Sound_Sample *sample, int threads)
+{
+    Sound_SampleInternal *internal = NULL;
+    Uint32 retval;
+
+    BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(sample == NULL, ERR_INVALID_ARGUMENT, 0);
+
+    internal = (Sound_SampleInternal *) sample->opaque;
+
+    /* more threads than CPUs would just be more open files and decoders. */
+    if ((threads <= 0) || (threads > SDL_GetCPUCount()))
+        threads = SDL_GetCPUCount();
+
+    /* always the whole thing, from the top. */
+    BAIL_IF_MACRO(!Sound_Rewind(sample), NULL, 0);
+
+    if ( (threads > 1) &&
+         (internal->cache_entry == NULL) &&  /* Sound_DecodeAll() is instant. */
+         (internal->funcs->seek_frame != NULL) &&
+         (internal->fast_seek_frame) &&  /* or every thread decodes its way in. */
+         (internal->total_time > 0) &&
+         (sample->actual.rate == sample->desired.rate) &&
+         ((internal->reopen_fname != NULL) || (internal->reopen_mem != NULL)) )
+    {
+        retval = decode_all_parallel(sample, threads);
+        if (retval > 0)
+            return retval;
+    } /* if */
+
+    /* can't (or couldn't) split this one up. Do it the slow way. */
+    return Sound_DecodeAll(sample);
+} /* Sound_DecodeAllParallel */
+
+
+/* Throw out converted audio from before a seek. */
+static void reset_conversion(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+
+    if (internal->stream != NULL)
+        SDL_AudioStreamClear(internal->stream);
+
+    if (internal->resampler != NULL)
+        __Sound_ResamplerClear(internal->resampler);
+
+    internal->pending_eof = internal->pending_error = SDL_FALSE;
+} /* reset_conversion */
+
+
 int Sound_Rewind(Sound_Sample *sample)
 {
     Sound_SampleInternal *internal;
+    Uint64 start;
     BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, 0);
 
     internal = (Sound_SampleInternal *) sample->opaque;
+    start = stats_clock(internal);
     if (!internal->funcs->rewind(sample))
     {
         sample->flags |= SOUND_SAMPLEFLAG_ERROR;
         return 0;
     } /* if */
 
+    reset_conversion(sample);
+    internal->frame_position = 0;
+    stats_elapsed(internal, &internal->stats.seek_ns, start);
+    if (internal->collect_stats)
+        internal->stats.seeks++;
+
     sample->flags &= ~SOUND_SAMPLEFLAG_EAGAIN;
     sample->flags &= ~SOUND_SAMPLEFLAG_ERROR;
     sample->flags &= ~SOUND_SAMPLEFLAG_EOF;
@@ -771,20 +2363,226 @@ int Sound_Rewind(Sound_Sample *sample)
 int Sound_Seek(Sound_Sample *sample, Uint32 ms)
 {
     Sound_SampleInternal *internal;
+    Uint64 start;
 
     BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, 0);
     if (!(sample->flags & SOUND_SAMPLEFLAG_CANSEEK))
         BAIL_MACRO(ERR_CANNOT_SEEK, 0);
 
     internal = (Sound_SampleInternal *) sample->opaque;
+    start = stats_clock(internal);
     BAIL_IF_MACRO(!internal->funcs->seek(sample, ms), NULL, 0);
 
+    reset_conversion(sample);
+    internal->frame_position = __Sound_convertMsToFrames(sample->actual.rate, ms);
+    stats_elapsed(internal, &internal->stats.seek_ns, start);
+    if (internal->collect_stats)
+        internal->stats.seeks++;
+
     sample->flags &= ~SOUND_SAMPLEFLAG_EAGAIN;
     sample->flags &= ~SOUND_SAMPLEFLAG_ERROR;
     sample->flags &= ~SOUND_SAMPLEFLAG_EOF;
 
     return 1;
-} /* Sound_Rewind */
+} /* Sound_Seek */
+
+
+/* Decode and throw away (frames) sample frames, straight from the decoder. */
+static int skip_frames(Sound_Sample *sample, Uint64 frames)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Uint32 framesize = (SDL_AUDIO_BITSIZE(sample->actual.format) / 8) *
+                             sample->actual.channels;
+    const Uint32 maxframes = internal->buffer_size / framesize;
+
+    BAIL_IF_MACRO(maxframes == 0, ERR_INVALID_ARGUMENT, 0);
+
+    while (frames > 0)
+    {
+        const Uint32 want = (Uint32) SDL_min(frames, (Uint64) maxframes);
+        const Uint32 br = read_scratch(sample, want * framesize) / framesize;
+
+        frames -= br;
+        if (br < want)
+        {
+            BAIL_IF_MACRO(sample->flags & SOUND_SAMPLEFLAG_ERROR, NULL, 0);
+            BAIL_IF_MACRO(sample->flags & SOUND_SAMPLEFLAG_EOF, ERR_PAST_EOF, 0);
+            BAIL_IF_MACRO(br == 0, ERR_IO_ERROR, 0);  /* EAGAIN? Can't wait here. */
+        } /* if */
+    } /* while */
+
+    return 1;
+} /* skip_frames */
+
+
+int Sound_SeekFrames(Sound_Sample *sample, Uint64 frame)
+{
+    Sound_SampleInternal *internal;
+    Uint64 start;
+
+    BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(sample == NULL, ERR_INVALID_ARGUMENT, 0);
+    if (!(sample->flags & SOUND_SAMPLEFLAG_CANSEEK))
+        BAIL_MACRO(ERR_CANNOT_SEEK, 0);
+
+    internal = (Sound_SampleInternal *) sample->opaque;
+    start = stats_clock(internal);
+
+    if (internal->funcs->seek_frame != NULL)
+    {
+        BAIL_IF_MACRO(!internal->funcs->seek_frame(sample, frame), NULL, 0);
+    } /* if */
+    else
+    {
+        /* get close with a millisecond seek, then decode the rest of the way. */
+        const Uint64 ms = (frame * 1000) / sample->actual.rate;
+        Uint64 start;
+
+        BAIL_IF_MACRO(ms > 0xFFFFFFFF, ERR_INVALID_ARGUMENT, 0);
+        start = __Sound_convertMsToFrames(sample->actual.rate, (Uint32) ms);
+        SDL_assert(start <= frame);
+
+        BAIL_IF_MACRO(!internal->funcs->seek(sample, (Uint32) ms), NULL, 0);
+        sample->flags &= ~SOUND_SAMPLEFLAG_EAGAIN;
+        sample->flags &= ~SOUND_SAMPLEFLAG_ERROR;
+        sample->flags &= ~SOUND_SAMPLEFLAG_EOF;
+
+        if (!skip_frames(sample, frame - start))
+        {
+            /* we already moved, so we can't pretend this never happened. */
+            reset_conversion(sample);
+            internal->frame_position = start;
+            sample->flags |= SOUND_SAMPLEFLAG_ERROR;
+            return 0;
+        } /* if */
+    } /* else */
+
+    reset_conversion(sample);
+    internal->frame_position = frame;
+    stats_elapsed(internal, &internal->stats.seek_ns, start);
+    if (internal->collect_stats)
+        internal->stats.seeks++;
+
+    sample->flags &= ~SOUND_SAMPLEFLAG_EAGAIN;
+    sample->flags &= ~SOUND_SAMPLEFLAG_ERROR;
+    sample->flags &= ~SOUND_SAMPLEFLAG_EOF;
+
+    return 1;
+} /* Sound_SeekFrames */
+
+
+Sint64 Sound_TellFrames(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal;
+    Uint64 retval;
+
+    BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, -1);
+    BAIL_IF_MACRO(sample == NULL, ERR_INVALID_ARGUMENT, -1);
+
+    internal = (Sound_SampleInternal *) sample->opaque;
+    retval = internal->frame_position;
+
+    /* don't count what's still waiting in the conversion stream. */
+    if (internal->stream != NULL)
+    {
+        const Uint32 framesize = (SDL_AUDIO_BITSIZE(sample->desired.format) / 8) *
+                                 sample->desired.channels;
+        const Uint64 buffered = (Uint64) (SDL_AudioStreamAvailable(internal->stream) / framesize);
+        const Uint64 frames = (buffered * sample->actual.rate) / sample->desired.rate;
+        retval -= SDL_min(retval, frames);
+    } /* if */
+
+    return (Sint64) retval;
+} /* Sound_TellFrames */
+
+
+void Sound_SetStatsEnabled(int enabled)
+{
+    stats_enabled = enabled ? 1 : 0;
+} /* Sound_SetStatsEnabled */
+
+
+void Sound_SetMapFiles(int enabled)
+{
+    map_files = enabled ? 1 : 0;
+} /* Sound_SetMapFiles */
+
+
+/* performance counter ticks to nanoseconds, without overflowing. */
+static Uint64 ticks_to_ns(const Uint64 ticks)
+{
+    const Uint64 secs = ticks / perf_frequency;
+    const Uint64 rest = ticks % perf_frequency;
+    return (secs * 1000000000) + ((rest * 1000000000) / perf_frequency);
+} /* ticks_to_ns */
+
+
+int Sound_GetSampleStats(Sound_Sample *sample, Sound_SampleStats *stats)
+{
+    Sound_SampleInternal *internal;
+
+    BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(sample == NULL, ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(stats == NULL, ERR_INVALID_ARGUMENT, 0);
+
+    internal = (Sound_SampleInternal *) sample->opaque;
+    BAIL_IF_MACRO(!internal->collect_stats, ERR_NO_STATS, 0);
+
+    SDL_memcpy(stats, &internal->stats, sizeof (Sound_SampleStats));
+    stats->open_ns = ticks_to_ns(stats->open_ns);
+    stats->decoder_ns = ticks_to_ns(stats->decoder_ns);
+    stats->convert_ns = ticks_to_ns(stats->convert_ns);
+    stats->seek_ns = ticks_to_ns(stats->seek_ns);
+    return 1;
+} /* Sound_GetSampleStats */
+
+
+int Sound_SetResampleMode(Sound_Sample *sample, Sound_ResampleMode mode)
+{
+    Sound_SampleInternal *internal;
+    Sound_ResampleMode oldmode;
+
+    BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, 0);
+    BAIL_IF_MACRO(sample == NULL, ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO((mode < SOUND_RESAMPLE_DEFAULT) || (mode > SOUND_RESAMPLE_SINC), ERR_INVALID_ARGUMENT, 0);
+
+    internal = (Sound_SampleInternal *) sample->opaque;
+    if (internal->resample_mode == mode)
+        return 1;
+
+    oldmode = internal->resample_mode;
+    unshare_buffer(sample);
+    teardown_conversion(sample);
+
+    /* whatever was buffered for conversion is gone, so if the decoder
+       already finished, so have we. */
+    if (internal->pending_eof)
+        sample->flags |= SOUND_SAMPLEFLAG_EOF;
+    if (internal->pending_error)
+        sample->flags |= SOUND_SAMPLEFLAG_ERROR;
+    internal->pending_eof = internal->pending_error = SDL_FALSE;
+
+    internal->resample_mode = mode;
+    if (!setup_conversion(sample))
+    {
+        internal->resample_mode = oldmode;
+        if (!setup_conversion(sample))  /* this worked before, but... */
+            sample->flags |= SOUND_SAMPLEFLAG_ERROR;
+        return 0;
+    } /* if */
+
+    return 1;
+} /* Sound_SetResampleMode */
+
+
+Sound_ResampleMode Sound_GetResampleMode(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal;
+    BAIL_IF_MACRO(!initialized, ERR_NOT_INITIALIZED, SOUND_RESAMPLE_DEFAULT);
+    BAIL_IF_MACRO(sample == NULL, ERR_INVALID_ARGUMENT, SOUND_RESAMPLE_DEFAULT);
+    internal = (Sound_SampleInternal *) sample->opaque;
+    return internal->resample_mode;
+} /* Sound_GetResampleMode */
 
 
 Sint32 Sound_GetDuration(Sound_Sample *sample)
@@ -870,6 +2668,12 @@ char *__Sound_strtokr(char *s1, const char *s2, char **ptr)
 #endif
 
 
+Uint32 __Sound_SIMDFlags(void)
+{
+    return simd_flags;
+} /* __Sound_SIMDFlags */
+
+
 /* This falls back to an included copy/paste of SDL's SIMDAlloc code if you aren't using a new enough SDL.
    To keep this simple, the included copy assumes you need to align to 64 bytes, which is a little
    wasteful but should work on everything from MMX to AVX-512. The real SDL checks the CPU at runtime
@@ -105,6 +105,25 @@ typedef enum
 } Sound_SampleFlags;
 
 
+/**
+ * \enum Sound_ResampleMode
+ * \brief How a Sound_Sample converts between sample rates.
+ *
+ * Higher quality costs more CPU time. Something playing in the background
+ *  can usually get away with SOUND_RESAMPLE_LINEAR, while music should use
+ *  SOUND_RESAMPLE_SINC. examples/bench_resample.c measures both.
+ *
+ * \sa Sound_SetResampleMode
+ */
+typedef enum
+{
+    SOUND_RESAMPLE_DEFAULT = 0, /**< Whatever SDL_AudioStream does. */
+    SOUND_RESAMPLE_NONE,        /**< Don't resample; desired rate is ignored. */
+    SOUND_RESAMPLE_LINEAR,      /**< Linear interpolation. Fast, but aliases. */
+    SOUND_RESAMPLE_SINC         /**< Polyphase windowed sinc. Slow, but clean. */
+} Sound_ResampleMode;
+
+
 /**
  * \struct Sound_AudioInfo
  * \brief Information about an existing sample's format.
@@ -196,6 +215,114 @@ typedef struct
 } Sound_Version;
 
 
+/**
+ * \struct Sound_PoolLimits
+ * \brief How much SDL_sound may keep around for reuse between samples.
+ *
+ * Sound_FreeSample() doesn't give everything back to the system right away.
+ *  The Sound_Sample structure, its decode buffer, and its conversion stream
+ *  are held in pools, so the next Sound_NewSample*() call can reuse them
+ *  instead of allocating and clearing fresh ones. This matters if you open
+ *  lots of short samples. Setting a limit to zero disables that pool.
+ *
+ * \sa Sound_SetPoolLimits
+ * \sa Sound_GetPoolStats
+ */
+typedef struct
+{
+    Uint32 max_samples;     /**< Sound_Sample structs to keep. */
+    Uint32 max_buffers;     /**< Decode buffers to keep, all sizes together. */
+    Uint32 max_buffer_size; /**< Bigger decode buffers are always freed. */
+    Uint32 max_streams;     /**< Conversion streams to keep, all formats together. */
+} Sound_PoolLimits;
+
+
+/**
+ * \struct Sound_PoolStats
+ * \brief How well the sample pools are doing.
+ *
+ * A "hit" is an allocation the pool satisfied, a "miss" is one that had to
+ *  go to the system. Buffers are matched on exact size, and streams on the
+ *  exact source and destination format, so if you see a lot of misses, try
+ *  to use the same buffer size for all your samples.
+ *
+ * \sa Sound_GetPoolStats
+ */
+typedef struct
+{
+    Uint64 sample_hits;     /**< Sound_Sample structs reused. */
+    Uint64 sample_misses;   /**< Sound_Sample structs allocated. */
+    Uint64 buffer_hits;     /**< Decode buffers reused. */
+    Uint64 buffer_misses;   /**< Decode buffers allocated. */
+    Uint64 stream_hits;     /**< Conversion streams reused. */
+    Uint64 stream_misses;   /**< Conversion streams created. */
+    Uint32 pooled_samples;  /**< Sound_Sample structs in the pool right now. */
+    Uint32 pooled_buffers;  /**< Decode buffers in the pool right now. */
+    Uint32 pooled_streams;  /**< Conversion streams in the pool right now. */
+} Sound_PoolStats;
+
+
+/**
+ * \struct Sound_CacheStats
+ * \brief How well the decoded-audio cache is doing.
+ *
+ * A "hit" is a Sound_NewSampleFromFile() or Sound_NewSampleFromMem() call
+ *  that found the sample already decoded, a "miss" is one that didn't.
+ *  Opens that couldn't be cached at all aren't counted.
+ *
+ * \sa Sound_SetCacheLimit
+ * \sa Sound_GetCacheStats
+ */
+typedef struct
+{
+    Uint64 hits;            /**< Opens that came out of the cache. */
+    Uint64 misses;          /**< Opens that had to go to the decoder. */
+    Uint64 evictions;       /**< Samples dropped to stay under the limit. */
+    Uint64 cached_bytes;    /**< Decoded audio in the cache right now. */
+    Uint32 cached_samples;  /**< Samples in the cache right now. */
+} Sound_CacheStats;
+
+
+/**
+ * \def SOUND_STATS_HISTOGRAM_SIZE
+ * \brief Number of buckets in Sound_SampleStats::decoder_histogram.
+ */
+#define SOUND_STATS_HISTOGRAM_SIZE 16
+
+/**
+ * \struct Sound_SampleStats
+ * \brief Where a sample's time went.
+ *
+ * "Decoder" numbers cover the format decoder itself: reading the file and
+ *  turning it into PCM in sample->actual's format. "Convert" is everything
+ *  after that, to get to sample->desired: format and channel changes and
+ *  resampling. Seek times include any decoding a seek has to do to land on
+ *  the right frame.
+ *
+ * decoder_histogram counts decoder calls by how long they took: bucket 0 is
+ *  under a microsecond, bucket N is at least 2^(N-1) and under 2^N
+ *  microseconds, and the last bucket gets everything slower than that.
+ *
+ * \sa Sound_SetStatsEnabled
+ * \sa Sound_GetSampleStats
+ */
+typedef struct
+{
+    Uint64 open_ns;         /**< Time spent in decoders' open methods. */
+    Uint32 open_attempts;   /**< Decoders tried before one took the data. */
+    Uint64 decode_calls;    /**< Sound_Decode() and Sound_DecodeInto() calls. */
+    Uint64 decoder_calls;   /**< Times we called into the decoder. */
+    Uint64 decoder_ns;      /**< Time spent in the decoder. */
+    Uint64 convert_ns;      /**< Time spent converting decoded audio. */
+    Uint64 bytes_decoded;   /**< Bytes from the decoder, in sample->actual. */
+    Uint64 bytes_output;    /**< Bytes handed to the app, in sample->desired. */
+    Uint64 eagain_count;    /**< Decoder calls that ended in EAGAIN. */
+    Uint64 seeks;           /**< Successful rewinds and seeks. */
+    Uint64 seek_ns;         /**< Time spent in those. */
+    Uint64 decoder_histogram[SOUND_STATS_HISTOGRAM_SIZE];  /**< See above. */
+} Sound_SampleStats;
+
+
 /* functions and macros... */
 
 /**
@@ -264,6 +391,11 @@ SNDDECLSPEC void SDLCALL Sound_GetLinkedVersion(Sound_Version *ver);
  *  This is a safe behaviour, but it may not configure SDL to your liking by
  *  itself.
  *
+ * SDL_sound uses whatever SIMD SDL says the CPU has. To limit that, say to
+ *  benchmark or to rule it out while chasing a bug, set the SDL_SOUND_SIMD
+ *  environment variable to "none", "sse2", "sse41" or "neon" before calling
+ *  this.
+ *
  * \return nonzero on success, zero on error. Specifics of the
  *         error can be gleaned from Sound_GetError().
  *
@@ -448,6 +580,10 @@ SNDDECLSPEC Sound_Sample * SDLCALL Sound_NewSample(SDL_RWops *rw,
  * This can pool RWops structures, so it may fragment the heap less over time
  *  than using SDL_RWFromMem().
  *
+ * If the decoded-audio cache is on (see Sound_SetCacheLimit()), samples
+ *  opened this way can come out of it. Memory is matched by its contents,
+ *  not its address, so this hashes all (size) bytes on every open.
+ *
  *    \param data Buffer of data holding contents of an audio file to decode.
  *    \param size Size, in bytes, of buffer pointed to by (data).
  *    \param ext File extension normally associated with a data format.
@@ -488,6 +624,17 @@ SNDDECLSPEC Sound_Sample * SDLCALL Sound_NewSampleFromMem(const Uint8 *data,
  * This can pool RWops structures, so it may fragment the heap less over time
  *  than using SDL_RWFromFile().
  *
+ * If you've turned on Sound_SetMapFiles(), and the platform allows it, the
+ *  file is mapped into memory rather than read, and decoders that can work
+ *  from memory (MP3 and FLAC, for now) do so directly. The same goes for
+ *  samples from Sound_NewSampleFromMem(), or Sound_NewSample() with a memory
+ *  RWops.
+ *
+ * If the decoded-audio cache is on (see Sound_SetCacheLimit()), samples
+ *  opened this way can come out of it. Files are matched by path, size and
+ *  modification time; if the platform can't tell us those (like Android
+ *  assets), the file is read and matched by its contents instead.
+ *
  *    \param filename file containing sound data.
  *    \param desired Format to convert sound data into. Can usually be NULL,
  *                   if you don't need conversion.
@@ -601,6 +748,36 @@ SNDDECLSPEC int SDLCALL Sound_SetBufferSize(Sound_Sample *sample,
 SNDDECLSPEC Uint32 SDLCALL Sound_Decode(Sound_Sample *sample);
 
 
+/**
+ * \fn Uint32 Sound_DecodeInto(Sound_Sample *sample, void *buffer, Uint32 len)
+ * \brief Decode more of the sound data into memory you provide.
+ *
+ * This is just like Sound_Decode(), but the decoded data lands in (buffer)
+ *  instead of sample->buffer, and sample->buffer is left alone. It will
+ *  decode at most (len) bytes in the desired format, rounded down to a
+ *  whole number of sample frames.
+ *
+ * When no conversion is needed, many decoders (RAW, WAV, AU, FLAC) can write
+ *  straight into (buffer), skipping the copy you'd otherwise make out of
+ *  sample->buffer. When conversion is needed, the converted data still goes
+ *  straight to (buffer). Other decoders fall back to decoding internally
+ *  and copying, so this is never slower than Sound_Decode() plus a memcpy.
+ *
+ * You can mix calls to this and Sound_Decode() on the same sample.
+ *
+ *    \param sample Do more decoding to this Sound_Sample.
+ *    \param buffer Where to put the decoded data.
+ *    \param len Size of (buffer) in bytes.
+ *   \return number of bytes decoded into (buffer). If it is less than (len),
+ *           then you should check sample->flags to see what the current
+ *           state of the sample is (EOF, error, read again).
+ *
+ * \sa Sound_Decode
+ */
+SNDDECLSPEC Uint32 SDLCALL Sound_DecodeInto(Sound_Sample *sample, void *buffer,
+                                            Uint32 len);
+
+
 /**
  * \fn Uint32 Sound_DecodeAll(Sound_Sample *sample)
  * \brief Decode the remainder of the sound data in a Sound_Sample.
@@ -617,14 +794,19 @@ SNDDECLSPEC Uint32 SDLCALL Sound_Decode(Sound_Sample *sample);
  *  memory before giving up...be sure to use this on finite sound sources
  *  only!
  *
- * When decoding the sample in its entirety, the work is done one buffer at a
- *  time. That is, sound is decoded in sample->buffer_size blocks, and
- *  appended to a continually-growing buffer until the decoding completes.
- *  That means that this function will need enough RAM to hold approximately
- *  sample->buffer_size bytes plus the complete decoded sample at most. The
- *  larger your buffer size, the less overhead this function needs, but beware
- *  the possibility of paging to disk. Best to make this user-configurable if
- *  the sample isn't specific and small.
+ * When the decoder knows the sample's duration, the final buffer is
+ *  allocated up front and the sound is decoded straight into it. Otherwise,
+ *  the buffer starts at a few times sample->buffer_size and doubles whenever
+ *  it fills up, so at worst this needs about twice the size of the decoded
+ *  sample. Either way, the new buffer may be somewhat bigger than
+ *  sample->buffer_size says; use Sound_DecodeAllEx() with
+ *  SOUND_DECODEALL_TRIM if you need that memory back.
+ *
+ * If the decoded-audio cache is on (see Sound_SetCacheLimit()),
+ *  sample->buffer may be the cached copy, shared with other samples.
+ *  Don't write to it! Decoding a sample from the start puts it in the
+ *  cache, and doing it again on that sample, or any sample opened from the
+ *  same file, just hands the cached copy out without decoding anything.
  *
  *    \param sample Do all decoding for this Sound_Sample.
  *   \return number of bytes decoded into sample->buffer. You should check
@@ -637,6 +819,65 @@ SNDDECLSPEC Uint32 SDLCALL Sound_Decode(Sound_Sample *sample);
 SNDDECLSPEC Uint32 SDLCALL Sound_DecodeAll(Sound_Sample *sample);
 
 
+/**
+ * \def SOUND_DECODEALL_TRIM
+ * \brief Flag for Sound_DecodeAllEx(): shrink the buffer to fit.
+ */
+#define SOUND_DECODEALL_TRIM (1 << 0)
+
+/**
+ * \fn Uint32 Sound_DecodeAllEx(Sound_Sample *sample, Uint32 flags)
+ * \brief Decode the remainder of the sound data, with options.
+ *
+ * This is Sound_DecodeAll(), but with (flags). Right now, the only flag is
+ *  SOUND_DECODEALL_TRIM, which reallocates the finished buffer to exactly
+ *  the number of bytes decoded. That costs one more reallocation (and maybe
+ *  a copy), so only ask for it if you're keeping the sample around.
+ *
+ *    \param sample Do all decoding for this Sound_Sample.
+ *    \param flags Zero, or SOUND_DECODEALL_TRIM.
+ *   \return number of bytes decoded into sample->buffer. You should check
+ *           sample->flags to see what the current state of the sample is
+ *           (EOF, error, read again).
+ *
+ * \sa Sound_DecodeAll
+ */
+SNDDECLSPEC Uint32 SDLCALL Sound_DecodeAllEx(Sound_Sample *sample,
+                                             Uint32 flags);
+
+
+/**
+ * \fn Uint32 Sound_DecodeAllParallel(Sound_Sample *sample, int threads)
+ * \brief Decode an entire sample, using several threads.
+ *
+ * This rewinds the sample and decodes the whole thing, like
+ *  Sound_Rewind() followed by Sound_DecodeAll(), but it splits the work
+ *  across (threads) threads. Each thread opens its own copy of the sample
+ *  and decodes one stretch of it, and the pieces are stitched back together.
+ *  The result is byte-for-byte what Sound_DecodeAll() would have given you.
+ *
+ * This only splits the work when it can do that exactly: the sample must
+ *  come from Sound_NewSampleFromFile() or Sound_NewSampleFromMem() (so it
+ *  can be opened again), the decoder must be able to jump straight to an
+ *  exact sample frame (WAV, AIFF, AU, RAW, FLAC, Ogg Vorbis, and Shorten
+ *  files with a seek table, currently; not MP3, which has to decode its way
+ *  there), the duration must be known, and you can't be asking for a different sample
+ *  rate. Otherwise, this quietly does a normal Sound_DecodeAll() on the
+ *  calling thread.
+ *
+ *    \param sample Do all decoding for this Sound_Sample.
+ *    \param threads Number of threads to use, or zero for one per CPU.
+ *                   Asking for more than one per CPU gets one per CPU.
+ *   \return number of bytes decoded into sample->buffer. You should check
+ *           sample->flags to see what the current state of the sample is
+ *           (EOF, error, read again).
+ *
+ * \sa Sound_DecodeAll
+ */
+SNDDECLSPEC Uint32 SDLCALL Sound_DecodeAllParallel(Sound_Sample *sample,
+                                                   int threads);
+
+
 /**
  * \fn int Sound_Rewind(Sound_Sample *sample)
  * \brief Rewind a sample to the start.
@@ -712,9 +953,255 @@ SNDDECLSPEC int SDLCALL Sound_Rewind(Sound_Sample *sample);
  *           error can be gleaned from Sound_GetError().
  *
  * \sa Sound_Rewind
+ * \sa Sound_SeekFrames
  */
 SNDDECLSPEC int SDLCALL Sound_Seek(Sound_Sample *sample, Uint32 ms);
 
+
+/**
+ * \fn int Sound_SeekFrames(Sound_Sample *sample, Uint64 frame)
+ * \brief Seek to an exact sample frame.
+ *
+ * This is Sound_Seek() for when milliseconds aren't precise enough: loop
+ *  points, crossfades, and anything else that has to line up exactly.
+ *  (frame) counts sample frames at sample->actual.rate from the start of
+ *  the sample; when the sample isn't resampled, that's the same as counting
+ *  the frames Sound_Decode() gives you.
+ *
+ * The WAV, AIFF, AU, RAW, FLAC, MP3, Shorten and Ogg Vorbis decoders seek
+ *  exactly to the frame. Other seekable decoders use their Sound_Seek()
+ *  support to get to the millisecond before it and decode forward from
+ *  there, so they're only as exact as that is: VOC lands where it should,
+ *  but ModPlug and MIDI seek in coarser steps of their own (pattern rows,
+ *  MIDI events), so with those the position is approximate.
+ *
+ * The same rules as Sound_Seek() apply: check SOUND_SAMPLEFLAG_CANSEEK
+ *  first, and on success, ERROR, EOF, and EAGAIN are cleared from
+ *  sample->flags.
+ *
+ *    \param sample The Sound_Sample to seek.
+ *    \param frame The new position, in sample frames from start of sample.
+ *   \return nonzero on success, zero on error. Specifics of the
+ *           error can be gleaned from Sound_GetError().
+ *
+ * \sa Sound_Seek
+ * \sa Sound_TellFrames
+ */
+SNDDECLSPEC int SDLCALL Sound_SeekFrames(Sound_Sample *sample, Uint64 frame);
+
+
+/**
+ * \fn Sint64 Sound_TellFrames(Sound_Sample *sample)
+ * \brief Get the position of the next sample frame Sound_Decode() returns.
+ *
+ * This counts sample frames at sample->actual.rate from the start of the
+ *  sample, like Sound_SeekFrames(), and follows Sound_Decode(),
+ *  Sound_Seek(), Sound_SeekFrames() and Sound_Rewind(). It's exact unless
+ *  the sample is being resampled, in which case it can be ahead by the few
+ *  milliseconds the resampler is holding on to.
+ *
+ *    \param sample The Sound_Sample to query.
+ *   \return The position in sample frames, or -1 on error.
+ *
+ * \sa Sound_SeekFrames
+ */
+SNDDECLSPEC Sint64 SDLCALL Sound_TellFrames(Sound_Sample *sample);
+
+
+/**
+ * \fn void Sound_SetStatsEnabled(int enabled)
+ * \brief Turn per-sample decode stats on or off.
+ *
+ * This only affects samples opened after the call; a sample collects stats
+ *  for its whole life or not at all. It's off by default. The cost, when it's
+ *  on, is a couple of SDL_GetPerformanceCounter() calls per decoder call, so
+ *  it's fine to leave on in shipping code if you want the numbers.
+ *
+ *    \param enabled Non-zero to collect stats for new samples, zero to stop.
+ *
+ * \sa Sound_GetSampleStats
+ */
+SNDDECLSPEC void SDLCALL Sound_SetStatsEnabled(int enabled);
+
+
+/**
+ * \fn void Sound_SetMapFiles(int enabled)
+ * \brief Let Sound_NewSampleFromFile() map files into memory.
+ *
+ * A mapped file doesn't have to be read through an SDL_RWops at all, and
+ *  the MP3 and FLAC decoders work on it in place, which makes opening and
+ *  decoding cheaper. The catch is that if something truncates or rewrites
+ *  the file while a sample is using it, your process can crash (SIGBUS on
+ *  most Unix systems) instead of getting a read error. So it's off by
+ *  default; only turn it on if you know your files won't change underneath
+ *  you. It only affects samples opened after the call, and does nothing on
+ *  platforms that can't map files.
+ *
+ *    \param enabled Non-zero to map files opened from now on, zero to read
+ *                   them normally.
+ *
+ * \sa Sound_NewSampleFromFile
+ */
+SNDDECLSPEC void SDLCALL Sound_SetMapFiles(int enabled);
+
+
+/**
+ * \fn int Sound_GetSampleStats(Sound_Sample *sample, Sound_SampleStats *stats)
+ * \brief Get the decode stats for a sample.
+ *
+ * The counters start at zero when the sample is opened and only ever go up.
+ *  Samples opened while Sound_SetStatsEnabled() was off don't have any, and
+ *  this fails for them.
+ *
+ *    \param sample The Sound_Sample to query.
+ *    \param stats Filled in with the current numbers.
+ *   \return non-zero on success, zero on error. Specifics of the error can be
+ *           gleaned from Sound_GetError().
+ *
+ * \sa Sound_SetStatsEnabled
+ */
+SNDDECLSPEC int SDLCALL Sound_GetSampleStats(Sound_Sample *sample,
+                                             Sound_SampleStats *stats);
+
+
+/**
+ * \fn void Sound_SetPoolLimits(const Sound_PoolLimits *limits)
+ * \brief Change how much SDL_sound keeps around for reuse.
+ *
+ * The defaults keep 64 samples, 64 decode buffers of up to 256 kilobytes
+ *  each, and 16 conversion streams. If the new limits are smaller than what
+ *  is pooled right now, the excess is freed immediately. You can call this
+ *  before Sound_Init(), and the limits survive Sound_Quit(), but the pools
+ *  themselves are emptied by Sound_Quit().
+ *
+ *    \param limits The new limits. NULL restores the defaults.
+ *
+ * \sa Sound_GetPoolLimits
+ * \sa Sound_GetPoolStats
+ */
+SNDDECLSPEC void SDLCALL Sound_SetPoolLimits(const Sound_PoolLimits *limits);
+
+
+/**
+ * \fn void Sound_GetPoolLimits(Sound_PoolLimits *limits)
+ * \brief Get the current pool limits.
+ *
+ *    \param limits Filled in with the current limits.
+ *
+ * \sa Sound_SetPoolLimits
+ */
+SNDDECLSPEC void SDLCALL Sound_GetPoolLimits(Sound_PoolLimits *limits);
+
+
+/**
+ * \fn void Sound_GetPoolStats(Sound_PoolStats *stats)
+ * \brief Get hit/miss counts for the sample pools.
+ *
+ * The counters start at zero at Sound_Init() and only ever go up.
+ *
+ *    \param stats Filled in with the current counts.
+ *
+ * \sa Sound_SetPoolLimits
+ */
+SNDDECLSPEC void SDLCALL Sound_GetPoolStats(Sound_PoolStats *stats);
+
+
+/**
+ * \fn void Sound_SetCacheLimit(Uint64 max_bytes)
+ * \brief Turn on the decoded-audio cache, and set how big it can get.
+ *
+ * If your app opens the same sounds again and again, SDL_sound can keep
+ *  them around after they're decoded. Samples opened with
+ *  Sound_NewSampleFromFile() or Sound_NewSampleFromMem(), in the format they
+ *  were asked for, go in the cache when Sound_DecodeAll() (or one of its
+ *  variants) decodes them from the start. After that, opening the same thing
+ *  in the same format doesn't touch the decoder, or the file, at all:
+ *  Sound_DecodeAll() gives you a pointer to the cached copy, and
+ *  Sound_Decode() copies out of it.
+ *
+ * Samples that switch to a non-default Sound_SetResampleMode() aren't
+ *  cached, and samples opened with Sound_NewSample() can't be, since we
+ *  can't tell where the data came from.
+ *
+ * When the cache is full, the least recently opened samples are dropped.
+ *  Samples still using them keep working, and the memory is freed when the
+ *  last of them is. The cache is off (zero bytes) by default, and it's
+ *  emptied by Sound_Quit(), but the limit survives it.
+ *
+ *    \param max_bytes The most decoded audio to keep, in bytes. Zero turns
+ *                     the cache off and empties it.
+ *
+ * \sa Sound_GetCacheLimit
+ * \sa Sound_GetCacheStats
+ */
+SNDDECLSPEC void SDLCALL Sound_SetCacheLimit(Uint64 max_bytes);
+
+
+/**
+ * \fn Uint64 Sound_GetCacheLimit(void)
+ * \brief Get the current size limit of the decoded-audio cache.
+ *
+ *   \return The most decoded audio the cache keeps, in bytes. Zero means the
+ *           cache is off.
+ *
+ * \sa Sound_SetCacheLimit
+ */
+SNDDECLSPEC Uint64 SDLCALL Sound_GetCacheLimit(void);
+
+
+/**
+ * \fn void Sound_GetCacheStats(Sound_CacheStats *stats)
+ * \brief Get hit/miss counts for the decoded-audio cache.
+ *
+ * The counters start at zero at Sound_Init() and only ever go up.
+ *
+ *    \param stats Filled in with the current counts.
+ *
+ * \sa Sound_SetCacheLimit
+ */
+SNDDECLSPEC void SDLCALL Sound_GetCacheStats(Sound_CacheStats *stats);
+
+
+/**
+ * \fn int Sound_SetResampleMode(Sound_Sample *sample, Sound_ResampleMode mode)
+ * \brief Choose how a sample converts to its desired rate.
+ *
+ * New samples use SOUND_RESAMPLE_DEFAULT. This has no effect on samples that
+ *  don't need a rate change, except SOUND_RESAMPLE_NONE, which makes any
+ *  sample keep its native rate: sample->desired.rate is set to match
+ *  sample->actual.rate, and changing back to another mode restores the rate
+ *  you asked for in Sound_NewSample().
+ *
+ * SDL_sound's own resamplers (SOUND_RESAMPLE_LINEAR and SOUND_RESAMPLE_SINC)
+ *  handle mono and stereo data; samples with more channels than that still
+ *  go through SDL_AudioStream.
+ *
+ * It's best to call this right after creating the sample. If you change it
+ *  later, any converted audio that hasn't been returned by Sound_Decode()
+ *  yet is dropped, which is a few milliseconds at most.
+ *
+ *    \param sample The Sound_Sample to change.
+ *    \param mode The new resampling mode.
+ *   \return non-zero on success, zero on error. On error, the sample keeps
+ *           its previous mode, and Sound_GetError() explains what happened.
+ *
+ * \sa Sound_GetResampleMode
+ */
+SNDDECLSPEC int SDLCALL Sound_SetResampleMode(Sound_Sample *sample,
+                                              Sound_ResampleMode mode);
+
+
+/**
+ * \fn Sound_ResampleMode Sound_GetResampleMode(Sound_Sample *sample)
+ * \brief Get the resampling mode of a sample.
+ *
+ *    \param sample The Sound_Sample to query.
+ *   \return The mode last set with Sound_SetResampleMode().
+ *
+ * \sa Sound_SetResampleMode
+ */
+SNDDECLSPEC Sound_ResampleMode SDLCALL Sound_GetResampleMode(Sound_Sample *sample);
+
 #ifdef __cplusplus
 }
 #endif
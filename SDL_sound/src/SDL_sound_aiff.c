@@ -44,7 +44,7 @@ typedef struct S_AIFF_FMT_T
     void (*free)(struct S_AIFF_FMT_T *fmt);
     Uint32 (*read_sample)(Sound_Sample *sample);
     int (*rewind_sample)(Sound_Sample *sample);
-    int (*seek_sample)(Sound_Sample *sample, Uint32 ms);
+    int (*seek_sample_frame)(Sound_Sample *sample, Uint64 frame);
 
 
 #if 0
@@ -295,18 +295,22 @@ static int rewind_sample_fmt_normal(Sound_Sample *sample)
 } /* rewind_sample_fmt_normal */
 
 
-static int seek_sample_fmt_normal(Sound_Sample *sample, Uint32 ms)
+static int seek_sample_frame_fmt_normal(Sound_Sample *sample, Uint64 frame)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     aiff_t *a = (aiff_t *) internal->decoder_private;
     const fmt_t *fmt = &a->fmt;
-    const Uint32 offset = __Sound_convertMsToBytePos(&sample->actual, ms);
+    const Uint32 framesize = ((sample->actual.format & 0xFF) / 8) * sample->actual.channels;
+    const Sint64 offset = (Sint64) (frame * framesize);
     const Sint64 pos = (Sint64) (fmt->data_starting_offset + offset);
-    const Sint64 rc = SDL_RWseek(internal->rw, pos, RW_SEEK_SET);
+    Sint64 rc;
+
+    BAIL_IF_MACRO(offset > fmt->total_bytes, ERR_INVALID_ARGUMENT, 0);
+    rc = SDL_RWseek(internal->rw, pos, RW_SEEK_SET);
     BAIL_IF_MACRO(rc != pos, ERR_IO_ERROR, 0);
-    a->bytesLeft = fmt->total_bytes - offset;
+    a->bytesLeft = (Sint32) (fmt->total_bytes - offset);
     return 1;  /* success. */
-} /* seek_sample_fmt_normal */
+} /* seek_sample_frame_fmt_normal */
 
 
 static void free_fmt_normal(fmt_t *fmt)
@@ -321,7 +325,7 @@ static int read_fmt_normal(SDL_RWops *rw, fmt_t *fmt)
     fmt->free = free_fmt_normal;
     fmt->read_sample = read_sample_fmt_normal;
     fmt->rewind_sample = rewind_sample_fmt_normal;
-    fmt->seek_sample = seek_sample_fmt_normal;
+    fmt->seek_sample_frame = seek_sample_frame_fmt_normal;
     return 1;
 } /* read_fmt_normal */
 
@@ -469,6 +473,7 @@ static int AIFF_open(Sound_Sample *sample, const char *ext)
     internal->decoder_private = (void *) a;
 
     sample->flags = SOUND_SAMPLEFLAG_CANSEEK;
+    internal->fast_seek_frame = SDL_TRUE;
 
     SNDDBG(("AIFF: Accepting data stream.\n"));
     return 1; /* we'll handle this data. */
@@ -504,11 +509,17 @@ static int AIFF_rewind(Sound_Sample *sample)
 } /* AIFF_rewind */
 
 
-static int AIFF_seek(Sound_Sample *sample, Uint32 ms)
+static int AIFF_seek_frame(Sound_Sample *sample, Uint64 frame)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     aiff_t *a = (aiff_t *) internal->decoder_private;
-    return a->fmt.seek_sample(sample, ms);
+    return a->fmt.seek_sample_frame(sample, frame);
+} /* AIFF_seek_frame */
+
+
+static int AIFF_seek(Sound_Sample *sample, Uint32 ms)
+{
+    return AIFF_seek_frame(sample, __Sound_convertMsToFrames(sample->actual.rate, ms));
 } /* AIFF_seek */
 
 static const char *extensions_aiff[] = { "AIFF", "AIF", NULL };
@@ -527,7 +538,9 @@ const Sound_DecoderFunctions __Sound_DecoderFunctions_AIFF =
     AIFF_close,     /*  close() method */
     AIFF_read,      /*   read() method */
     AIFF_rewind,    /* rewind() method */
-    AIFF_seek       /*   seek() method */
+    AIFF_seek,      /*   seek() method */
+    NULL,           /* read_into() method */
+    AIFF_seek_frame /* seek_frame() method */
 };
 
 
@@ -195,6 +195,7 @@ static int AU_open(Sound_Sample *sample, const char *ext)
                               bytes_per_second ) );
 
     sample->flags = SOUND_SAMPLEFLAG_CANSEEK;
+    internal->fast_seek_frame = SDL_TRUE;
     dec->total = dec->remaining;
     dec->start_offset = SDL_RWtell(rw);
 
@@ -248,7 +249,7 @@ static Sint16 ulaw_to_linear[256] = {
 };
 
 
-static Uint32 AU_read(Sound_Sample *sample)
+static Uint32 AU_read_into(Sound_Sample *sample, void *buffer, Uint32 len)
 {
     int ret;
     Sound_SampleInternal *internal = sample->opaque;
@@ -256,8 +257,8 @@ static Uint32 AU_read(Sound_Sample *sample)
     int maxlen;
     Uint8 *buf;
 
-    maxlen = internal->buffer_size;
-    buf = internal->buffer;
+    maxlen = (int) len;
+    buf = (Uint8 *) buffer;
     if (dec->encoding == AU_ENC_ULAW_8)
     {
         /* We read µ-law samples into the second half of the buffer, so
@@ -282,7 +283,7 @@ static Uint32 AU_read(Sound_Sample *sample)
         if (dec->encoding == AU_ENC_ULAW_8)
         {
             int i;
-            Sint16 *dst = internal->buffer;
+            Sint16 *dst = (Sint16 *) buffer;
             for (i = 0; i < ret; i++)
                 dst[i] = ulaw_to_linear[buf[i]];
             ret <<= 1;                  /* return twice as much as read */
@@ -290,6 +291,13 @@ static Uint32 AU_read(Sound_Sample *sample)
     } /* else */
 
     return ret;
+} /* AU_read_into */
+
+
+static Uint32 AU_read(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = sample->opaque;
+    return AU_read_into(sample, internal->buffer, internal->buffer_size);
 } /* AU_read */
 
 
@@ -304,22 +312,30 @@ static int AU_rewind(Sound_Sample *sample)
 } /* AU_rewind */
 
 
-static int AU_seek(Sound_Sample *sample, Uint32 ms)
+static int AU_seek_frame(Sound_Sample *sample, Uint64 frame)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     struct audec *dec = (struct audec *) internal->decoder_private;
-    Sint64 offset = __Sound_convertMsToBytePos(&sample->actual, ms);
+    const Uint32 framesize = ((sample->actual.format & 0xFF) / 8) * sample->actual.channels;
+    Sint64 offset = (Sint64) (frame * framesize);
     Sint64 rc;
     Sint64 pos;
 
     if (dec->encoding == AU_ENC_ULAW_8)
         offset >>= 1;  /* halve the byte offset for compression. */
 
+    BAIL_IF_MACRO(offset > (Sint64) dec->total, ERR_INVALID_ARGUMENT, 0);
     pos = (dec->start_offset + offset);
     rc = SDL_RWseek(internal->rw, pos, RW_SEEK_SET);
     BAIL_IF_MACRO(rc != pos, ERR_IO_ERROR, 0);
-    dec->remaining = dec->total - offset;
+    dec->remaining = dec->total - (Uint32) offset;
     return 1;
+} /* AU_seek_frame */
+
+
+static int AU_seek(Sound_Sample *sample, Uint32 ms)
+{
+    return AU_seek_frame(sample, __Sound_convertMsToFrames(sample->actual.rate, ms));
 } /* AU_seek */
 
 /*
@@ -343,7 +359,9 @@ const Sound_DecoderFunctions __Sound_DecoderFunctions_AU =
     AU_close,       /*  close() method */
     AU_read,        /*   read() method */
     AU_rewind,      /* rewind() method */
-    AU_seek         /*   seek() method */
+    AU_seek,        /*   seek() method */
+    AU_read_into,   /* read_into() method */
+    AU_seek_frame   /* seek_frame() method */
 };
 
 #endif /* SOUND_SUPPORTS_AU */
@@ -0,0 +1,633 @@
+/**
+ * SDL_sound; An abstract sound format decoding API.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+/*
+ * The decoded-audio cache, for apps that open the same few files over and
+ *  over (see Sound_SetCacheLimit()).
+ *
+ * A sample opened with Sound_NewSampleFromFile() or Sound_NewSampleFromMem()
+ *  gets a key: the file's path, size and modification time (or, if we can't
+ *  stat it, or it came from memory, a hash of its contents), the extension,
+ *  and the format the app asked for. When that sample is decoded in one go
+ *  by Sound_DecodeAll*(), the result goes in the cache under that key, and
+ *  the next open with the same key skips the decoder completely: the new
+ *  sample reads from the cached audio with the "decoder" at the bottom of
+ *  this file, and Sound_DecodeAll() on it just hands out a pointer.
+ *
+ * Entries are refcounted, since any number of samples can be pointing into
+ *  one. When the cache goes over its limit, the least recently used entries
+ *  are dropped from the table right away, but their memory isn't freed
+ *  until the last sample using them is.
+ */
+
+/* (before SDL_sound_internal.h, so stat() doesn't get hidden visibility.) */
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#define __SDL_SOUND_INTERNAL__
+#include "SDL_sound_internal.h"
+
+#define CACHE_MIN_BUCKETS 64
+#define CACHE_HASH_CHUNK (64 * 1024)
+
+struct __SOUND_CACHEKEY__
+{
+    Uint32 hash;            /* of everything below, for the table. */
+    char *fname;            /* NULL if we hashed the contents instead. */
+    char *ext;              /* NULL if the app didn't give us one. */
+    Sint64 size;
+    Sint64 mtime;
+    Uint64 content_hash;
+    Sound_AudioInfo desired;
+};
+
+struct __SOUND_CACHEENTRY__
+{
+    Sound_CacheKey *key;
+    Uint8 *data;
+    Uint32 len;
+    Sound_AudioInfo info;
+    const Sound_DecoderInfo *decoder;
+    Uint32 refcount;
+    SDL_bool cached;                /* still in the table? */
+    Sound_CacheEntry *hash_next;
+    Sound_CacheEntry *lru_prev;     /* more recently used. */
+    Sound_CacheEntry *lru_next;     /* less recently used. */
+};
+
+static Uint64 cache_limit = 0;
+static Sound_CacheStats cache_stats;
+static SDL_mutex *cache_mutex = NULL;
+static Sound_CacheEntry **buckets = NULL;
+static Uint32 num_buckets = 0;
+static Sound_CacheEntry *lru_head = NULL;
+static Sound_CacheEntry *lru_tail = NULL;
+
+
+/* 64-bit FNV-1a. (hash) is the running value; start with FNV64_INIT. */
+#define FNV64_INIT 0xCBF29CE484222325ULL
+
+static Uint64 hash_bytes(Uint64 hash, const void *_data, size_t len)
+{
+    const Uint8 *data = (const Uint8 *) _data;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001B3ULL;
+    } /* for */
+
+    return hash;
+} /* hash_bytes */
+
+
+static Uint64 hash_string(Uint64 hash, const char *str)
+{
+    if (str == NULL)
+        return hash_bytes(hash, "", 1);
+    return hash_bytes(hash, str, SDL_strlen(str) + 1);
+} /* hash_string */
+
+
+static void free_key(Sound_CacheKey *key)
+{
+    if (key != NULL)
+    {
+        SDL_free(key->fname);
+        SDL_free(key->ext);
+        SDL_free(key);
+    } /* if */
+} /* free_key */
+
+
+static int keys_equal(const Sound_CacheKey *a, const Sound_CacheKey *b)
+{
+    if ( (a->hash != b->hash) ||
+         (a->size != b->size) ||
+         (a->mtime != b->mtime) ||
+         (a->content_hash != b->content_hash) ||
+         (a->desired.format != b->desired.format) ||
+         (a->desired.channels != b->desired.channels) ||
+         (a->desired.rate != b->desired.rate) )
+    {
+        return 0;
+    } /* if */
+
+    if ((a->fname == NULL) != (b->fname == NULL))
+        return 0;
+    else if ((a->fname != NULL) && (SDL_strcmp(a->fname, b->fname) != 0))
+        return 0;
+
+    if ((a->ext == NULL) != (b->ext == NULL))
+        return 0;
+    else if ((a->ext != NULL) && (SDL_strcasecmp(a->ext, b->ext) != 0))
+        return 0;
+
+    return 1;
+} /* keys_equal */
+
+
+/* Path, size and modification time, if the platform can tell us. */
+static int stat_file(const char *fname, Sint64 *size, Sint64 *mtime)
+{
+#ifdef _WIN32
+    /* SDL_RWFromFile() takes UTF-8 here, but stat() wants the codepage. */
+    struct _stat64 statbuf;
+    wchar_t *wfname = (wchar_t *) SDL_iconv_string("UTF-16LE", "UTF-8", fname,
+                                                   SDL_strlen(fname) + 1);
+    const int rc = (wfname != NULL) ? _wstat64(wfname, &statbuf) : -1;
+    SDL_free(wfname);
+    if (rc != 0)
+        return 0;
+#else
+    struct stat statbuf;
+
+    if (stat(fname, &statbuf) != 0)
+        return 0;
+#endif
+
+    *size = (Sint64) statbuf.st_size;
+    *mtime = (Sint64) statbuf.st_mtime;
+    return 1;
+} /* stat_file */
+
+
+/*
+ * Hash everything in (rw). That's still a lot cheaper than decoding it.
+ *  Returns zero on i/o error.
+ */
+static int hash_rwops(SDL_RWops *rw, Uint64 *hash, Sint64 *size)
+{
+    Uint8 *buf = (Uint8 *) SDL_malloc(CACHE_HASH_CHUNK);
+    Uint64 h = FNV64_INIT;
+    Sint64 total = 0;
+    size_t br;
+
+    BAIL_IF_MACRO(buf == NULL, ERR_OUT_OF_MEMORY, 0);
+
+    while ((br = SDL_RWread(rw, buf, 1, CACHE_HASH_CHUNK)) > 0)
+    {
+        h = hash_bytes(h, buf, br);
+        total += (Sint64) br;
+    } /* while */
+
+    SDL_free(buf);
+    *hash = h;
+    *size = total;
+    return 1;
+} /* hash_rwops */
+
+
+Sound_CacheKey *__Sound_CreateCacheKey(const char *fname, const Uint8 *data,
+                                       Uint32 size, const char *ext,
+                                       const Sound_AudioInfo *desired)
+{
+    Sound_CacheKey *key;
+    Uint64 hash;
+    int okay = 1;
+
+    SDL_LockMutex(cache_mutex);
+    okay = (cache_limit > 0);
+    SDL_UnlockMutex(cache_mutex);
+    if (!okay)
+        return NULL;  /* cache is off. */
+
+    key = (Sound_CacheKey *) SDL_calloc(1, sizeof (Sound_CacheKey));
+    BAIL_IF_MACRO(key == NULL, ERR_OUT_OF_MEMORY, NULL);
+
+    if (desired != NULL)
+        SDL_memcpy(&key->desired, desired, sizeof (Sound_AudioInfo));
+
+    if ((ext != NULL) && ((key->ext = SDL_strdup(ext)) == NULL))
+        okay = 0;
+
+    else if (data != NULL)
+    {
+        key->size = (Sint64) size;
+        key->content_hash = hash_bytes(FNV64_INIT, data, size);
+    } /* else if */
+
+    else if (stat_file(fname, &key->size, &key->mtime))
+        okay = ((key->fname = SDL_strdup(fname)) != NULL);
+
+    else  /* can't stat it (maybe an Android asset); hash what's in it. */
+    {
+        SDL_RWops *rw = SDL_RWFromFile(fname, "rb");
+        okay = ((rw != NULL) && (hash_rwops(rw, &key->content_hash, &key->size)));
+        if (rw != NULL)
+            SDL_RWclose(rw);
+    } /* else */
+
+    if (!okay)
+    {
+        free_key(key);
+        return NULL;
+    } /* if */
+
+    hash = hash_string(FNV64_INIT, key->fname);
+    hash = hash_bytes(hash, &key->size, sizeof (key->size));
+    hash = hash_bytes(hash, &key->mtime, sizeof (key->mtime));
+    hash = hash_bytes(hash, &key->content_hash, sizeof (key->content_hash));
+    hash = hash_bytes(hash, &key->desired.format, sizeof (key->desired.format));
+    hash = hash_bytes(hash, &key->desired.channels, sizeof (key->desired.channels));
+    hash = hash_bytes(hash, &key->desired.rate, sizeof (key->desired.rate));
+    key->hash = (Uint32) (hash ^ (hash >> 32));  /* (ext is left out; it's case-insensitive.) */
+
+    return key;
+} /* __Sound_CreateCacheKey */
+
+
+void __Sound_DestroyCacheKey(Sound_CacheKey *key)
+{
+    free_key(key);
+} /* __Sound_DestroyCacheKey */
+
+
+static void free_entry(Sound_CacheEntry *entry)
+{
+    free_key(entry->key);
+    __Sound_SIMDFree(entry->data);
+    SDL_free(entry);
+} /* free_entry */
+
+
+/* Take (entry) out of the table and the LRU list. Hold cache_mutex! */
+static void evict_entry(Sound_CacheEntry *entry)
+{
+    Sound_CacheEntry **prev = &buckets[entry->key->hash & (num_buckets - 1)];
+
+    SDL_assert(entry->cached);
+
+    while (*prev != entry)
+        prev = &(*prev)->hash_next;
+    *prev = entry->hash_next;
+
+    if (entry->lru_prev != NULL)
+        entry->lru_prev->lru_next = entry->lru_next;
+    else
+        lru_head = entry->lru_next;
+
+    if (entry->lru_next != NULL)
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        lru_tail = entry->lru_prev;
+
+    entry->hash_next = entry->lru_prev = entry->lru_next = NULL;
+    entry->cached = SDL_FALSE;
+    cache_stats.cached_bytes -= entry->len;
+    cache_stats.cached_samples--;
+    cache_stats.evictions++;
+
+    if (entry->refcount == 0)
+        free_entry(entry);  /* otherwise, the last __Sound_CacheRelease() does. */
+} /* evict_entry */
+
+
+/* Drop the least recently used entries until we fit in (limit). Hold cache_mutex! */
+static void trim_cache(Uint64 limit)
+{
+    while ((lru_tail != NULL) && (cache_stats.cached_bytes > limit))
+        evict_entry(lru_tail);
+} /* trim_cache */
+
+
+/* Make room in the table for one more. Hold cache_mutex! */
+static int grow_buckets(void)
+{
+    Sound_CacheEntry **newbuckets;
+    Uint32 newnum;
+    Uint32 i;
+
+    if (cache_stats.cached_samples < num_buckets)
+        return 1;  /* still plenty of room. */
+
+    newnum = num_buckets ? (num_buckets * 2) : CACHE_MIN_BUCKETS;
+    newbuckets = (Sound_CacheEntry **) SDL_calloc(newnum, sizeof (Sound_CacheEntry *));
+    if (newbuckets == NULL)
+        return (num_buckets > 0);  /* chains get longer, but it still works. */
+
+    for (i = 0; i < num_buckets; i++)
+    {
+        Sound_CacheEntry *entry = buckets[i];
+        while (entry != NULL)
+        {
+            Sound_CacheEntry *next = entry->hash_next;
+            Sound_CacheEntry **bucket = &newbuckets[entry->key->hash & (newnum - 1)];
+            entry->hash_next = *bucket;
+            *bucket = entry;
+            entry = next;
+        } /* while */
+    } /* for */
+
+    SDL_free(buckets);
+    buckets = newbuckets;
+    num_buckets = newnum;
+    return 1;
+} /* grow_buckets */
+
+
+/* Hold cache_mutex! */
+static Sound_CacheEntry *find_entry(const Sound_CacheKey *key)
+{
+    Sound_CacheEntry *entry;
+
+    if (num_buckets == 0)
+        return NULL;
+
+    for (entry = buckets[key->hash & (num_buckets - 1)]; entry; entry = entry->hash_next)
+    {
+        if (keys_equal(entry->key, key))
+            return entry;
+    } /* for */
+
+    return NULL;
+} /* find_entry */
+
+
+/* Hold cache_mutex! */
+static void touch_entry(Sound_CacheEntry *entry)
+{
+    if (entry == lru_head)
+        return;
+
+    /* unlink... */
+    entry->lru_prev->lru_next = entry->lru_next;
+    if (entry->lru_next != NULL)
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        lru_tail = entry->lru_prev;
+
+    /* ...and put it up front. */
+    entry->lru_prev = NULL;
+    entry->lru_next = lru_head;
+    lru_head->lru_prev = entry;
+    lru_head = entry;
+} /* touch_entry */
+
+
+Sound_CacheEntry *__Sound_CacheLookup(const Sound_CacheKey *key)
+{
+    Sound_CacheEntry *retval;
+
+    SDL_LockMutex(cache_mutex);
+    retval = find_entry(key);
+    if (retval == NULL)
+        cache_stats.misses++;
+    else
+    {
+        touch_entry(retval);
+        retval->refcount++;
+        cache_stats.hits++;
+    } /* else */
+    SDL_UnlockMutex(cache_mutex);
+
+    return retval;
+} /* __Sound_CacheLookup */
+
+
+Sound_CacheEntry *__Sound_CacheInsert(Sound_CacheKey *key, void *data,
+                                      Uint32 len, const Sound_Sample *sample)
+{
+    Sound_CacheEntry *entry;
+
+    if (len == 0)
+        return NULL;  /* SDL_RWFromConstMem() won't take zero bytes. */
+
+    entry = (Sound_CacheEntry *) SDL_calloc(1, sizeof (Sound_CacheEntry));
+    BAIL_IF_MACRO(entry == NULL, ERR_OUT_OF_MEMORY, NULL);
+
+    SDL_LockMutex(cache_mutex);
+
+    if ( (((Uint64) len) > cache_limit) ||  /* never going to fit. */
+         (find_entry(key) != NULL) ||       /* someone beat us to it. */
+         (!grow_buckets()) )
+    {
+        SDL_UnlockMutex(cache_mutex);
+        SDL_free(entry);
+        return NULL;
+    } /* if */
+
+    entry->key = key;
+    entry->data = (Uint8 *) data;
+    entry->len = len;
+    SDL_memcpy(&entry->info, &sample->desired, sizeof (Sound_AudioInfo));
+    entry->decoder = sample->decoder;
+    entry->refcount = 1;  /* for the caller. */
+    entry->cached = SDL_TRUE;
+
+    entry->hash_next = buckets[key->hash & (num_buckets - 1)];
+    buckets[key->hash & (num_buckets - 1)] = entry;
+
+    entry->lru_next = lru_head;
+    if (lru_head != NULL)
+        lru_head->lru_prev = entry;
+    else
+        lru_tail = entry;
+    lru_head = entry;
+
+    cache_stats.cached_bytes += len;
+    cache_stats.cached_samples++;
+    trim_cache(cache_limit);  /* can't evict (entry); it's the newest and it fits. */
+
+    SDL_UnlockMutex(cache_mutex);
+
+    return entry;
+} /* __Sound_CacheInsert */
+
+
+void __Sound_CacheRelease(Sound_CacheEntry *entry)
+{
+    if (entry != NULL)
+    {
+        SDL_LockMutex(cache_mutex);
+        SDL_assert(entry->refcount > 0);
+        entry->refcount--;
+        if ((entry->refcount == 0) && (!entry->cached))
+            free_entry(entry);
+        SDL_UnlockMutex(cache_mutex);
+    } /* if */
+} /* __Sound_CacheRelease */
+
+
+const Uint8 *__Sound_CacheData(const Sound_CacheEntry *entry, Uint32 *len,
+                               Sound_AudioInfo *info)
+{
+    /* these never change while anyone holds a reference, so no lock. */
+    if (len != NULL)
+        *len = entry->len;
+    if (info != NULL)
+        SDL_memcpy(info, &entry->info, sizeof (Sound_AudioInfo));
+    return entry->data;
+} /* __Sound_CacheData */
+
+
+void __Sound_InitCache(void)
+{
+    cache_mutex = SDL_CreateMutex();
+    SDL_zero(cache_stats);
+} /* __Sound_InitCache */
+
+
+void __Sound_QuitCache(void)
+{
+    SDL_LockMutex(cache_mutex);
+    trim_cache(0);  /* every sample is gone by now, so this frees it all. */
+    SDL_free(buckets);
+    buckets = NULL;
+    num_buckets = 0;
+    SDL_UnlockMutex(cache_mutex);
+
+    SDL_DestroyMutex(cache_mutex);
+    cache_mutex = NULL;
+} /* __Sound_QuitCache */
+
+
+void Sound_SetCacheLimit(Uint64 max_bytes)
+{
+    SDL_LockMutex(cache_mutex);
+    cache_limit = max_bytes;
+    trim_cache(max_bytes);
+    SDL_UnlockMutex(cache_mutex);
+} /* Sound_SetCacheLimit */
+
+
+Uint64 Sound_GetCacheLimit(void)
+{
+    Uint64 retval;
+    SDL_LockMutex(cache_mutex);
+    retval = cache_limit;
+    SDL_UnlockMutex(cache_mutex);
+    return retval;
+} /* Sound_GetCacheLimit */
+
+
+void Sound_GetCacheStats(Sound_CacheStats *stats)
+{
+    if (stats != NULL)
+    {
+        SDL_LockMutex(cache_mutex);
+        SDL_memcpy(stats, &cache_stats, sizeof (Sound_CacheStats));
+        SDL_UnlockMutex(cache_mutex);
+    } /* if */
+} /* Sound_GetCacheStats */
+
+
+/*
+ * The "decoder" for samples that come out of the cache. The audio is
+ *  already in the sample's desired format, and internal->rw reads straight
+ *  from the cached copy, so this is the RAW decoder with the format filled
+ *  in for it.
+ */
+
+static SDL_bool CACHE_init(void)
+{
+    return SDL_TRUE;  /* always succeeds. */
+} /* CACHE_init */
+
+
+static void CACHE_quit(void)
+{
+    /* it's a no-op. */
+} /* CACHE_quit */
+
+
+static int CACHE_open(Sound_Sample *sample, const char *ext)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Sound_CacheEntry *entry = internal->cache_entry;
+    Uint32 framesize;
+
+    /* only Sound_NewSampleFromFile() and friends can make one of these. */
+    BAIL_IF_MACRO(entry == NULL, ERR_UNSUPPORTED_FORMAT, 0);
+
+    SDL_memcpy(&sample->actual, &entry->info, sizeof (Sound_AudioInfo));
+    sample->decoder = entry->decoder;  /* tell the app what it really is. */
+    sample->flags = SOUND_SAMPLEFLAG_CANSEEK;
+    internal->fast_seek_frame = SDL_TRUE;
+
+    framesize = (SDL_AUDIO_BITSIZE(entry->info.format) / 8) * entry->info.channels;
+    internal->total_time = (Sint32) ((((Uint64) (entry->len / framesize)) * 1000) / entry->info.rate);
+
+    return 1;
+} /* CACHE_open */
+
+
+static void CACHE_close(Sound_Sample *sample)
+{
+    /* Sound_FreeSample() lets go of the cache entry. */
+} /* CACHE_close */
+
+
+static Uint32 CACHE_read_into(Sound_Sample *sample, void *buf, Uint32 buflen)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Uint32 retval = (Uint32) SDL_RWread(internal->rw, buf, 1, buflen);
+
+    if (retval < buflen)  /* it's all in memory, so short means done. */
+        sample->flags |= SOUND_SAMPLEFLAG_EOF;
+
+    return retval;
+} /* CACHE_read_into */
+
+
+static Uint32 CACHE_read(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    return CACHE_read_into(sample, internal->buffer, internal->buffer_size);
+} /* CACHE_read */
+
+
+static int CACHE_rewind(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    BAIL_IF_MACRO(SDL_RWseek(internal->rw, 0, RW_SEEK_SET) != 0, ERR_IO_ERROR, 0);
+    return 1;
+} /* CACHE_rewind */
+
+
+static int CACHE_seek_frame(Sound_Sample *sample, Uint64 frame)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Uint32 framesize = (SDL_AUDIO_BITSIZE(sample->actual.format) / 8) *
+                             sample->actual.channels;
+    const Sint64 pos = (Sint64) (frame * framesize);
+
+    BAIL_IF_MACRO(pos > SDL_RWsize(internal->rw), ERR_PAST_EOF, 0);
+    BAIL_IF_MACRO(SDL_RWseek(internal->rw, pos, RW_SEEK_SET) != pos, ERR_IO_ERROR, 0);
+    return 1;
+} /* CACHE_seek_frame */
+
+
+static int CACHE_seek(Sound_Sample *sample, Uint32 ms)
+{
+    return CACHE_seek_frame(sample, __Sound_convertMsToFrames(sample->actual.rate, ms));
+} /* CACHE_seek */
+
+static const char *extensions_cache[] = { NULL };
+const Sound_DecoderFunctions __Sound_DecoderFunctions_CACHE =
+{
+    {
+        extensions_cache,
+        "Decoded audio from the sample cache",
+        "Ryan C. Gordon <icculus@icculus.org>",
+        "https://icculus.org/SDL_sound/"
+    },
+
+    CACHE_init,       /*   init() method */
+    CACHE_quit,       /*   quit() method */
+    CACHE_open,       /*   open() method */
+    CACHE_close,      /*  close() method */
+    CACHE_read,       /*   read() method */
+    CACHE_rewind,     /* rewind() method */
+    CACHE_seek,       /*   seek() method */
+    CACHE_read_into,  /* read_into() method */
+    CACHE_seek_frame  /* seek_frame() method */
+};
+
+/* end of SDL_sound_cache.c ... */
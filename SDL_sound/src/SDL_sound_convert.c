@@ -0,0 +1,598 @@
+/**
+ * SDL_sound; An abstract sound format decoding API.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+/*
+ * Fast paths for format conversions that don't change the sample rate.
+ *
+ * SDL_AudioStream can do any conversion, but it's built around resampling,
+ *  with its own internal buffering and several passes over the data. Most
+ *  of what we actually get asked for is simpler than that: S16 to float,
+ *  mono to stereo, a byteswap. Those are a single pass over the data, so
+ *  we do them here, straight from the decoder's buffer to the output, and
+ *  only create an SDL_AudioStream when the rate has to change.
+ *
+ * Only mono and stereo are handled here; anything with more channels goes
+ *  to SDL_AudioStream, which knows how to downmix surround sound properly.
+ *
+ * SDL2 has no 24-bit formats, so there's no S24 kernel; decoders that read
+ *  24-bit data (WAV, FLAC) hand it to us as AUDIO_S32SYS.
+ */
+
+#define __SDL_SOUND_INTERNAL__
+#include "SDL_sound_internal.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SOUND_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define SOUND_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* frames per pass through the float scratch space in the generic path. */
+#define CONVERT_CHUNK_FRAMES 256
+
+#define S16_TO_FLOAT (1.0f / 32768.0f)
+#define S32_TO_FLOAT (1.0f / 2147483648.0f)
+
+
+/* Generic path: anything to float, remix channels, float to anything. */
+
+static void load_samples(Uint16 fmt, const Uint8 *src, float *dst,
+                         Uint32 count)
+{
+    Uint32 i;
+
+    switch (fmt)
+    {
+        case AUDIO_U8:
+            for (i = 0; i < count; i++)
+                dst[i] = ((float) (((int) src[i]) - 128)) * (1.0f / 128.0f);
+            break;
+
+        case AUDIO_S8:
+            for (i = 0; i < count; i++)
+                dst[i] = ((float) ((Sint8) src[i])) * (1.0f / 128.0f);
+            break;
+
+        case AUDIO_U16LSB:
+        case AUDIO_U16MSB:
+            for (i = 0; i < count; i++, src += 2)
+            {
+                const Uint16 val = (fmt == AUDIO_U16LSB) ?
+                    (Uint16) (src[0] | (src[1] << 8)) :
+                    (Uint16) (src[1] | (src[0] << 8));
+                dst[i] = ((float) (((int) val) - 32768)) * S16_TO_FLOAT;
+            } /* for */
+            break;
+
+        case AUDIO_S16LSB:
+        case AUDIO_S16MSB:
+            for (i = 0; i < count; i++, src += 2)
+            {
+                const Uint16 val = (fmt == AUDIO_S16LSB) ?
+                    (Uint16) (src[0] | (src[1] << 8)) :
+                    (Uint16) (src[1] | (src[0] << 8));
+                dst[i] = ((float) ((Sint16) val)) * S16_TO_FLOAT;
+            } /* for */
+            break;
+
+        case AUDIO_S32LSB:
+        case AUDIO_S32MSB:
+            for (i = 0; i < count; i++, src += 4)
+            {
+                Uint32 val;
+                SDL_memcpy(&val, src, sizeof (val));
+                val = (fmt == AUDIO_S32LSB) ? SDL_SwapLE32(val) : SDL_SwapBE32(val);
+                dst[i] = ((float) ((Sint32) val)) * S32_TO_FLOAT;
+            } /* for */
+            break;
+
+        case AUDIO_F32LSB:
+        case AUDIO_F32MSB:
+            for (i = 0; i < count; i++, src += 4)
+            {
+                Uint32 val;
+                SDL_memcpy(&val, src, sizeof (val));
+                val = (fmt == AUDIO_F32LSB) ? SDL_SwapLE32(val) : SDL_SwapBE32(val);
+                SDL_memcpy(&dst[i], &val, sizeof (float));
+            } /* for */
+            break;
+
+        default:
+            SDL_assert(!"unexpected audio format");
+            SDL_memset(dst, '\0', count * sizeof (float));
+            break;
+    } /* switch */
+} /* load_samples */
+
+
+static SDL_INLINE float clamp_sample(const float val)
+{
+    return (val < -1.0f) ? -1.0f : ((val > 1.0f) ? 1.0f : val);
+} /* clamp_sample */
+
+
+static void store_samples(Uint16 fmt, const float *src, Uint8 *dst,
+                          Uint32 count)
+{
+    Uint32 i;
+
+    switch (fmt)
+    {
+        case AUDIO_U8:
+            for (i = 0; i < count; i++)
+                dst[i] = (Uint8) ((int) (clamp_sample(src[i]) * 127.0f) + 128);
+            break;
+
+        case AUDIO_S8:
+            for (i = 0; i < count; i++)
+                dst[i] = (Uint8) ((Sint8) (clamp_sample(src[i]) * 127.0f));
+            break;
+
+        case AUDIO_U16LSB:
+        case AUDIO_U16MSB:
+            for (i = 0; i < count; i++, dst += 2)
+            {
+                const Uint16 val = (Uint16) ((int) (clamp_sample(src[i]) * 32767.0f) + 32768);
+                dst[(fmt == AUDIO_U16LSB) ? 0 : 1] = (Uint8) (val & 0xFF);
+                dst[(fmt == AUDIO_U16LSB) ? 1 : 0] = (Uint8) (val >> 8);
+            } /* for */
+            break;
+
+        case AUDIO_S16LSB:
+        case AUDIO_S16MSB:
+            for (i = 0; i < count; i++, dst += 2)
+            {
+                const Uint16 val = (Uint16) ((Sint16) (clamp_sample(src[i]) * 32767.0f));
+                dst[(fmt == AUDIO_S16LSB) ? 0 : 1] = (Uint8) (val & 0xFF);
+                dst[(fmt == AUDIO_S16LSB) ? 1 : 0] = (Uint8) (val >> 8);
+            } /* for */
+            break;
+
+        case AUDIO_S32LSB:
+        case AUDIO_S32MSB:
+            for (i = 0; i < count; i++, dst += 4)
+            {
+                Uint32 val = (Uint32) ((Sint32) (((double) clamp_sample(src[i])) * 2147483647.0));
+                val = (fmt == AUDIO_S32LSB) ? SDL_SwapLE32(val) : SDL_SwapBE32(val);
+                SDL_memcpy(dst, &val, sizeof (val));
+            } /* for */
+            break;
+
+        case AUDIO_F32LSB:
+        case AUDIO_F32MSB:
+            for (i = 0; i < count; i++, dst += 4)
+            {
+                Uint32 val;
+                SDL_memcpy(&val, &src[i], sizeof (val));
+                val = (fmt == AUDIO_F32LSB) ? SDL_SwapLE32(val) : SDL_SwapBE32(val);
+                SDL_memcpy(dst, &val, sizeof (val));
+            } /* for */
+            break;
+
+        default:
+            SDL_assert(!"unexpected audio format");
+            break;
+    } /* switch */
+} /* store_samples */
+
+
+static void convert_generic(const Sound_Converter *cvt, const void *_src,
+                            void *_dst, Uint32 frames)
+{
+    float in[CONVERT_CHUNK_FRAMES * SOUND_MAX_CHANNELS];
+    float out[CONVERT_CHUNK_FRAMES * SOUND_MAX_CHANNELS];
+    const Uint8 *src = (const Uint8 *) _src;
+    Uint8 *dst = (Uint8 *) _dst;
+
+    while (frames > 0)
+    {
+        const Uint32 total = SDL_min(frames, CONVERT_CHUNK_FRAMES);
+        const float *mixed = in;
+        Uint32 i;
+
+        load_samples(cvt->src_format, src, in, total * cvt->src_channels);
+
+        if ((cvt->src_channels == 1) && (cvt->dst_channels == 2))
+        {
+            for (i = 0; i < total; i++)
+                out[i * 2] = out[(i * 2) + 1] = in[i];
+            mixed = out;
+        } /* if */
+
+        else if ((cvt->src_channels == 2) && (cvt->dst_channels == 1))
+        {
+            for (i = 0; i < total; i++)
+                out[i] = (in[i * 2] + in[(i * 2) + 1]) * 0.5f;
+            mixed = out;
+        } /* else if */
+
+        store_samples(cvt->dst_format, mixed, dst, total * cvt->dst_channels);
+
+        src += total * cvt->src_framesize;
+        dst += total * cvt->dst_framesize;
+        frames -= total;
+    } /* while */
+} /* convert_generic */
+
+
+/* Special cases. These are all native byte order. */
+
+static void convert_copy(const Sound_Converter *cvt, const void *src,
+                         void *dst, Uint32 frames)
+{
+    SDL_memcpy(dst, src, frames * cvt->src_framesize);
+} /* convert_copy */
+
+
+/* mono to stereo without a format change is just copying. Works for any format. */
+static void convert_dup_channel(const Sound_Converter *cvt, const void *_src,
+                                void *_dst, Uint32 frames)
+{
+    const Uint32 samplesize = cvt->src_framesize;
+    const Uint8 *src = (const Uint8 *) _src;
+    Uint8 *dst = (Uint8 *) _dst;
+    Uint32 i;
+
+    for (i = 0; i < frames; i++, src += samplesize, dst += samplesize * 2)
+    {
+        SDL_memcpy(dst, src, samplesize);
+        SDL_memcpy(dst + samplesize, src, samplesize);
+    } /* for */
+} /* convert_dup_channel */
+
+
+static void convert_swap16(const Sound_Converter *cvt, const void *_src,
+                           void *_dst, Uint32 frames)
+{
+    const Uint32 count = frames * cvt->src_channels;
+    const Uint16 *src = (const Uint16 *) _src;
+    Uint16 *dst = (Uint16 *) _dst;
+    Uint32 i = 0;
+
+#if SOUND_HAVE_SSE2
+    if (cvt->use_simd)
+    {
+        for (; (i + 8) <= count; i += 8)
+        {
+            const __m128i x = _mm_loadu_si128((const __m128i *) (src + i));
+            _mm_storeu_si128((__m128i *) (dst + i), _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8)));
+        } /* for */
+    } /* if */
+#endif
+
+    for (; i < count; i++)
+        dst[i] = SDL_Swap16(src[i]);
+} /* convert_swap16 */
+
+
+static void convert_swap32(const Sound_Converter *cvt, const void *_src,
+                           void *_dst, Uint32 frames)
+{
+    const Uint32 count = frames * cvt->src_channels;
+    const Uint32 *src = (const Uint32 *) _src;
+    Uint32 *dst = (Uint32 *) _dst;
+    Uint32 i = 0;
+
+#if SOUND_HAVE_SSE2
+    if (cvt->use_simd)
+    {
+        for (; (i + 4) <= count; i += 4)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *) (src + i));
+            x = _mm_or_si128(_mm_slli_epi32(x, 16), _mm_srli_epi32(x, 16));  /* swap the halves... */
+            x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));  /* ...then the bytes in each half. */
+            _mm_storeu_si128((__m128i *) (dst + i), x);
+        } /* for */
+    } /* if */
+#endif
+
+    for (; i < count; i++)
+        dst[i] = SDL_Swap32(src[i]);
+} /* convert_swap32 */
+
+
+static void convert_s16_to_f32(const Sound_Converter *cvt, const void *_src,
+                               void *_dst, Uint32 frames)
+{
+    const Uint32 count = frames * cvt->src_channels;
+    const Sint16 *src = (const Sint16 *) _src;
+    float *dst = (float *) _dst;
+    Uint32 i = 0;
+
+#if SOUND_HAVE_SSE2
+    if (cvt->use_simd)
+    {
+        const __m128 scale = _mm_set1_ps(S16_TO_FLOAT);
+        for (; (i + 8) <= count; i += 8)
+        {
+            const __m128i x = _mm_loadu_si128((const __m128i *) (src + i));
+            const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+            const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+        } /* for */
+    } /* if */
+#elif SOUND_HAVE_NEON
+    if (cvt->use_simd)
+    {
+        const float32x4_t scale = vdupq_n_f32(S16_TO_FLOAT);
+        for (; (i + 8) <= count; i += 8)
+        {
+            const int16x8_t x = vld1q_s16(src + i);
+            vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), scale));
+            vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), scale));
+        } /* for */
+    } /* if */
+#endif
+
+    for (; i < count; i++)
+        dst[i] = ((float) src[i]) * S16_TO_FLOAT;
+} /* convert_s16_to_f32 */
+
+
+static void convert_s16_mono_to_f32_stereo(const Sound_Converter *cvt,
+                                           const void *_src, void *_dst,
+                                           Uint32 frames)
+{
+    const Sint16 *src = (const Sint16 *) _src;
+    float *dst = (float *) _dst;
+    Uint32 i = 0;
+
+#if SOUND_HAVE_SSE2
+    if (cvt->use_simd)
+    {
+        const __m128 scale = _mm_set1_ps(S16_TO_FLOAT);
+        for (; (i + 4) <= frames; i += 4)
+        {
+            const __m128i x = _mm_loadl_epi64((const __m128i *) (src + i));
+            const __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), scale);
+            _mm_storeu_ps(dst + (i * 2), _mm_unpacklo_ps(f, f));
+            _mm_storeu_ps(dst + (i * 2) + 4, _mm_unpackhi_ps(f, f));
+        } /* for */
+    } /* if */
+#endif
+
+    for (; i < frames; i++)
+        dst[i * 2] = dst[(i * 2) + 1] = ((float) src[i]) * S16_TO_FLOAT;
+} /* convert_s16_mono_to_f32_stereo */
+
+
+static void convert_s32_to_f32(const Sound_Converter *cvt, const void *_src,
+                               void *_dst, Uint32 frames)
+{
+    const Uint32 count = frames * cvt->src_channels;
+    const Sint32 *src = (const Sint32 *) _src;
+    float *dst = (float *) _dst;
+    Uint32 i = 0;
+
+#if SOUND_HAVE_SSE2
+    if (cvt->use_simd)
+    {
+        const __m128 scale = _mm_set1_ps(S32_TO_FLOAT);
+        for (; (i + 4) <= count; i += 4)
+        {
+            const __m128i x = _mm_loadu_si128((const __m128i *) (src + i));
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+        } /* for */
+    } /* if */
+#endif
+
+    for (; i < count; i++)
+        dst[i] = ((float) src[i]) * S32_TO_FLOAT;
+} /* convert_s32_to_f32 */
+
+
+static void convert_u8_to_f32(const Sound_Converter *cvt, const void *_src,
+                              void *_dst, Uint32 frames)
+{
+    const Uint32 count = frames * cvt->src_channels;
+    const Uint8 *src = (const Uint8 *) _src;
+    float *dst = (float *) _dst;
+    Uint32 i = 0;
+
+#if SOUND_HAVE_SSE2
+    if (cvt->use_simd)
+    {
+        const __m128 scale = _mm_set1_ps(1.0f / 128.0f);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi16(128);
+        for (; (i + 8) <= count; i += 8)
+        {
+            const __m128i x = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (src + i)), zero), bias);
+            const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+            const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+        } /* for */
+    } /* if */
+#endif
+
+    for (; i < count; i++)
+        dst[i] = ((float) (((int) src[i]) - 128)) * (1.0f / 128.0f);
+} /* convert_u8_to_f32 */
+
+
+static void convert_f32_to_s16(const Sound_Converter *cvt, const void *_src,
+                               void *_dst, Uint32 frames)
+{
+    const Uint32 count = frames * cvt->src_channels;
+    const float *src = (const float *) _src;
+    Sint16 *dst = (Sint16 *) _dst;
+    Uint32 i = 0;
+
+#if SOUND_HAVE_SSE2
+    if (cvt->use_simd)
+    {
+        const __m128 minval = _mm_set1_ps(-1.0f);
+        const __m128 maxval = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set1_ps(32767.0f);
+        for (; (i + 8) <= count; i += 8)
+        {
+            const __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), minval), maxval), scale);
+            const __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), minval), maxval), scale);
+            _mm_storeu_si128((__m128i *) (dst + i), _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+        } /* for */
+    } /* if */
+#elif SOUND_HAVE_NEON
+    if (cvt->use_simd)
+    {
+        const float32x4_t minval = vdupq_n_f32(-1.0f);
+        const float32x4_t maxval = vdupq_n_f32(1.0f);
+        const float32x4_t scale = vdupq_n_f32(32767.0f);
+        for (; (i + 8) <= count; i += 8)
+        {
+            const float32x4_t a = vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(src + i), minval), maxval), scale);
+            const float32x4_t b = vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(src + i + 4), minval), maxval), scale);
+            vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(vcvtq_s32_f32(a)), vqmovn_s32(vcvtq_s32_f32(b))));
+        } /* for */
+    } /* if */
+#endif
+
+    for (; i < count; i++)
+        dst[i] = (Sint16) (clamp_sample(src[i]) * 32767.0f);
+} /* convert_f32_to_s16 */
+
+
+static void convert_f32_mono_to_stereo(const Sound_Converter *cvt,
+                                       const void *_src, void *_dst,
+                                       Uint32 frames)
+{
+    const float *src = (const float *) _src;
+    float *dst = (float *) _dst;
+    Uint32 i = 0;
+
+#if SOUND_HAVE_SSE2
+    if (cvt->use_simd)
+    {
+        for (; (i + 4) <= frames; i += 4)
+        {
+            const __m128 f = _mm_loadu_ps(src + i);
+            _mm_storeu_ps(dst + (i * 2), _mm_unpacklo_ps(f, f));
+            _mm_storeu_ps(dst + (i * 2) + 4, _mm_unpackhi_ps(f, f));
+        } /* for */
+    } /* if */
+#endif
+
+    for (; i < frames; i++)
+        dst[i * 2] = dst[(i * 2) + 1] = src[i];
+} /* convert_f32_mono_to_stereo */
+
+
+static void convert_f32_stereo_to_mono(const Sound_Converter *cvt,
+                                       const void *_src, void *_dst,
+                                       Uint32 frames)
+{
+    const float *src = (const float *) _src;
+    float *dst = (float *) _dst;
+    Uint32 i = 0;
+
+#if SOUND_HAVE_SSE2
+    if (cvt->use_simd)
+    {
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; (i + 4) <= frames; i += 4)
+        {
+            const __m128 a = _mm_loadu_ps(src + (i * 2));
+            const __m128 b = _mm_loadu_ps(src + (i * 2) + 4);
+            const __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+        } /* for */
+    } /* if */
+#endif
+
+    for (; i < frames; i++)
+        dst[i] = (src[i * 2] + src[(i * 2) + 1]) * 0.5f;
+} /* convert_f32_stereo_to_mono */
+
+
+static SDL_INLINE int is_native_order(Uint16 fmt)
+{
+    return ( (SDL_AUDIO_BITSIZE(fmt) == 8) ||
+             ((SDL_AUDIO_ISBIGENDIAN(fmt) != 0) == (SDL_BYTEORDER == SDL_BIG_ENDIAN)) );
+} /* is_native_order */
+
+
+int __Sound_SetupConverter(Sound_Converter *cvt, const Sound_AudioInfo *src,
+                           const Sound_AudioInfo *dst)
+{
+    const Uint16 sfmt = src->format;
+    const Uint16 dfmt = dst->format;
+    const int native = is_native_order(sfmt) && is_native_order(dfmt);
+    const int samechannels = (src->channels == dst->channels);
+
+    SDL_zerop(cvt);
+
+    if (src->rate != dst->rate)
+        return 0;  /* resampling is SDL_AudioStream's job. */
+    else if ((src->channels < 1) || (src->channels > 2))
+        return 0;
+    else if ((dst->channels < 1) || (dst->channels > 2))
+        return 0;
+
+    cvt->src_format = sfmt;
+    cvt->dst_format = dfmt;
+    cvt->src_channels = src->channels;
+    cvt->dst_channels = dst->channels;
+    cvt->src_framesize = (SDL_AUDIO_BITSIZE(sfmt) / 8) * src->channels;
+    cvt->dst_framesize = (SDL_AUDIO_BITSIZE(dfmt) / 8) * dst->channels;
+
+#if SOUND_HAVE_SSE2
+    cvt->use_simd = (__Sound_SIMDFlags() & SOUND_SIMD_SSE2) != 0;
+#elif SOUND_HAVE_NEON
+    cvt->use_simd = (__Sound_SIMDFlags() & SOUND_SIMD_NEON) != 0;
+#endif
+
+    /* nothing to do? Callers usually catch this, but not always. */
+    if (samechannels && (sfmt == dfmt))
+        cvt->func = convert_copy;
+
+    /* byteswap only? */
+    else if (samechannels && ((sfmt & ~SDL_AUDIO_MASK_ENDIAN) == (dfmt & ~SDL_AUDIO_MASK_ENDIAN)))
+    {
+        if (SDL_AUDIO_BITSIZE(sfmt) == 16)
+            cvt->func = convert_swap16;
+        else if (SDL_AUDIO_BITSIZE(sfmt) == 32)
+            cvt->func = convert_swap32;
+    } /* else if */
+
+    /* check this before the generic channel duplicator, which would catch it too. */
+    else if (native && (sfmt == AUDIO_F32SYS) && (dfmt == AUDIO_F32SYS) && (src->channels == 1) && (dst->channels == 2))
+        cvt->func = convert_f32_mono_to_stereo;
+
+    else if ((sfmt == dfmt) && (src->channels == 1) && (dst->channels == 2))
+        cvt->func = convert_dup_channel;
+
+    else if (native && (dfmt == AUDIO_F32SYS))
+    {
+        if (samechannels && (sfmt == AUDIO_S16SYS))
+            cvt->func = convert_s16_to_f32;
+        else if ((sfmt == AUDIO_S16SYS) && (src->channels == 1))
+            cvt->func = convert_s16_mono_to_f32_stereo;
+        else if (samechannels && (sfmt == AUDIO_S32SYS))
+            cvt->func = convert_s32_to_f32;
+        else if (samechannels && (sfmt == AUDIO_U8))
+            cvt->func = convert_u8_to_f32;
+        else if (sfmt == AUDIO_F32SYS)
+            cvt->func = convert_f32_stereo_to_mono;
+    } /* else if */
+
+    else if (native && samechannels && (sfmt == AUDIO_F32SYS) && (dfmt == AUDIO_S16SYS))
+        cvt->func = convert_f32_to_s16;
+
+    if (cvt->func == NULL)
+        cvt->func = convert_generic;
+
+    return 1;
+} /* __Sound_SetupConverter */
+
+/* end of SDL_sound_convert.c ... */
@@ -69,9 +69,36 @@ static drflac_bool32 flac_seek(void* pUserData, int offset, drflac_seek_origin o
 } /* flac_seek */
 
 
+/*
+ * Let dr_flac look at the CPU, then overrule it with what SDL says, so
+ *  SDL_SOUND_SIMD works here too. dr_flac's own check also assumes every
+ *  x86-64 CPU has SSE4.1 when built with Visual Studio, which they don't.
+ *
+ * dr_flac redoes its check every time it opens a stream. On x86 that only
+ *  looks at the CPU the first time, but on ARM it resets the NEON flag
+ *  every time, so we have to do this after every open, not just once.
+ */
+static void flac_override_cpu_caps(void)
+{
+    const Uint32 simd = __Sound_SIMDFlags();
+
+    drflac__init_cpu_caps();
+#ifndef DRFLAC_NO_CPUID
+    drflac__gIsSSE2Supported = (simd & SOUND_SIMD_SSE2) ? DRFLAC_TRUE : DRFLAC_FALSE;
+    drflac__gIsSSE41Supported = (simd & SOUND_SIMD_SSE41) ? DRFLAC_TRUE : DRFLAC_FALSE;
+#else
+    drflac__gIsNEONSupported = (simd & SOUND_SIMD_NEON) ? DRFLAC_TRUE : DRFLAC_FALSE;
+#endif
+} /* flac_override_cpu_caps */
+
+
 static SDL_bool FLAC_init(void)
 {
-    return SDL_TRUE;  /* always succeeds. */
+    if (!__Sound_CPUCanRunThisBuild())
+        return SDL_FALSE;
+
+    flac_override_cpu_caps();
+    return SDL_TRUE;
 } /* FLAC_init */
 
 
@@ -84,7 +111,17 @@ static void FLAC_quit(void)
 static int FLAC_open(Sound_Sample *sample, const char *ext)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
-    drflac *dr = drflac_open(flac_read, flac_seek, sample, NULL);
+    size_t memlen = 0;
+    const Uint8 *mem = __Sound_RWopsMemory(internal->rw, &memlen);
+    drflac *dr;
+
+    /* memory (or a mapped file) doesn't need the read callbacks at all. */
+    if (mem != NULL)
+        dr = drflac_open_memory(mem, memlen, NULL);
+    else
+        dr = drflac_open(flac_read, flac_seek, sample, NULL);
+
+    flac_override_cpu_caps();  /* dr_flac might have just undone it. */
 
     if (!dr)
     {
@@ -110,6 +147,7 @@ static int FLAC_open(Sound_Sample *sample, const char *ext)
     } /* else */
 
     internal->decoder_private = dr;
+    internal->fast_seek_frame = SDL_TRUE;  /* seek table, or a binary search of the frames. */
 
     return 1;
 } /* FLAC_open */
@@ -121,17 +159,23 @@ static void FLAC_close(Sound_Sample *sample)
     drflac_close(dr);
 } /* FLAC_close */
 
-static Uint32 FLAC_read(Sound_Sample *sample)
+static Uint32 FLAC_read_into(Sound_Sample *sample, void *buffer, Uint32 len)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     const int channels = (int) sample->actual.channels;
     drflac *dr = (drflac *) internal->decoder_private;
-    const drflac_uint64 frames_to_read = (internal->buffer_size / channels) / sizeof (drflac_int32);
-    const drflac_uint64 rc = drflac_read_pcm_frames_s32(dr, frames_to_read, (drflac_int32 *) internal->buffer);
+    const drflac_uint64 frames_to_read = (len / channels) / sizeof (drflac_int32);
+    const drflac_uint64 rc = drflac_read_pcm_frames_s32(dr, frames_to_read, (drflac_int32 *) buffer);
     /* !!! FIXME: we only set the EOF flags, but this only tells you we're done, not about i/o errors, nor corruption. */
     if (rc < frames_to_read)
         sample->flags |= SOUND_SAMPLEFLAG_EOF;
     return rc * channels * sizeof (drflac_int32);
+} /* FLAC_read_into */
+
+static Uint32 FLAC_read(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    return FLAC_read_into(sample, internal->buffer, internal->buffer_size);
 } /* FLAC_read */
 
 static int FLAC_rewind(Sound_Sample *sample)
@@ -141,13 +185,16 @@ static int FLAC_rewind(Sound_Sample *sample)
     return (drflac_seek_to_pcm_frame(dr, 0) == DRFLAC_TRUE);
 } /* FLAC_rewind */
 
-static int FLAC_seek(Sound_Sample *sample, Uint32 ms)
+static int FLAC_seek_frame(Sound_Sample *sample, Uint64 frame)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     drflac *dr = (drflac *) internal->decoder_private;
-    const float frames_per_ms = ((float) sample->actual.rate) / 1000.0f;
-    const drflac_uint64 frame_offset = (drflac_uint64) (frames_per_ms * ((float) ms));
-    return (drflac_seek_to_pcm_frame(dr, frame_offset) == DRFLAC_TRUE);
+    return (drflac_seek_to_pcm_frame(dr, (drflac_uint64) frame) == DRFLAC_TRUE);
+} /* FLAC_seek_frame */
+
+static int FLAC_seek(Sound_Sample *sample, Uint32 ms)
+{
+    return FLAC_seek_frame(sample, __Sound_convertMsToFrames(sample->actual.rate, ms));
 } /* FLAC_seek */
 
 static const char *extensions_flac[] = { "FLAC", "FLA", NULL };
@@ -166,7 +213,9 @@ const Sound_DecoderFunctions __Sound_DecoderFunctions_FLAC =
     FLAC_close,      /*  close() method */
     FLAC_read,       /*   read() method */
     FLAC_rewind,     /* rewind() method */
-    FLAC_seek        /*   seek() method */
+    FLAC_seek,       /*   seek() method */
+    FLAC_read_into,  /* read_into() method */
+    FLAC_seek_frame  /* seek_frame() method */
 };
 
 #endif /* SOUND_SUPPORTS_FLAC */
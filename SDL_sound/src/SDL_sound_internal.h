@@ -242,11 +242,90 @@ typedef struct __SOUND_DECODERFUNCTIONS__
          *  continue as if nothing happened.
          */
     int (*seek)(Sound_Sample *sample, Uint32 ms);
+
+        /*
+         * Optional. This is exactly like read(), except the decoded data
+         *  goes into (buffer) instead of (internal->buffer), and no more
+         *  than (len) bytes may be written. (len) is always a multiple of
+         *  the sample frame size. Sound_DecodeInto() uses this to let a
+         *  decoder write straight into the application's memory when no
+         *  conversion is needed, skipping the copy out of the internal
+         *  buffer.
+         *
+         * Decoders that don't care can leave this NULL (or just leave it off
+         *  the end of their initializer), and the library will fall back to
+         *  read() and a memcpy. Decoders that do implement it usually make
+         *  their read() a thin wrapper that passes in (internal->buffer).
+         */
+    Uint32 (*read_into)(Sound_Sample *sample, void *buffer, Uint32 len);
+
+        /*
+         * Optional. Reposition the decoding to an exact sample frame (in
+         *  the sample->actual format, counting from the start of the audio
+         *  data). Nonzero on success, zero on failure.
+         *
+         * seek() works in milliseconds, which can't name every sample frame.
+         *  Only implement this if decoding onward from (frame) gives exactly
+         *  the data that decoding the whole stream from the start would have
+         *  given at that point; Sound_DecodeAllParallel() relies on that to
+         *  split a stream across threads and stitch the pieces back together.
+         *  If a decoder can only do that for some streams, fail (and set an
+         *  error) for the others.
+         *
+         * Sound_SeekFrames() uses this too. For decoders without it, the
+         *  library calls seek() with the millisecond at or before (frame) and
+         *  decodes forward from there, which is only exact if seek() lands on
+         *  __Sound_convertMsToFrames() of that millisecond.
+         *
+         * Sound_DecodeAllParallel() also needs this to be cheap: a decoder
+         *  that has to decode its way to (frame) would make every thread
+         *  redo the work of the ones before it. So it only splits up
+         *  samples whose open() set internal->fast_seek_frame, which a
+         *  decoder should do when this jumps more or less straight there.
+         */
+    int (*seek_frame)(Sound_Sample *sample, Uint64 frame);
 } Sound_DecoderFunctions;
 
 
 typedef void (*MixFunc)(float *dst, void *src, Uint32 frames, float *gains);
 
+
+/*
+ * Rate-preserving format conversion, without an SDL_AudioStream.
+ *  See SDL_sound_convert.c.
+ */
+typedef struct __SOUND_CONVERTER__ Sound_Converter;
+typedef void (*Sound_ConvertFunc)(const Sound_Converter *cvt, const void *src,
+                                  void *dst, Uint32 frames);
+
+struct __SOUND_CONVERTER__
+{
+    Sound_ConvertFunc func;    /* NULL if not converting this way. */
+    Uint16 src_format;
+    Uint16 dst_format;
+    Uint8 src_channels;
+    Uint8 dst_channels;
+    Uint32 src_framesize;
+    Uint32 dst_framesize;
+    int use_simd;
+};
+
+/*
+ * Rate conversion, when the app picks SOUND_RESAMPLE_LINEAR or
+ *  SOUND_RESAMPLE_SINC. See SDL_sound_resample.c.
+ */
+typedef struct __SOUND_RESAMPLER__ Sound_Resampler;
+
+/* The most frames you can __Sound_ResamplerPut() at once. */
+#define SOUND_RESAMPLE_CHUNK_FRAMES 1024
+
+/*
+ * The decoded-audio cache, when the app turns it on with
+ *  Sound_SetCacheLimit(). See SDL_sound_cache.c.
+ */
+typedef struct __SOUND_CACHEKEY__ Sound_CacheKey;
+typedef struct __SOUND_CACHEENTRY__ Sound_CacheEntry;
+
 typedef struct __SOUND_SAMPLEINTERNAL__
 {
     Sound_Sample *next;
@@ -254,12 +333,27 @@ typedef struct __SOUND_SAMPLEINTERNAL__
     SDL_RWops *rw;
     const Sound_DecoderFunctions *funcs;
     SDL_AudioStream *stream;
+    Sound_Converter converter;
+    Sound_Resampler *resampler;
+    Sound_ResampleMode resample_mode;
+    Uint32 requested_rate;     /* what the app asked for, before SOUND_RESAMPLE_NONE. */
     SDL_bool pending_eof;
     SDL_bool pending_error;
     void *buffer;
     Uint32 buffer_size;
     void *decoder_private;
     Sint32 total_time;
+    SDL_bool fast_seek_frame;  /* open() says seek_frame() doesn't decode its way there. */
+    Uint64 frame_position;     /* next frame the decoder returns, in sample->actual. */
+    char *reopen_fname;        /* from Sound_NewSampleFromFile(), or NULL. */
+    const Uint8 *reopen_mem;   /* from Sound_NewSampleFromMem(), or NULL. */
+    Uint32 reopen_memsize;
+    Sound_CacheKey *cache_key;       /* where Sound_DecodeAll() can cache this, or NULL. */
+    Sound_CacheEntry *cache_entry;   /* the cached copy of this sample, or NULL. */
+    void *private_buffer;            /* our own sample->buffer, while that's the cached copy. */
+    Uint32 private_buffer_size;
+    SDL_bool collect_stats;    /* Sound_SetStatsEnabled() was on at open time. */
+    Sound_SampleStats stats;   /* times in here are performance counter ticks. */
     Uint32 mix_position;
     MixFunc mix;
 } Sound_SampleInternal;
@@ -280,6 +374,7 @@ typedef struct __SOUND_SAMPLEINTERNAL__
 #define ERR_PREV_ERROR           "Previous decoding already caused an error"
 #define ERR_PREV_EOF             "Previous decoding already triggered EOF"
 #define ERR_CANNOT_SEEK          "Sample is not seekable"
+#define ERR_NO_STATS             "Sample isn't collecting stats"
 
 #ifdef __cplusplus
 extern "C" {
@@ -294,12 +389,87 @@ extern "C" {
  */
 void __Sound_SetError(const char *err);
 
+/*
+ * Set up (cvt) to convert (src) to (dst) without an SDL_AudioStream.
+ *  Returns zero if the rates differ or the channel layout isn't one we
+ *  handle, in which case you need an SDL_AudioStream, non-zero otherwise.
+ *  This never fails for lack of a specific kernel; it falls back to a
+ *  generic (but still single-pass) one.
+ */
+int __Sound_SetupConverter(Sound_Converter *cvt, const Sound_AudioInfo *src,
+                           const Sound_AudioInfo *dst);
+
+/*
+ * SDL_sound's own resampler. This works like SDL_AudioStream: Put() data
+ *  in the source format, Get() data in the destination format, and Flush()
+ *  at the end of the input so the last few frames come out. Only Put() when
+ *  Get() has nothing left to give you; that guarantees there's room for
+ *  SOUND_RESAMPLE_CHUNK_FRAMES more.
+ *
+ * __Sound_CreateResampler() returns NULL if (mode) isn't one of ours, the
+ *  channel layout isn't one it handles (more than stereo), or it's out of
+ *  memory. Use an SDL_AudioStream in that case.
+ */
+Sound_Resampler *__Sound_CreateResampler(Sound_ResampleMode mode,
+                                         const Sound_AudioInfo *src,
+                                         const Sound_AudioInfo *dst);
+void __Sound_ResamplerPut(Sound_Resampler *rs, const void *src, Uint32 frames);
+void __Sound_ResamplerFlush(Sound_Resampler *rs);
+Uint32 __Sound_ResamplerGet(Sound_Resampler *rs, void *dst, Uint32 frames);
+void __Sound_ResamplerClear(Sound_Resampler *rs);
+void __Sound_DestroyResampler(Sound_Resampler *rs);
+
+/*
+ * The decoded-audio cache.
+ *
+ * __Sound_CreateCacheKey() identifies a file (fname) or a block of memory
+ *  (data and size), opened with (ext) and (desired). It returns NULL if the
+ *  cache is off, or we can't tell what the file is.
+ *
+ * __Sound_CacheLookup() returns the entry for (key), with a reference added
+ *  for you, or NULL. __Sound_CacheInsert() takes (data), which must be from
+ *  __Sound_SIMDAlloc() and hold (len) bytes of (sample), decoded in
+ *  sample->desired from the start. On success, the cache owns (key) and
+ *  (data), and you get a reference to the new entry; on failure, you still
+ *  own both. __Sound_CacheRelease() drops your reference.
+ *
+ * __Sound_CacheData() returns the decoded audio, which is read-only.
+ */
+void __Sound_InitCache(void);
+void __Sound_QuitCache(void);
+Sound_CacheKey *__Sound_CreateCacheKey(const char *fname, const Uint8 *data,
+                                       Uint32 size, const char *ext,
+                                       const Sound_AudioInfo *desired);
+void __Sound_DestroyCacheKey(Sound_CacheKey *key);
+Sound_CacheEntry *__Sound_CacheLookup(const Sound_CacheKey *key);
+Sound_CacheEntry *__Sound_CacheInsert(Sound_CacheKey *key, void *data,
+                                      Uint32 len, const Sound_Sample *sample);
+void __Sound_CacheRelease(Sound_CacheEntry *entry);
+const Uint8 *__Sound_CacheData(const Sound_CacheEntry *entry, Uint32 *len,
+                               Sound_AudioInfo *info);
+
+/*
+ * If (rw) is memory (SDL_RWFromMem(), SDL_RWFromConstMem(), or a file that
+ *  Sound_NewSampleFromFile() mapped), this returns everything from its
+ *  current position on, and how much that is in (*len), so a decoder can use
+ *  it directly instead of reading through (rw). Otherwise, NULL. Leave (rw)
+ *  open; the memory is only good as long as it is.
+ */
+const Uint8 *__Sound_RWopsMemory(SDL_RWops *rw, size_t *len);
+
 /*
  * Call this to convert milliseconds to an actual byte position, based on
  *  audio data characteristics.
  */
 Uint32 __Sound_convertMsToBytePos(Sound_AudioInfo *info, Uint32 ms);
 
+/*
+ * Call this to convert milliseconds to sample frames at (rate). This is
+ *  exact (rounded down), so every decoder lands on the same frame for the
+ *  same time, and Sound_SeekFrames() can count from there.
+ */
+Uint64 __Sound_convertMsToFrames(Uint32 rate, Uint32 ms);
+
 
 /* These get used all over for lessening code clutter. */
 #define BAIL_MACRO(e, r) { __Sound_SetError(e); return r; }
@@ -323,6 +493,42 @@ extern void *__Sound_SIMDAlloc(const size_t len);
 extern void *__Sound_SIMDRealloc(void *mem, const size_t len);
 extern void __Sound_SIMDFree(void *ptr);
 
+/*
+ * SIMD that the bundled decoders and our converters may use, as SOUND_SIMD_*
+ *  flags: what SDL says the CPU has, less anything the SDL_SOUND_SIMD
+ *  environment variable ruled out when Sound_Init() ran.
+ */
+#define SOUND_SIMD_SSE2  (1 << 0)
+#define SOUND_SIMD_SSE41 (1 << 1)
+#define SOUND_SIMD_NEON  (1 << 2)
+extern Uint32 __Sound_SIMDFlags(void);
+
+/*
+ * SDLSOUND_DECODER_SIMD in CMakeLists.txt can build a decoder for more SIMD
+ *  than the compiler targets by default, and then the compiler may use it
+ *  anywhere in that file. Decoders that can be built that way call this from
+ *  their init() method, and report themselves unavailable on CPUs that can't
+ *  run them, instead of crashing later.
+ */
+static SDL_INLINE SDL_bool __Sound_CPUCanRunThisBuild(void)
+{
+/* Visual Studio doesn't define __SSE2__; /arch:SSE2 on x86 sets _M_IX86_FP
+   instead. (x64 always has SSE2, so there's nothing to check there.) */
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    if (!SDL_HasSSE2())
+        return SDL_FALSE;
+#endif
+#if defined(__SSE4_1__)
+    if (!SDL_HasSSE41())
+        return SDL_FALSE;
+#endif
+#if defined(__ARM_NEON) && !defined(__aarch64__)
+    if (!SDL_HasNEON())
+        return SDL_FALSE;
+#endif
+    return SDL_TRUE;
+} /* __Sound_CPUCanRunThisBuild */
+
 #ifdef __cplusplus
 }
 #endif
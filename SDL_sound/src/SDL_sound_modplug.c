@@ -79,6 +79,8 @@ static int MODPLUG_open(Sound_Sample *sample, const char *ext)
     ModPlug_Settings settings;
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     ModPlugFile *module;
+    const Uint8 *mem;
+    size_t memlen = 0;
     void *data;
     Sint64 size;
     size_t retval;
@@ -102,16 +104,18 @@ static int MODPLUG_open(Sound_Sample *sample, const char *ext)
 
     /* ModPlug needs the entire stream in one big chunk. I don't like it,
        but I don't think there's any way around it.  !!! FIXME: rework modplug? */
-    size = SDL_RWsize(internal->rw);
-    BAIL_IF_MACRO(size <= 0 || size > (Sint64)0x7fffffff, "MODPLUG: Not a module file.", 0);
-
-    if (internal->rw->type == SDL_RWOPS_MEMORY || internal->rw->type == SDL_RWOPS_MEMORY_RO)
+    mem = __Sound_RWopsMemory(internal->rw, &memlen);
+    if (mem != NULL)
     {
-        data = internal->rw->hidden.mem.base;
+        size = (Sint64) memlen;
+        BAIL_IF_MACRO(size <= 0 || size > (Sint64)0x7fffffff, "MODPLUG: Not a module file.", 0);
+        data = (void *) mem;
         retval = 0;
     }
     else
     {
+        size = SDL_RWsize(internal->rw);
+        BAIL_IF_MACRO(size <= 0 || size > (Sint64)0x7fffffff, "MODPLUG: Not a module file.", 0);
         data = SDL_malloc((size_t) size);
         BAIL_IF_MACRO(data == NULL, ERR_OUT_OF_MEMORY, 0);
         retval = SDL_RWread(internal->rw, data, 1, size);
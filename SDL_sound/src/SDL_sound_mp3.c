@@ -32,6 +32,33 @@
 
 #include "dr_mp3.h"
 
+/*
+ * Seeking without a seek table means decoding forward from the start of the
+ *  file, so we build one the first time someone seeks by milliseconds. It
+ *  costs a pass over the file's frame headers (no decoding), and afterwards
+ *  a seek only decodes from the nearest point. One point a second, up to a
+ *  limit, keeps that under a second of audio for anything short of an hour
+ *  or so.
+ *
+ * A seek through the table only primes the decoder with a couple of MP3
+ *  frames, and the bit reservoir can reach back further than that, so the
+ *  audio right after it isn't always bit-identical to decoding from the
+ *  start. That's fine for Sound_Seek(), but seek_frame() promises exact
+ *  output, so it leaves the table out and decodes its way there.
+ */
+#define MP3_SEEK_POINTS_PER_SECOND 1
+#define MP3_MAX_SEEK_POINTS 4096
+
+typedef struct
+{
+    drmp3 dr;
+    Uint64 total_frames;            /* PCM frames, or 0 if we don't know yet. */
+    drmp3_seek_point *seek_points;  /* NULL until the first Sound_Seek(); only bound to dr during one. */
+    drmp3_uint32 seek_point_count;
+    SDL_bool seek_table_failed;     /* don't keep trying, just brute force it. */
+    SDL_bool from_memory;           /* dr opened with drmp3_init_memory(). */
+} MP3_private;
+
 static size_t mp3_read(void* pUserData, void* pBufferOut, size_t bytesToRead)
 {
     Uint8 *ptr = (Uint8 *) pBufferOut;
@@ -62,9 +89,175 @@ static drmp3_bool32 mp3_seek(void* pUserData, int offset, drmp3_seek_origin orig
 } /* mp3_seek */
 
 
+static Uint32 mp3_be32(const Uint8 *ptr)
+{
+    return (((Uint32) ptr[0]) << 24) | (((Uint32) ptr[1]) << 16) |
+           (((Uint32) ptr[2]) << 8) | ((Uint32) ptr[3]);
+} /* mp3_be32 */
+
+
+/*
+ * Look for a Xing/Info (LAME and friends) or VBRI (Fraunhofer) header in
+ *  the first frame, past any ID3v2 tag, and work out how many PCM frames the
+ *  stream decodes to. Returns 0 if there isn't one. Leaves the stream where
+ *  it found it.
+ */
+static Uint64 mp3_frames_from_header(SDL_RWops *rw)
+{
+    const Sint64 start = SDL_RWtell(rw);
+    Uint8 buf[192];
+    Uint64 retval = 0;
+    Uint32 header, version, layer, mono, framesamples, offset;
+    size_t len;
+
+    if (start < 0)
+        return 0;
+
+    len = SDL_RWread(rw, buf, 1, 10);
+    if ((len == 10) && (SDL_memcmp(buf, "ID3", 3) == 0))
+    {
+        Sint64 skip = (((Sint64) (buf[6] & 0x7F)) << 21) | ((buf[7] & 0x7F) << 14) |
+                      ((buf[8] & 0x7F) << 7) | (buf[9] & 0x7F);
+        if (buf[5] & 0x10)  /* footer present. */
+            skip += 10;
+        if (SDL_RWseek(rw, skip, RW_SEEK_CUR) == -1)
+            len = 0;
+        else
+            len = SDL_RWread(rw, buf, 1, sizeof (buf));
+    } /* if */
+    else if (len == 10)
+        len += SDL_RWread(rw, buf + 10, 1, sizeof (buf) - 10);
+
+    SDL_RWseek(rw, start, RW_SEEK_SET);
+
+    if (len < 4)
+        return 0;
+
+    header = mp3_be32(buf);
+    version = (header >> 19) & 3;  /* 3 == MPEG-1, 2 == MPEG-2, 0 == MPEG-2.5 */
+    layer = (header >> 17) & 3;    /* 1 == layer 3. */
+    mono = (((header >> 6) & 3) == 3);
+    if (((header & 0xFFE00000) != 0xFFE00000) || (version == 1) || (layer != 1))
+        return 0;  /* not layer 3, so no Xing or VBRI header. */
+
+    framesamples = (version == 3) ? 1152 : 576;
+
+    /* Xing/Info sits right after the side info. */
+    offset = 4 + ((version == 3) ? (mono ? 17 : 32) : (mono ? 9 : 17));
+    if ((len >= offset + 12) &&
+        ((SDL_memcmp(buf + offset, "Xing", 4) == 0) ||
+         (SDL_memcmp(buf + offset, "Info", 4) == 0)))
+    {
+        if (mp3_be32(buf + offset + 4) & 0x1)  /* frame count present? */
+            retval = mp3_be32(buf + offset + 8);
+    } /* if */
+
+    /* VBRI is always 32 bytes after the header. */
+    else if ((len >= 36 + 18) && (SDL_memcmp(buf + 36, "VBRI", 4) == 0))
+        retval = mp3_be32(buf + 36 + 14);
+
+    /*
+     * Both count the audio frames after the one they're in, but dr_mp3
+     *  doesn't know to skip that one, and decodes it as a frame of silence,
+     *  so it counts too. We don't trim LAME's encoder delay and padding
+     *  either, so the decoded length is just whole frames.
+     */
+    if (retval > 0)
+        retval = (retval + 1) * framesamples;
+
+    return retval;
+} /* mp3_frames_from_header */
+
+
+/* Scan the whole stream for its frame count, and index it for seeking. */
+static int mp3_build_seek_table(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    MP3_private *mp3 = (MP3_private *) internal->decoder_private;
+    drmp3 *dr = &mp3->dr;
+    drmp3 *scan = dr;
+    drmp3_seek_point *points = NULL;
+    drmp3_uint64 mp3frames = 0;
+    drmp3_uint64 pcmframes = 0;
+    drmp3_uint32 count = 0;
+    int retval = 0;
+
+    /*
+     * dr_mp3 works out where seek points are from how much it has read
+     *  through its callbacks, which it doesn't keep track of when it decodes
+     *  from memory. So in that case, scan with a second decoder that reads
+     *  through the RWops, which is the same memory at the same offsets.
+     */
+    if (mp3->from_memory)
+    {
+        scan = (drmp3 *) SDL_malloc(sizeof (drmp3));
+        if (scan == NULL)
+            return 0;
+        else if ((SDL_RWseek(internal->rw, 0, RW_SEEK_SET) == -1) ||
+                 (!drmp3_init(scan, mp3_read, mp3_seek, sample, NULL)))
+        {
+            SDL_free(scan);
+            return 0;
+        } /* else if */
+    } /* if */
+
+    /*
+     * dr_mp3 puts the stream back where it was when it's done, by decoding
+     *  up to it, so start at the start; the caller is seeking anyhow.
+     */
+    else if (!drmp3_seek_to_pcm_frame(dr, 0))
+        return 0;
+
+    if (mp3->total_frames == 0)
+    {
+        if (drmp3_get_mp3_and_pcm_frame_count(scan, &mp3frames, &pcmframes))
+        {
+            mp3->total_frames = (Uint64) pcmframes;
+            internal->total_time = (Sint32) ((((Uint64) pcmframes) * 1000) / sample->actual.rate);
+        } /* if */
+    } /* if */
+
+    if (mp3->total_frames > 0)
+    {
+        count = (drmp3_uint32) SDL_min((mp3->total_frames / sample->actual.rate) * MP3_SEEK_POINTS_PER_SECOND, MP3_MAX_SEEK_POINTS);
+        if (count == 0)
+            count = 1;
+        points = (drmp3_seek_point *) SDL_malloc(count * sizeof (drmp3_seek_point));
+    } /* if */
+
+    if ((points != NULL) && (drmp3_calculate_seek_points(scan, &count, points)))
+    {
+        mp3->seek_points = points;
+        mp3->seek_point_count = count;
+        retval = 1;
+    } /* if */
+    else
+    {
+        SDL_free(points);
+    } /* else */
+
+    if (scan != dr)
+    {
+        drmp3_uninit(scan);
+        SDL_free(scan);
+    } /* if */
+
+    if (!retval)
+        return 0;
+
+    SNDDBG(("MP3: Built a %u-point seek table.\n", (unsigned int) count));
+    return 1;
+} /* mp3_build_seek_table */
+
+
 static SDL_bool MP3_init(void)
 {
-    return SDL_TRUE;  /* always succeeds. */
+    /*
+     * dr_mp3 decides on SIMD at build time on x86-64 and ARM64, and checks
+     *  the CPU itself elsewhere, so there's no overruling it like FLAC does.
+     *  All we can do is make sure this CPU can run what was built.
+     */
+    return __Sound_CPUCanRunThisBuild();
 } /* MP3_init */
 
 
@@ -76,12 +269,30 @@ static void MP3_quit(void)
 static int MP3_open(Sound_Sample *sample, const char *ext)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
-    drmp3 *dr = (drmp3 *) SDL_calloc(1, sizeof (drmp3));
+    MP3_private *mp3 = (MP3_private *) SDL_calloc(1, sizeof (MP3_private));
+    size_t memlen = 0;
+    const Uint8 *mem = __Sound_RWopsMemory(internal->rw, &memlen);
+    drmp3_bool32 rc;
+    drmp3 *dr;
 
-    BAIL_IF_MACRO(!dr, ERR_OUT_OF_MEMORY, 0);
-    if (drmp3_init(dr, mp3_read, mp3_seek, sample, NULL) != DRMP3_TRUE)
+    BAIL_IF_MACRO(!mp3, ERR_OUT_OF_MEMORY, 0);
+    mp3->total_frames = mp3_frames_from_header(internal->rw);
+
+    /*
+     * Memory (or a mapped file) doesn't need the read callbacks at all. We
+     *  only do this from the start of the RWops, since our callbacks (which
+     *  the seek table still needs) treat it as the start of the stream.
+     */
+    dr = &mp3->dr;
+    mp3->from_memory = ((mem != NULL) && (SDL_RWtell(internal->rw) == 0));
+    if (mp3->from_memory)
+        rc = drmp3_init_memory(dr, mem, memlen, NULL);
+    else
+        rc = drmp3_init(dr, mp3_read, mp3_seek, sample, NULL);
+
+    if (rc != DRMP3_TRUE)
     {
-        SDL_free(dr);
+        SDL_free(mp3);
         BAIL_IF_MACRO(sample->flags & SOUND_SAMPLEFLAG_ERROR, ERR_IO_ERROR, 0);
         BAIL_MACRO("MP3: Not an MPEG-1 layer 1-3 stream.", 0);
     } /* if */
@@ -93,8 +304,13 @@ static int MP3_open(Sound_Sample *sample, const char *ext)
     sample->actual.rate = dr->sampleRate;
     sample->actual.format = AUDIO_F32SYS;  /* dr_mp3 only does float. */
 
-    internal->total_time = -1;  /* !!! FIXME? */
-    internal->decoder_private = dr;
+    /* without a Xing/VBRI header, we find out the first time we seek. */
+    if (mp3->total_frames == 0)
+        internal->total_time = -1;
+    else
+        internal->total_time = (Sint32) ((mp3->total_frames * 1000) / dr->sampleRate);
+
+    internal->decoder_private = mp3;
 
     return 1;
 } /* MP3_open */
@@ -102,16 +318,17 @@ static int MP3_open(Sound_Sample *sample, const char *ext)
 static void MP3_close(Sound_Sample *sample)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
-    drmp3 *dr = (drmp3 *) internal->decoder_private;
-    drmp3_uninit(dr);
-    SDL_free(dr);
+    MP3_private *mp3 = (MP3_private *) internal->decoder_private;
+    drmp3_uninit(&mp3->dr);
+    SDL_free(mp3->seek_points);
+    SDL_free(mp3);
 } /* MP3_close */
 
 static Uint32 MP3_read(Sound_Sample *sample)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     const int channels = (int) sample->actual.channels;
-    drmp3 *dr = (drmp3 *) internal->decoder_private;
+    drmp3 *dr = &((MP3_private *) internal->decoder_private)->dr;
     const drmp3_uint64 frames_to_read = (internal->buffer_size / channels) / sizeof (float);
     const drmp3_uint64 rc = drmp3_read_pcm_frames_f32(dr, frames_to_read, (float *) internal->buffer);
     /* !!! FIXME: we only set the EOF flags, but this only tells you we're done, not about i/o errors, nor corruption. */
@@ -123,17 +340,44 @@ static Uint32 MP3_read(Sound_Sample *sample)
 static int MP3_rewind(Sound_Sample *sample)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
-    drmp3 *dr = (drmp3 *) internal->decoder_private;
+    drmp3 *dr = &((MP3_private *) internal->decoder_private)->dr;
     return (drmp3_seek_to_pcm_frame(dr, 0) == DRMP3_TRUE);
 } /* MP3_rewind */
 
+static int MP3_seek_frame(Sound_Sample *sample, Uint64 frame)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    MP3_private *mp3 = (MP3_private *) internal->decoder_private;
+
+    /* no seek table bound, so this decodes from the start (or from here,
+       going forward). That's why MP3_open() doesn't set fast_seek_frame. */
+    SDL_assert(mp3->dr.pSeekPoints == NULL);
+    return (drmp3_seek_to_pcm_frame(&mp3->dr, (drmp3_uint64) frame) == DRMP3_TRUE);
+} /* MP3_seek_frame */
+
 static int MP3_seek(Sound_Sample *sample, Uint32 ms)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
-    drmp3 *dr = (drmp3 *) internal->decoder_private;
-    const float frames_per_ms = ((float) sample->actual.rate) / 1000.0f;
-    const drmp3_uint64 frame_offset = (drmp3_uint64) (frames_per_ms * ((float) ms));
-    return (drmp3_seek_to_pcm_frame(dr, frame_offset) == DRMP3_TRUE);
+    MP3_private *mp3 = (MP3_private *) internal->decoder_private;
+    const Uint64 frame = __Sound_convertMsToFrames(sample->actual.rate, ms);
+    drmp3_bool32 rc;
+
+    /* rewinding is cheap without a table, so don't bother for that. */
+    if ((frame > 0) && (mp3->seek_points == NULL) && (!mp3->seek_table_failed))
+    {
+        if (!mp3_build_seek_table(sample))
+        {
+            SNDDBG(("MP3: Couldn't build a seek table, seeking the slow way.\n"));
+            mp3->seek_table_failed = SDL_TRUE;
+        } /* if */
+    } /* if */
+
+    if (mp3->seek_points != NULL)
+        drmp3_bind_seek_table(&mp3->dr, mp3->seek_point_count, mp3->seek_points);
+    rc = drmp3_seek_to_pcm_frame(&mp3->dr, (drmp3_uint64) frame);
+    drmp3_bind_seek_table(&mp3->dr, 0, NULL);  /* keep seek_frame() exact. */
+
+    return (rc == DRMP3_TRUE);
 } /* MP3_seek */
 
 /* dr_mp3 will play layer 1 and 2 files, too */
@@ -153,7 +397,9 @@ const Sound_DecoderFunctions __Sound_DecoderFunctions_MP3 =
     MP3_close,      /*  close() method */
     MP3_read,       /*   read() method */
     MP3_rewind,     /* rewind() method */
-    MP3_seek        /*   seek() method */
+    MP3_seek,       /*   seek() method */
+    NULL,           /* read_into() method */
+    MP3_seek_frame  /* seek_frame() method */
 };
 
 #endif /* SOUND_SUPPORTS_MP3 */
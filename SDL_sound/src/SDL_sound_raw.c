@@ -72,6 +72,7 @@ static int RAW_open(Sound_Sample *sample, const char *ext)
          */
     SDL_memcpy(&sample->actual, &sample->desired, sizeof (Sound_AudioInfo));
     sample->flags = SOUND_SAMPLEFLAG_CANSEEK;
+    internal->fast_seek_frame = SDL_TRUE;
 
     if ((pos = SDL_RWseek(internal->rw, 0, RW_SEEK_END)) <= 0) {
         BAIL_MACRO("RAW: can't seek to the end of the file.", 0);
@@ -94,17 +95,16 @@ static void RAW_close(Sound_Sample *sample)
 } /* RAW_close */
 
 
-static Uint32 RAW_read(Sound_Sample *sample)
+static Uint32 RAW_read_into(Sound_Sample *sample, void *buf, Uint32 buflen)
 {
     Uint32 retval;
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
 
         /*
          * We don't actually do any decoding, so we read the raw data
-         *  directly into the internal buffer...
+         *  directly into the output buffer...
          */
-    retval = SDL_RWread(internal->rw, internal->buffer,
-                        1, internal->buffer_size);
+    retval = SDL_RWread(internal->rw, buf, 1, buflen);
 
         /* Make sure the read went smoothly... */
     if (retval == 0)
@@ -114,10 +114,17 @@ static Uint32 RAW_read(Sound_Sample *sample)
         sample->flags |= SOUND_SAMPLEFLAG_ERROR;
 
         /* (next call this EAGAIN may turn into an EOF or error.) */
-    else if (retval < internal->buffer_size)
+    else if (retval < buflen)
         sample->flags |= SOUND_SAMPLEFLAG_EAGAIN;
 
     return retval;
+} /* RAW_read_into */
+
+
+static Uint32 RAW_read(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    return RAW_read_into(sample, internal->buffer, internal->buffer_size);
 } /* RAW_read */
 
 
@@ -129,13 +136,20 @@ static int RAW_rewind(Sound_Sample *sample)
 } /* RAW_rewind */
 
 
-static int RAW_seek(Sound_Sample *sample, Uint32 ms)
+static int RAW_seek_frame(Sound_Sample *sample, Uint64 frame)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
-    const Sint64 pos = __Sound_convertMsToBytePos(&sample->actual, ms);
+    const Uint32 framesize = ((sample->actual.format & 0xFF) / 8) * sample->actual.channels;
+    const Sint64 pos = (Sint64) (frame * framesize);
     const int err = (SDL_RWseek(internal->rw, pos, RW_SEEK_SET) != pos);
     BAIL_IF_MACRO(err, ERR_IO_ERROR, 0);
     return 1;
+} /* RAW_seek_frame */
+
+
+static int RAW_seek(Sound_Sample *sample, Uint32 ms)
+{
+    return RAW_seek_frame(sample, __Sound_convertMsToFrames(sample->actual.rate, ms));
 } /* RAW_seek */
 
 static const char *extensions_raw[] = { "RAW", NULL };
@@ -154,7 +168,9 @@ const Sound_DecoderFunctions __Sound_DecoderFunctions_RAW =
     RAW_close,      /*  close() method */
     RAW_read,       /*   read() method */
     RAW_rewind,     /* rewind() method */
-    RAW_seek        /*   seek() method */
+    RAW_seek,       /*   seek() method */
+    RAW_read_into,  /* read_into() method */
+    RAW_seek_frame  /* seek_frame() method */
 };
 
 #endif /* SOUND_SUPPORTS_RAW */
@@ -0,0 +1,459 @@
+/**
+ * SDL_sound; An abstract sound format decoding API.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+/*
+ * Sample rate conversion, for apps that want to choose between quality and
+ *  CPU time per sample instead of taking whatever SDL_AudioStream does.
+ *
+ * Input is converted to float (and downmixed, if the app wants fewer
+ *  channels) on the way in, and stored one channel per array, so the filter
+ *  is a straight dot product. Output is converted (and upmixed) to the
+ *  desired format on the way out. Both conversions use the kernels in
+ *  SDL_sound_convert.c.
+ *
+ * The position in the input is kept in 32.32 fixed point, so rates don't
+ *  drift apart no matter how long the sample plays.
+ *
+ * SOUND_RESAMPLE_LINEAR interpolates between neighbouring frames.
+ *
+ * SOUND_RESAMPLE_SINC is a Kaiser-windowed sinc filter, precalculated at
+ *  SINC_PHASES fractional positions, and interpolated linearly between
+ *  them. The cutoff drops below the output's Nyquist frequency when
+ *  downsampling, and the filter gets longer to match, up to SINC_MAX_TAPS.
+ */
+
+#define __SDL_SOUND_INTERNAL__
+#include "SDL_sound_internal.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SOUND_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define SOUND_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define SINC_ZERO_CROSSINGS 16     /* each side, at full bandwidth. */
+#define SINC_MAX_TAPS 256
+#define SINC_PHASE_BITS 7
+#define SINC_PHASES (1 << SINC_PHASE_BITS)
+#define SINC_CUTOFF 0.95           /* leave room for the transition band. */
+#define SINC_KAISER_BETA 9.0       /* about -90dB stopband. */
+
+struct __SOUND_RESAMPLER__
+{
+    Sound_ResampleMode mode;
+    Uint32 channels;         /* what we resample in; the smaller of src and dst. */
+    Sound_Converter in_cvt;  /* source format to float. */
+    Sound_Converter out_cvt; /* float to desired format. */
+    Uint64 step;             /* input frames per output frame, 32.32. */
+    Uint64 position;         /* next output frame's spot in (input), 32.32. */
+    Uint32 left;             /* frames the filter needs before the position... */
+    Uint32 right;            /* ...and after it. */
+    Uint32 taps;             /* left + right + 1; a multiple of 4 for sinc. */
+    float *filter;           /* (SINC_PHASES + 1) rows of (taps) coefficients. */
+    float *coefs;            /* one interpolated row of (filter). */
+    float *input;            /* (channels) arrays of (capacity) frames. */
+    Uint32 capacity;
+    Uint32 input_frames;
+    Uint32 end;              /* first padding frame, once flushed. */
+    SDL_bool flushed;
+    float *scratch;          /* SOUND_RESAMPLE_CHUNK_FRAMES interleaved frames. */
+    int use_simd;
+};
+
+
+/* zeroth-order modified Bessel function of the first kind, for the window. */
+static double bessel_i0(const double x)
+{
+    const double y = (x * x) / 4.0;
+    double sum = 1.0;
+    double term = 1.0;
+    int k;
+
+    for (k = 1; k < 64; k++)
+    {
+        term *= y / (((double) k) * ((double) k));
+        sum += term;
+        if (term < (sum * 1e-12))
+            break;
+    } /* for */
+
+    return sum;
+} /* bessel_i0 */
+
+
+static int build_sinc_filter(Sound_Resampler *rs, const Uint32 src_rate,
+                             const Uint32 dst_rate)
+{
+    const double pi = 3.14159265358979323846;
+    const double ratio = ((double) dst_rate) / ((double) src_rate);
+    const double cutoff = SINC_CUTOFF * ((ratio < 1.0) ? ratio : 1.0);
+    const double i0beta = bessel_i0(SINC_KAISER_BETA);
+    Uint32 taps = (Uint32) SDL_ceil((2.0 * SINC_ZERO_CROSSINGS) / cutoff);
+    double halfwidth;
+    Uint32 phase, i;
+
+    taps = (taps + 3) & ~3;  /* SIMD does four at a time. */
+    if (taps > SINC_MAX_TAPS)
+        taps = SINC_MAX_TAPS;
+
+    rs->taps = taps;
+    rs->left = (taps / 2) - 1;
+    rs->right = taps / 2;
+    halfwidth = (double) (taps / 2);
+
+    rs->filter = (float *) __Sound_SIMDAlloc((SINC_PHASES + 1) * taps * sizeof (float));
+    rs->coefs = (float *) __Sound_SIMDAlloc(taps * sizeof (float));
+    BAIL_IF_MACRO(!rs->filter || !rs->coefs, ERR_OUT_OF_MEMORY, 0);
+
+    for (phase = 0; phase <= SINC_PHASES; phase++)
+    {
+        float *row = rs->filter + (phase * taps);
+        for (i = 0; i < taps; i++)
+        {
+            /* distance from this tap to the output position, in input frames. */
+            const double d = (((double) i) - ((double) rs->left)) - (((double) phase) / SINC_PHASES);
+            const double x = d / halfwidth;
+            double val = cutoff;
+
+            if (d != 0.0)
+                val = SDL_sin(pi * cutoff * d) / (pi * d);
+
+            if ((x <= -1.0) || (x >= 1.0))
+                val = 0.0;
+            else
+                val *= bessel_i0(SINC_KAISER_BETA * SDL_sqrt(1.0 - (x * x))) / i0beta;
+
+            row[i] = (float) val;
+        } /* for */
+    } /* for */
+
+    return 1;
+} /* build_sinc_filter */
+
+
+Sound_Resampler *__Sound_CreateResampler(Sound_ResampleMode mode,
+                                         const Sound_AudioInfo *src,
+                                         const Sound_AudioInfo *dst)
+{
+    Sound_Resampler *rs = NULL;
+    Sound_AudioInfo mid;
+    Sound_AudioInfo info;
+
+    if ((mode != SOUND_RESAMPLE_LINEAR) && (mode != SOUND_RESAMPLE_SINC))
+        return NULL;
+    else if ((src->channels < 1) || (src->channels > 2))
+        return NULL;
+    else if ((dst->channels < 1) || (dst->channels > 2))
+        return NULL;
+    else if ((src->rate == 0) || (dst->rate == 0))
+        return NULL;
+
+    rs = (Sound_Resampler *) SDL_calloc(1, sizeof (Sound_Resampler));
+    BAIL_IF_MACRO(rs == NULL, ERR_OUT_OF_MEMORY, NULL);
+
+    rs->mode = mode;
+    rs->channels = SDL_min(src->channels, dst->channels);
+    /* round up, or a whole number of seconds in makes an extra frame out. */
+    rs->step = ((((Uint64) src->rate) << 32) + dst->rate - 1) / dst->rate;
+
+    /* the converters don't resample, so lie to them about the rates. */
+    mid.format = AUDIO_F32SYS;
+    mid.channels = (Uint8) rs->channels;
+    mid.rate = src->rate;
+    SDL_memcpy(&info, src, sizeof (Sound_AudioInfo));
+    __Sound_SetupConverter(&rs->in_cvt, &info, &mid);
+    SDL_memcpy(&info, dst, sizeof (Sound_AudioInfo));
+    info.rate = src->rate;
+    __Sound_SetupConverter(&rs->out_cvt, &mid, &info);
+    rs->use_simd = rs->in_cvt.use_simd;
+
+    if (mode == SOUND_RESAMPLE_LINEAR)
+    {
+        rs->left = 0;
+        rs->right = 1;
+        rs->taps = 2;
+    } /* if */
+
+    else if (!build_sinc_filter(rs, src->rate, dst->rate))
+    {
+        __Sound_DestroyResampler(rs);
+        return NULL;
+    } /* else if */
+
+    /* room for a full Put(), plus the filter's history, plus padding at EOF. */
+    rs->capacity = SOUND_RESAMPLE_CHUNK_FRAMES + rs->taps + rs->right + 1;
+    rs->input = (float *) __Sound_SIMDAlloc(rs->capacity * rs->channels * sizeof (float));
+    rs->scratch = (float *) __Sound_SIMDAlloc(SOUND_RESAMPLE_CHUNK_FRAMES * SOUND_MAX_CHANNELS * sizeof (float));
+    if ((rs->input == NULL) || (rs->scratch == NULL))
+    {
+        __Sound_DestroyResampler(rs);
+        BAIL_MACRO(ERR_OUT_OF_MEMORY, NULL);
+    } /* if */
+
+    __Sound_ResamplerClear(rs);
+    return rs;
+} /* __Sound_CreateResampler */
+
+
+void __Sound_DestroyResampler(Sound_Resampler *rs)
+{
+    if (rs != NULL)
+    {
+        __Sound_SIMDFree(rs->filter);
+        __Sound_SIMDFree(rs->coefs);
+        __Sound_SIMDFree(rs->input);
+        __Sound_SIMDFree(rs->scratch);
+        SDL_free(rs);
+    } /* if */
+} /* __Sound_DestroyResampler */
+
+
+void __Sound_ResamplerClear(Sound_Resampler *rs)
+{
+    Uint32 ch;
+
+    /* start with silence before the first frame, so the filter has history. */
+    for (ch = 0; ch < rs->channels; ch++)
+        SDL_memset(rs->input + (ch * rs->capacity), '\0', rs->left * sizeof (float));
+
+    rs->input_frames = rs->left;
+    rs->position = ((Uint64) rs->left) << 32;
+    rs->end = 0;
+    rs->flushed = SDL_FALSE;
+} /* __Sound_ResamplerClear */
+
+
+/* throw away input the filter won't look at again. */
+static void compact_input(Sound_Resampler *rs)
+{
+    const Uint32 pos = (Uint32) (rs->position >> 32);
+    Uint32 drop;
+    Uint32 ch;
+
+    if (pos <= rs->left)
+        return;
+
+    drop = SDL_min(pos - rs->left, rs->input_frames);
+    for (ch = 0; ch < rs->channels; ch++)
+    {
+        float *chan = rs->input + (ch * rs->capacity);
+        SDL_memmove(chan, chan + drop, (rs->input_frames - drop) * sizeof (float));
+    } /* for */
+
+    rs->input_frames -= drop;
+    rs->position -= ((Uint64) drop) << 32;
+    if (rs->flushed)
+        rs->end -= drop;
+} /* compact_input */
+
+
+void __Sound_ResamplerPut(Sound_Resampler *rs, const void *src, Uint32 frames)
+{
+    const float *in = rs->scratch;
+    Uint32 i;
+
+    SDL_assert(!rs->flushed);
+    SDL_assert(frames <= SOUND_RESAMPLE_CHUNK_FRAMES);
+
+    compact_input(rs);
+    SDL_assert((rs->input_frames + frames + rs->right) <= rs->capacity);
+
+    rs->in_cvt.func(&rs->in_cvt, src, rs->scratch, frames);
+
+    if (rs->channels == 1)
+        SDL_memcpy(rs->input + rs->input_frames, in, frames * sizeof (float));
+    else
+    {
+        float *left = rs->input + rs->input_frames;
+        float *right = left + rs->capacity;
+        for (i = 0; i < frames; i++, in += 2)
+        {
+            left[i] = in[0];
+            right[i] = in[1];
+        } /* for */
+    } /* else */
+
+    rs->input_frames += frames;
+} /* __Sound_ResamplerPut */
+
+
+void __Sound_ResamplerFlush(Sound_Resampler *rs)
+{
+    Uint32 ch, i;
+
+    if (rs->flushed)
+        return;
+
+    compact_input(rs);
+
+    rs->end = rs->input_frames;
+    for (ch = 0; ch < rs->channels; ch++)
+    {
+        float *chan = rs->input + (ch * rs->capacity);
+
+        /* the sinc filter should fade out into silence, but interpolating
+           toward silence would just put a click on the last frame. */
+        float pad = 0.0f;
+        if ((rs->mode == SOUND_RESAMPLE_LINEAR) && (rs->input_frames > 0))
+            pad = chan[rs->input_frames - 1];
+
+        for (i = 0; i < rs->right; i++)
+            chan[rs->input_frames + i] = pad;
+    } /* for */
+
+    rs->input_frames += rs->right;
+    rs->flushed = SDL_TRUE;
+} /* __Sound_ResamplerFlush */
+
+
+/* interpolate a row of coefficients between two phases of the filter. */
+static void blend_coefs(const Sound_Resampler *rs, const float *c0,
+                        const float *c1, const float frac)
+{
+    float *dst = rs->coefs;
+    const Uint32 taps = rs->taps;
+    Uint32 i = 0;
+
+#if SOUND_HAVE_SSE2
+    if (rs->use_simd)
+    {
+        const __m128 f = _mm_set1_ps(frac);
+        for (; i < taps; i += 4)
+        {
+            const __m128 a = _mm_load_ps(c0 + i);
+            const __m128 b = _mm_load_ps(c1 + i);
+            _mm_store_ps(dst + i, _mm_add_ps(a, _mm_mul_ps(f, _mm_sub_ps(b, a))));
+        } /* for */
+    } /* if */
+#elif SOUND_HAVE_NEON
+    if (rs->use_simd)
+    {
+        const float32x4_t f = vdupq_n_f32(frac);
+        for (; i < taps; i += 4)
+        {
+            const float32x4_t a = vld1q_f32(c0 + i);
+            const float32x4_t b = vld1q_f32(c1 + i);
+            vst1q_f32(dst + i, vmlaq_f32(a, f, vsubq_f32(b, a)));
+        } /* for */
+    } /* if */
+#endif
+
+    for (; i < taps; i++)
+        dst[i] = c0[i] + (frac * (c1[i] - c0[i]));
+} /* blend_coefs */
+
+
+static float dot_product(const Sound_Resampler *rs, const float *x)
+{
+    const float *c = rs->coefs;
+    const Uint32 taps = rs->taps;
+    float retval = 0.0f;
+    Uint32 i = 0;
+
+#if SOUND_HAVE_SSE2
+    if (rs->use_simd)
+    {
+        float sums[4];
+        __m128 sum = _mm_setzero_ps();
+        for (; i < taps; i += 4)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_load_ps(c + i)));
+        _mm_storeu_ps(sums, sum);
+        retval = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    } /* if */
+#elif SOUND_HAVE_NEON
+    if (rs->use_simd)
+    {
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (; i < taps; i += 4)
+            sum = vmlaq_f32(sum, vld1q_f32(x + i), vld1q_f32(c + i));
+        retval = (vgetq_lane_f32(sum, 0) + vgetq_lane_f32(sum, 1)) +
+                 (vgetq_lane_f32(sum, 2) + vgetq_lane_f32(sum, 3));
+    } /* if */
+#endif
+
+    for (; i < taps; i++)
+        retval += x[i] * c[i];
+
+    return retval;
+} /* dot_product */
+
+
+/* resample up to (frames) interleaved float frames into (out). */
+static Uint32 resample(Sound_Resampler *rs, float *out, const Uint32 frames)
+{
+    const Uint32 channels = rs->channels;
+    const Uint32 limit = rs->flushed ? rs->end : (rs->input_frames - SDL_min(rs->input_frames, rs->right));
+    Uint64 position = rs->position;
+    Uint32 retval = 0;
+    Uint32 ch;
+
+    while (retval < frames)
+    {
+        const Uint32 pos = (Uint32) (position >> 32);
+        const Uint32 frac = (Uint32) (position & 0xFFFFFFFF);
+
+        if (pos >= limit)
+            break;
+
+        if (rs->mode == SOUND_RESAMPLE_LINEAR)
+        {
+            const float f = ((float) frac) * (1.0f / 4294967296.0f);
+            for (ch = 0; ch < channels; ch++)
+            {
+                const float *chan = rs->input + (ch * rs->capacity) + pos;
+                *(out++) = chan[0] + (f * (chan[1] - chan[0]));
+            } /* for */
+        } /* if */
+        else
+        {
+            const Uint32 phase = frac >> (32 - SINC_PHASE_BITS);
+            const float f = ((float) (frac & ((1u << (32 - SINC_PHASE_BITS)) - 1))) *
+                            (1.0f / ((float) (1u << (32 - SINC_PHASE_BITS))));
+            const float *c0 = rs->filter + (phase * rs->taps);
+            blend_coefs(rs, c0, c0 + rs->taps, f);
+            for (ch = 0; ch < channels; ch++)
+                *(out++) = dot_product(rs, rs->input + (ch * rs->capacity) + (pos - rs->left));
+        } /* else */
+
+        position += rs->step;
+        retval++;
+    } /* while */
+
+    rs->position = position;
+    return retval;
+} /* resample */
+
+
+Uint32 __Sound_ResamplerGet(Sound_Resampler *rs, void *_dst, Uint32 frames)
+{
+    Uint8 *dst = (Uint8 *) _dst;
+    Uint32 retval = 0;
+
+    while (retval < frames)
+    {
+        const Uint32 want = SDL_min(frames - retval, SOUND_RESAMPLE_CHUNK_FRAMES);
+        const Uint32 got = resample(rs, rs->scratch, want);
+        if (got == 0)
+            break;
+
+        rs->out_cvt.func(&rs->out_cvt, rs->scratch, dst, got);
+        dst += got * rs->out_cvt.dst_framesize;
+        retval += got;
+
+        if (got < want)
+            break;  /* need more input. */
+    } /* while */
+
+    return retval;
+} /* __Sound_ResamplerGet */
+
+/* end of SDL_sound_resample.c ... */
@@ -35,6 +35,21 @@
 
 #define SHN_BUFSIZ  512
 
+/*
+ * Everything the decoder needs to pick up at a block boundary: where the
+ *  bit reader is, plus the last (nwrap) samples and the (nmean) running
+ *  means of each channel, which live in a separate array of Sint32s.
+ */
+typedef struct
+{
+    Uint64 frame;   /* sample frames decoded before this point. */
+    Sint64 pos;     /* stream offset of the next unread byte. */
+    Uint32 gbuffer;
+    int nbitget;
+    Sint32 blocksize;
+    Sint32 bitshift;
+} shn_checkpoint;
+
 typedef struct
 {
     Sint32 version;
@@ -57,7 +72,17 @@ typedef struct
     Uint8 *backBuffer;
     Uint32 backBufferSize;
     Uint32 backBufLeft;
-    Sint64 start_pos;
+    Uint64 skipBytes;
+    Uint64 frames;
+    Uint64 total_frames;
+    Uint32 state_size;
+    shn_checkpoint start;
+    Sint32 *start_state;
+    shn_checkpoint *index;
+    Sint32 *index_state;
+    Uint32 index_count;
+    Uint32 index_alloc;
+    Uint64 next_checkpoint;
 } shn_t;
 
 
@@ -503,6 +528,7 @@ static SDL_INLINE int parse_riff_header(shn_t *shn, Sound_Sample *sample)
     Uint32 u32;
     Sint32 cklen;
     Uint32 bytes_per_second;
+    Uint16 blockalign;
 
     BAIL_IF_MACRO(!uvar_get(SHN_VERBATIM_CKSIZE_SIZE, shn, rw, &cklen), NULL, 0);
 
@@ -526,6 +552,7 @@ static SDL_INLINE int parse_riff_header(shn_t *shn, Sound_Sample *sample)
     BAIL_IF_MACRO(!verb_ReadLE32(shn, rw, &u32), NULL, 0); /* bytespersec */
     bytes_per_second = u32;
     BAIL_IF_MACRO(!verb_ReadLE16(shn, rw, &u16), NULL, 0); /* blockalign */
+    blockalign = u16;
     BAIL_IF_MACRO(!verb_ReadLE16(shn, rw, &u16), NULL, 0); /* bitspersample */
 
     BAIL_IF_MACRO(!verb_ReadLE32(shn, rw, &u32), NULL, 0); /* 'data' header */
@@ -533,10 +560,248 @@ static SDL_INLINE int parse_riff_header(shn_t *shn, Sound_Sample *sample)
     BAIL_IF_MACRO(!verb_ReadLE32(shn, rw, &u32), NULL, 0); /* chunksize */
     internal->total_time = u32 / bytes_per_second * 1000;
     internal->total_time += (u32 % bytes_per_second) * 1000 / bytes_per_second;
+    if (blockalign > 0)
+        shn->total_frames = u32 / blockalign;
     return 1;
 } /* parse_riff_header */
 
 
+static void save_checkpoint(shn_t *shn, SDL_RWops *rw,
+                            shn_checkpoint *cp, Sint32 *state)
+{
+    const Sint32 nmean = MAX_MACRO(1, shn->nmean);
+    Sint32 chan;
+
+    cp->frame = shn->frames;
+    cp->pos = SDL_RWtell(rw) - shn->nbyteget;
+    cp->gbuffer = shn->gbuffer;
+    cp->nbitget = shn->nbitget;
+    cp->blocksize = shn->blocksize;
+    cp->bitshift = shn->bitshift;
+
+    for (chan = 0; chan < shn->nchan; chan++)
+    {
+        SDL_memcpy(state, shn->buffer[chan] - shn->nwrap,
+                   shn->nwrap * sizeof (Sint32));
+        state += shn->nwrap;
+        SDL_memcpy(state, shn->offset[chan], nmean * sizeof (Sint32));
+        state += nmean;
+    } /* for */
+} /* save_checkpoint */
+
+
+static int restore_checkpoint(shn_t *shn, SDL_RWops *rw,
+                              const shn_checkpoint *cp, const Sint32 *state)
+{
+    const Sint32 nmean = MAX_MACRO(1, shn->nmean);
+    Sint32 chan;
+
+    BAIL_IF_MACRO(SDL_RWseek(rw, cp->pos, RW_SEEK_SET) != cp->pos, ERR_IO_ERROR, 0);
+
+    /* the next word_get() refills the input buffer from here. */
+    shn->nbyteget = 0;
+    shn->getbufp = shn->getbuf;
+    shn->gbuffer = cp->gbuffer;
+    shn->nbitget = cp->nbitget;
+    shn->blocksize = cp->blocksize;
+    shn->bitshift = cp->bitshift;
+    shn->frames = cp->frame;
+    shn->backBufLeft = 0;
+    shn->skipBytes = 0;
+
+    for (chan = 0; chan < shn->nchan; chan++)
+    {
+        SDL_memcpy(shn->buffer[chan] - shn->nwrap, state,
+                   shn->nwrap * sizeof (Sint32));
+        state += shn->nwrap;
+        SDL_memcpy(shn->offset[chan], state, nmean * sizeof (Sint32));
+        state += nmean;
+    } /* for */
+
+    return 1;
+} /* restore_checkpoint */
+
+
+static int grow_index(shn_t *shn, Uint32 count)
+{
+    const Uint32 stride = shn->state_size / sizeof (Sint32);
+    Uint32 alloc = shn->index_alloc ? shn->index_alloc : 64;
+    void *ptr;
+
+    if (count <= shn->index_alloc)
+        return 1;
+
+    while (alloc < count)
+        alloc *= 2;
+
+    ptr = SDL_realloc(shn->index, alloc * sizeof (shn_checkpoint));
+    BAIL_IF_MACRO(ptr == NULL, ERR_OUT_OF_MEMORY, 0);
+    shn->index = (shn_checkpoint *) ptr;
+
+    ptr = SDL_realloc(shn->index_state, alloc * stride * sizeof (Sint32));
+    BAIL_IF_MACRO(ptr == NULL, ERR_OUT_OF_MEMORY, 0);
+    shn->index_state = (Sint32 *) ptr;
+
+    shn->index_alloc = alloc;
+    return 1;
+} /* grow_index */
+
+
+/*
+ * Called at block boundaries while decoding, when we've gone further into
+ *  the stream than the index reaches. Failing to grow the index isn't an
+ *  error; seeks just have further to decode from the last checkpoint.
+ */
+static void add_checkpoint(Sound_Sample *sample, shn_t *shn)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    const Uint32 stride = shn->state_size / sizeof (Sint32);
+    const Uint64 interval = MAX_MACRO(sample->actual.rate, (Uint32) shn->blocksize);
+
+    if (grow_index(shn, shn->index_count + 1))
+    {
+        save_checkpoint(shn, internal->rw, &shn->index[shn->index_count],
+                        shn->index_state + (shn->index_count * stride));
+        shn->index_count++;
+    } /* if */
+
+    shn->next_checkpoint = shn->frames + interval;
+} /* add_checkpoint */
+
+
+/*
+ * Shorten 3.5 and later can append a seek table to the stream: a "SEEK"
+ *  header, an 80 byte entry every 25600 sample frames, and a trailer that
+ *  ends with "SHNAMPSK", possibly followed by an ID3v1 tag. Each entry is a
+ *  snapshot of the decoder like our checkpoints, which is all we need to
+ *  seek without decoding the whole file first.
+ *
+ * Entries only have room for two channels, three samples of history and
+ *  four means, so streams that need more than that build their own index.
+ */
+#define SHN_SEEK_HEADER_SIZE   12
+#define SHN_SEEK_TRAILER_SIZE  12
+#define SHN_SEEK_ENTRY_SIZE    80
+#define SHN_ID3V1_SIZE         128
+
+static SDL_INLINE Uint32 seek_entry_u16(const Uint8 *ptr)
+{
+    return ((Uint32) ptr[0]) | (((Uint32) ptr[1]) << 8);
+} /* seek_entry_u16 */
+
+
+static SDL_INLINE Uint32 seek_entry_u32(const Uint8 *ptr)
+{
+    return seek_entry_u16(ptr) | (seek_entry_u16(ptr + 2) << 16);
+} /* seek_entry_u32 */
+
+
+static int find_seek_table(SDL_RWops *rw, Sint64 *tablepos, Uint32 *entries)
+{
+    const Sint64 end = SDL_RWseek(rw, 0, RW_SEEK_END);
+    Uint8 buf[SHN_SEEK_TRAILER_SIZE];
+    Sint64 trailer = end - SHN_SEEK_TRAILER_SIZE;
+    Uint32 size;
+
+    if (trailer < 0)
+        return 0;
+
+    if ( (SDL_RWseek(rw, end - SHN_ID3V1_SIZE, RW_SEEK_SET) >= 0) &&
+         (SDL_RWread(rw, buf, 3, 1) == 1) &&
+         (SDL_memcmp(buf, "TAG", 3) == 0) )
+    {
+        trailer -= SHN_ID3V1_SIZE;
+    } /* if */
+
+    if ( (trailer < 0) ||
+         (SDL_RWseek(rw, trailer, RW_SEEK_SET) != trailer) ||
+         (SDL_RWread(rw, buf, sizeof (buf), 1) != 1) ||
+         (SDL_memcmp(buf + 4, "SHNAMPSK", 8) != 0) )
+    {
+        return 0;
+    } /* if */
+
+    size = seek_entry_u32(buf);
+    if ( (size < SHN_SEEK_HEADER_SIZE + SHN_SEEK_TRAILER_SIZE) ||
+         ((Sint64) size > trailer + SHN_SEEK_TRAILER_SIZE) )
+    {
+        return 0;
+    } /* if */
+
+    *tablepos = (trailer + SHN_SEEK_TRAILER_SIZE) - size;
+    *entries = (size - SHN_SEEK_HEADER_SIZE - SHN_SEEK_TRAILER_SIZE) / SHN_SEEK_ENTRY_SIZE;
+    if ( (SDL_RWseek(rw, *tablepos, RW_SEEK_SET) != *tablepos) ||
+         (SDL_RWread(rw, buf, SHN_SEEK_HEADER_SIZE, 1) != 1) ||
+         (SDL_memcmp(buf, "SEEK", 4) != 0) )
+    {
+        return 0;
+    } /* if */
+
+    return 1;
+} /* find_seek_table */
+
+
+/* (base) is where the stream's magic number is; offsets are from there. */
+static void load_seek_table(shn_t *shn, SDL_RWops *rw, Sint64 base)
+{
+    const Uint32 stride = shn->state_size / sizeof (Sint32);
+    const Sint32 nmean = MAX_MACRO(1, shn->nmean);
+    Sint64 tablepos = 0;
+    Uint32 entries = 0;
+    Uint32 count = 0;
+    Uint32 i;
+
+    if ((shn->nchan > 2) || (shn->nwrap != 3) || (nmean > 4))
+        return;
+    else if (!find_seek_table(rw, &tablepos, &entries))
+        return;
+    else if ((entries == 0) || (!grow_index(shn, entries)))
+        return;
+
+    for (i = 0; i < entries; i++)
+    {
+        shn_checkpoint *cp = &shn->index[count];
+        Sint32 *state = shn->index_state + (count * stride);
+        Uint8 entry[SHN_SEEK_ENTRY_SIZE];
+        Sint32 chan, j;
+
+        if (SDL_RWread(rw, entry, sizeof (entry), 1) != 1)
+            return;  /* leave index_count at zero; we'll build our own. */
+
+        cp->frame = seek_entry_u32(entry);
+        cp->pos = base + seek_entry_u32(entry + 8) + seek_entry_u16(entry + 14);
+        cp->nbitget = (int) seek_entry_u16(entry + 16);
+        cp->gbuffer = seek_entry_u32(entry + 18);
+        cp->bitshift = (Sint32) seek_entry_u16(entry + 22);
+        cp->blocksize = shn->blocksize;
+
+        if ( (cp->nbitget > 32) || (cp->pos < shn->start.pos) ||
+             (cp->pos >= tablepos) ||
+             ((count > 0) && (cp->frame <= cp[-1].frame)) )
+        {
+            return;  /* this doesn't look right, don't trust any of it. */
+        } /* if */
+
+        for (chan = 0; chan < shn->nchan; chan++)
+        {
+            /* history is stored newest first. */
+            for (j = 0; j < 3; j++)
+                state[2 - j] = (Sint32) seek_entry_u32(entry + 24 + (12 * chan) + (4 * j));
+            state += 3;
+            for (j = 0; j < nmean; j++)
+                state[j] = (Sint32) seek_entry_u32(entry + 48 + (16 * chan) + (4 * j));
+            state += nmean;
+        } /* for */
+
+        if (cp->frame > 0)  /* the start of the stream is already covered. */
+            count++;
+    } /* for */
+
+    shn->index_count = count;
+    shn->next_checkpoint = ~((Uint64) 0);  /* the table covers it all. */
+} /* load_seek_table */
+
+
 static int SHN_open(Sound_Sample *sample, const char *ext)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
@@ -545,6 +810,7 @@ static int SHN_open(Sound_Sample *sample, const char *ext)
     shn_t *shn = &_shn;  /* malloc and copy later. */
     Sint32 cmd;
     Sint32 chan;
+    Sint64 base;
 
     SDL_memset(shn, '\0', sizeof (shn_t));
     shn->getbufp = shn->getbuf = (Uint8 *) SDL_malloc(SHN_BUFSIZ);
@@ -556,6 +822,7 @@ static int SHN_open(Sound_Sample *sample, const char *ext)
     shn->version = determine_shn_version(sample, ext);
 
     if (shn->version == -1) goto shn_open_puke;
+    base = SDL_RWtell(rw) - 5;  /* magic number and version byte. */
     if (!uint_get(SHN_TYPESIZE, shn, rw, &shn->datatype)) goto shn_open_puke;
     if (!uint_get(SHN_CHANNELSIZE, shn, rw, &shn->nchan)) goto shn_open_puke;
 
@@ -617,7 +884,21 @@ static int SHN_open(Sound_Sample *sample, const char *ext)
         return 0;
     } /* if */
 
-    shn->start_pos = SDL_RWtell(rw);
+    /* remember where the audio starts, so rewinding is just a reset. */
+    shn->state_size = shn->nchan * (shn->nwrap + MAX_MACRO(1, shn->nmean)) *
+                      sizeof (Sint32);
+    shn->start_state = (Sint32 *) SDL_malloc(shn->state_size);
+    if (shn->start_state == NULL)
+    {
+        __Sound_SetError(ERR_OUT_OF_MEMORY);
+        goto shn_open_puke;
+    } /* if */
+
+    save_checkpoint(shn, rw, &shn->start, shn->start_state);
+    shn->next_checkpoint = MAX_MACRO(sample->actual.rate, (Uint32) shn->blocksize);
+    load_seek_table(shn, rw, base);
+    if (!restore_checkpoint(shn, rw, &shn->start, shn->start_state))
+        goto shn_open_puke;
 
     shn = (shn_t *) SDL_malloc(sizeof (shn_t));
     if (shn == NULL)
@@ -630,12 +911,23 @@ static int SHN_open(Sound_Sample *sample, const char *ext)
     internal->decoder_private = shn;
 
     SNDDBG(("SHN: Accepting data stream.\n"));
-    sample->flags = SOUND_SAMPLEFLAG_NONE;
+    SNDDBG(("SHN: %u seek table entries.\n", (unsigned int) shn->index_count));
+    sample->flags = SOUND_SAMPLEFLAG_CANSEEK;
+
+    /* without the file's own table, a new instance has to decode its way to
+       any frame, so it's no good for Sound_DecodeAllParallel(). */
+    internal->fast_seek_frame = (shn->index_count > 0) ? SDL_TRUE : SDL_FALSE;
     return 1; /* we'll handle this data. */
 
 shn_open_puke:
     if (_shn.getbuf)
         SDL_free(_shn.getbuf);
+    if (_shn.start_state != NULL)
+        SDL_free(_shn.start_state);
+    if (_shn.index != NULL)
+        SDL_free(_shn.index);
+    if (_shn.index_state != NULL)
+        SDL_free(_shn.index_state);
     if (_shn.buffer != NULL)
         SDL_free(_shn.buffer);
     if (_shn.offset != NULL)
@@ -699,6 +991,15 @@ static void SHN_close(Sound_Sample *sample)
     if (shn->getbuf != NULL)
         SDL_free(shn->getbuf);
 
+    if (shn->start_state != NULL)
+        SDL_free(shn->start_state);
+
+    if (shn->index != NULL)
+        SDL_free(shn->index);
+
+    if (shn->index_state != NULL)
+        SDL_free(shn->index_state);
+
     SDL_free(shn);
 } /* SHN_close */
 
@@ -1006,10 +1307,19 @@ static Uint32 put_to_buffers(Sound_Sample *sample, Uint32 bw)
         break;
     } /* switch */
 
+    /* throw away the start of the block if we're finishing a seek. */
+    if (shn->skipBytes > 0)
+    {
+        const Uint32 skip = (Uint32) MIN_MACRO(shn->skipBytes, (Uint64) bsiz);
+        SDL_memmove(shn->backBuffer, shn->backBuffer + skip, bsiz - skip);
+        shn->skipBytes -= skip;
+        bsiz -= skip;
+    } /* if */
+
     i = MIN_MACRO(internal->buffer_size - bw, bsiz);
     SDL_memcpy((char *)internal->buffer + bw, shn->backBuffer, i);
     shn->backBufLeft = bsiz - i;
-    SDL_memcpy(shn->backBuffer, shn->backBuffer + i, shn->backBufLeft);
+    SDL_memmove(shn->backBuffer, shn->backBuffer + i, shn->backBufLeft);
     return i;
 } /* put_to_buffers */
 
@@ -1031,7 +1341,7 @@ static Uint32 SHN_read(Sound_Sample *sample)
         retval = MIN_MACRO(shn->backBufLeft, internal->buffer_size);
         SDL_memcpy(internal->buffer, shn->backBuffer, retval);
         shn->backBufLeft -= retval;
-        SDL_memcpy(shn->backBuffer, shn->backBuffer + retval, shn->backBufLeft);
+        SDL_memmove(shn->backBuffer, shn->backBuffer + retval, shn->backBufLeft);
     } /* if */
 
     SDL_assert((shn->backBufLeft == 0) || (retval == internal->buffer_size));
@@ -1039,6 +1349,9 @@ static Uint32 SHN_read(Sound_Sample *sample)
     /* get commands from file and execute them */
     while (retval < internal->buffer_size)
     {
+        if ((chan == 0) && (shn->frames >= shn->next_checkpoint))
+            add_checkpoint(sample, shn);
+
         if (!uvar_get(SHN_FNSIZE, shn, rw, &cmd))
         {
             sample->flags |= SOUND_SAMPLEFLAG_ERROR;
@@ -1214,6 +1527,7 @@ static Uint32 SHN_read(Sound_Sample *sample)
 
                 if (chan == shn->nchan - 1)
                 {
+                    shn->frames += shn->blocksize;
                     retval += put_to_buffers(sample, retval);
                     if (sample->flags & SOUND_SAMPLEFLAG_ERROR)
                         return retval;
@@ -1254,34 +1568,53 @@ static Uint32 SHN_read(Sound_Sample *sample)
 static int SHN_rewind(Sound_Sample *sample)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    shn_t *shn = (shn_t *) internal->decoder_private;
+    return restore_checkpoint(shn, internal->rw, &shn->start, shn->start_state);
+} /* SHN_rewind */
 
-#if 0
+
+/*
+ * Go back to the last checkpoint at or before (frame), and let SHN_read()
+ *  decode and discard the rest of the way. Past the end of the index, that
+ *  adds checkpoints as it goes, so the next seek there is cheap.
+ */
+static int SHN_seek_frame(Sound_Sample *sample, Uint64 frame)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     shn_t *shn = (shn_t *) internal->decoder_private;
-    Sint64 rc = SDL_RWseek(internal->rw, shn->start_pos, RW_SEEK_SET);
-    BAIL_IF_MACRO(rc != shn->start_pos, ERR_IO_ERROR, 0);
-    /* !!! FIXME: set state. */
+    const Uint32 framesize = ((sample->actual.format & 0xFF) / 8) * shn->nchan;
+    const shn_checkpoint *cp = &shn->start;
+    const Sint32 *state = shn->start_state;
+    Uint32 lo = 0;
+    Uint32 hi = shn->index_count;
+
+    BAIL_IF_MACRO((shn->total_frames > 0) && (frame > shn->total_frames),
+                  ERR_INVALID_ARGUMENT, 0);
+
+    while (lo < hi)  /* find the first checkpoint past (frame)... */
+    {
+        const Uint32 mid = lo + ((hi - lo) / 2);
+        if (shn->index[mid].frame <= frame)
+            lo = mid + 1;
+        else
+            hi = mid;
+    } /* while */
+
+    if (lo > 0)  /* ...and use the one before it. */
+    {
+        cp = &shn->index[lo - 1];
+        state = shn->index_state + ((lo - 1) * (shn->state_size / sizeof (Sint32)));
+    } /* if */
+
+    BAIL_IF_MACRO(!restore_checkpoint(shn, internal->rw, cp, state), NULL, 0);
+    shn->skipBytes = (frame - cp->frame) * framesize;
     return 1;
-#else
-    /*
-     * !!! FIXME: This is really unacceptable; state should be reset and
-     * !!! FIXME:  the RWops should be pointed to the start of the data
-     * !!! FIXME:  to decode. The below kludge adds unneeded overhead and
-     * !!! FIXME:  risk of failure.
-     */
-    BAIL_IF_MACRO(SDL_RWseek(internal->rw, 0, RW_SEEK_SET) != 0, ERR_IO_ERROR, 0);
-    SHN_close(sample);
-    return SHN_open(sample, "SHN");
-#endif
-} /* SHN_rewind */
+} /* SHN_seek_frame */
 
 
 static int SHN_seek(Sound_Sample *sample, Uint32 ms)
 {
-    /*
-     * (This CAN be done for SHNs that have a seek table at the end of the
-     *  stream, btw.)
-     */
-    BAIL_MACRO("SHN: Seeking not implemented", 0);
+    return SHN_seek_frame(sample, __Sound_convertMsToFrames(sample->actual.rate, ms));
 } /* SHN_seek */
 
 
@@ -1301,7 +1634,9 @@ const Sound_DecoderFunctions __Sound_DecoderFunctions_SHN =
     SHN_close,      /*  close() method */
     SHN_read,       /*   read() method */
     SHN_rewind,     /* rewind() method */
-    SHN_seek        /*   seek() method */
+    SHN_seek,       /*   seek() method */
+    NULL,           /* read_into() method */
+    SHN_seek_frame  /* seek_frame() method */
 };
 
 #endif  /* defined SOUND_SUPPORTS_SHN */
@@ -134,6 +134,8 @@ static int VORBIS_open(Sound_Sample *sample, const char *ext)
         internal->total_time += (num_frames % rate) * 1000 / rate;
     } /* else */
 
+    internal->fast_seek_frame = SDL_TRUE;  /* stb_vorbis bisects the pages. */
+
     return 1; /* we'll handle this data. */
 } /* VORBIS_open */
 
@@ -188,15 +190,19 @@ static int VORBIS_rewind(Sound_Sample *sample)
 } /* VORBIS_rewind */
 
 
-static int VORBIS_seek(Sound_Sample *sample, Uint32 ms)
+static int VORBIS_seek_frame(Sound_Sample *sample, Uint64 frame)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     stb_vorbis *stb = (stb_vorbis *) internal->decoder_private;
-    const float frames_per_ms = ((float) sample->actual.rate) / 1000.0f;
-    const Uint32 frame_offset = (Uint32) (frames_per_ms * ((float) ms));
-    const unsigned int sampnum = (unsigned int) frame_offset;
-    BAIL_IF_MACRO(!stb_vorbis_seek(stb, sampnum), vorbis_error_string(stb_vorbis_get_error(stb)), 0);
+    BAIL_IF_MACRO(frame > 0xFFFFFFFF, ERR_INVALID_ARGUMENT, 0);
+    BAIL_IF_MACRO(!stb_vorbis_seek(stb, (unsigned int) frame), vorbis_error_string(stb_vorbis_get_error(stb)), 0);
     return 1;
+} /* VORBIS_seek_frame */
+
+
+static int VORBIS_seek(Sound_Sample *sample, Uint32 ms)
+{
+    return VORBIS_seek_frame(sample, __Sound_convertMsToFrames(sample->actual.rate, ms));
 } /* VORBIS_seek */
 
 
@@ -216,7 +222,9 @@ const Sound_DecoderFunctions __Sound_DecoderFunctions_VORBIS =
     VORBIS_close,      /*  close() method */
     VORBIS_read,       /*   read() method */
     VORBIS_rewind,     /* rewind() method */
-    VORBIS_seek        /*   seek() method */
+    VORBIS_seek,       /*   seek() method */
+    NULL,              /* read_into() method */
+    VORBIS_seek_frame  /* seek_frame() method */
 };
 
 #endif /* SOUND_SUPPORTS_VORBIS */
@@ -73,6 +73,7 @@ static SDL_INLINE int read_uint8(SDL_RWops *rw, Uint8 *ui8)
 #define FMT_NORMAL     0x0001   /* Uncompressed waveform data.     */
 #define FMT_ADPCM      0x0002   /* ADPCM compressed waveform data. */
 #define FMT_IEEE_FLOAT 0x0003   /* Uncompressed IEEE floating point waveform data. */
+#define FMT_IMA_ADPCM  0x0011   /* IMA ADPCM compressed waveform data. */
 #define FMT_EXTENSIBLE 0xFFFE   /* "Extensible" tag */
 
 typedef struct
@@ -81,14 +82,6 @@ typedef struct
     Sint16 iCoef2;
 } ADPCMCOEFSET;
 
-typedef struct
-{
-    Uint8 bPredictor;
-    Uint16 iDelta;
-    Sint16 iSamp1;
-    Sint16 iSamp2;
-} ADPCMBLOCKHEADER;
-
 typedef struct S_WAV_FMT_T
 {
     Uint32 chunkID;
@@ -107,9 +100,9 @@ typedef struct S_WAV_FMT_T
     Uint32 total_bytes;
 
     void (*free)(struct S_WAV_FMT_T *fmt);
-    Uint32 (*read_sample)(Sound_Sample *sample);
+    Uint32 (*read_sample)(Sound_Sample *sample, void *buf, Uint32 buflen);
     int (*rewind_sample)(Sound_Sample *sample);
-    int (*seek_sample)(Sound_Sample *sample, Uint32 ms);
+    int (*seek_sample_frame)(Sound_Sample *sample, Uint64 frame);  /* NULL if can't seek. */
 
     union
     {
@@ -119,10 +112,11 @@ typedef struct S_WAV_FMT_T
             Uint16 wSamplesPerBlock;
             Uint16 wNumCoef;
             ADPCMCOEFSET *aCoef;
-            ADPCMBLOCKHEADER *blockheaders;
-            Uint32 samples_left_in_block;
-            int nibble_state;
-            Sint8 nibble;
+            Uint32 header_size;   /* bytes of block header, all channels. */
+            Uint8 *block;         /* the current block, straight from disk. */
+            Sint16 *decoded;      /* ...and decoded, if it didn't fit in the output. */
+            Uint32 block_frames;  /* sample frames in (decoded). */
+            Uint32 block_pos;     /* next sample frame in (decoded) to output. */
         } adpcm;
 
         /* put other format-specific data here... */
@@ -206,13 +200,14 @@ typedef struct
 /*
  * Sound_Decode() lands here for uncompressed WAVs...
  */
-static Uint32 read_sample_fmt_normal(Sound_Sample *sample)
+static Uint32 read_sample_fmt_normal(Sound_Sample *sample, void *buf,
+                                     Uint32 buflen)
 {
     Uint32 retval;
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     wav_t *w = (wav_t *) internal->decoder_private;
-    Uint32 max = (internal->buffer_size < (Uint32) w->bytesLeft) ?
-                  internal->buffer_size : (Uint32) w->bytesLeft;
+    Uint32 max = (buflen < (Uint32) w->bytesLeft) ?
+                  buflen : (Uint32) w->bytesLeft;
 
     /* We need to convert 24-bit PCM to an SDL-friendly AUDIO_S32SYS ... */
     if (w->fmt->wBitsPerSample == 24) {
@@ -230,9 +225,9 @@ static Uint32 read_sample_fmt_normal(Sound_Sample *sample)
 
         /*
          * We don't actually do any decoding, so we read the wav data
-         *  directly into the internal buffer...
+         *  directly into the output buffer...
          */
-    retval = SDL_RWread(internal->rw, internal->buffer, 1, max);
+    retval = SDL_RWread(internal->rw, buf, 1, max);
 
     w->bytesLeft -= retval;
 
@@ -244,14 +239,14 @@ static Uint32 read_sample_fmt_normal(Sound_Sample *sample)
         sample->flags |= SOUND_SAMPLEFLAG_ERROR;
 
         /* (next call this EAGAIN may turn into an EOF or error.) */
-    else if (retval < internal->buffer_size)
+    else if (retval < buflen)
         sample->flags |= SOUND_SAMPLEFLAG_EAGAIN;
 
     /* deal with 24-bit PCM. */
     if ((retval > 0) && (w->fmt->wBitsPerSample == 24)) {
         const Uint32 total = retval / 3;
-        const Uint8 *src = ((Uint8 *)internal->buffer + retval) - 3;
-        Uint32 *dst = (Uint32 *) (((Uint8 *)internal->buffer + (total * 4)) - 4);
+        const Uint8 *src = ((Uint8 *)buf + retval) - 3;
+        Uint32 *dst = (Uint32 *) (((Uint8 *)buf + (total * 4)) - 4);
         Uint32 i;
         for (i = 0; i < total; i++, dst--, src -= 3) {
             const Uint32 sample = ((Uint32) src[0]) | (((Uint32) src[1]) << 8) | (((Uint32) src[2]) << 16);
@@ -264,18 +259,21 @@ static Uint32 read_sample_fmt_normal(Sound_Sample *sample)
 } /* read_sample_fmt_normal */
 
 
-static int seek_sample_fmt_normal(Sound_Sample *sample, Uint32 ms)
+static int seek_sample_frame_fmt_normal(Sound_Sample *sample, Uint64 frame)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     wav_t *w = (wav_t *) internal->decoder_private;
     fmt_t *fmt = w->fmt;
-    const Sint64 offset = __Sound_convertMsToBytePos(&sample->actual, ms);
+    const Sint64 offset = (Sint64) (frame * fmt->wBlockAlign);
     const Sint64 pos = (fmt->data_starting_offset + offset);
-    const Sint64 rc = SDL_RWseek(internal->rw, pos, RW_SEEK_SET);
+    Sint64 rc;
+
+    BAIL_IF_MACRO(offset > (Sint64) fmt->total_bytes, ERR_INVALID_ARGUMENT, 0);
+    rc = SDL_RWseek(internal->rw, pos, RW_SEEK_SET);
     BAIL_IF_MACRO(rc != pos, ERR_IO_ERROR, 0);
     w->bytesLeft = fmt->total_bytes - offset;
     return 1;  /* success. */
-} /* seek_sample_fmt_normal */
+} /* seek_sample_frame_fmt_normal */
 
 
 static int rewind_sample_fmt_normal(Sound_Sample *sample)
@@ -291,7 +289,7 @@ static int read_fmt_normal(SDL_RWops *rw, fmt_t *fmt)
     fmt->free = NULL;
     fmt->read_sample = read_sample_fmt_normal;
     fmt->rewind_sample = rewind_sample_fmt_normal;
-    fmt->seek_sample = seek_sample_fmt_normal;
+    fmt->seek_sample_frame = seek_sample_frame_fmt_normal;
     return 1;
 } /* read_fmt_normal */
 
@@ -304,185 +302,279 @@ static int read_fmt_normal(SDL_RWops *rw, fmt_t *fmt)
 #define FIXED_POINT_COEF_BASE      256
 #define FIXED_POINT_ADAPTION_BASE  256
 #define SMALLEST_ADPCM_DELTA       16
+#define IMA_ADPCM_MAX_INDEX        88
 
+/*
+ * Both kinds of ADPCM come in blocks of (wBlockAlign) bytes: a header per
+ *  channel, then four-bit codes for the rest of the block's sample frames.
+ *  Blocks are independent of each other, so we decode a whole block at a
+ *  time, one channel after another, and seeking is just picking the right
+ *  block. The last block in the file is allowed to be short.
+ */
 
-static SDL_INLINE int read_adpcm_block_headers(Sound_Sample *sample)
+static SDL_INLINE Sint32 adpcm_le16s(const Uint8 *ptr)
 {
-    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
-    SDL_RWops *rw = internal->rw;
-    wav_t *w = (wav_t *) internal->decoder_private;
-    fmt_t *fmt = w->fmt;
-    ADPCMBLOCKHEADER *headers = fmt->fmt.adpcm.blockheaders;
-    int i;
-    int max = fmt->wChannels;
+    return (Sint32) ((Sint16) (((Uint16) ptr[0]) | (((Uint16) ptr[1]) << 8)));
+} /* adpcm_le16s */
 
-    if (w->bytesLeft < fmt->wBlockAlign)
-    {
-        sample->flags |= SOUND_SAMPLEFLAG_EOF;
-        return 0;
-    } /* if */
 
-    w->bytesLeft -= fmt->wBlockAlign;
+static SDL_INLINE Sint32 clamp_adpcm_sample(Sint32 val)
+{
+    if (val < -32768)
+        return -32768;
+    else if (val > 32767)
+        return 32767;
+    return val;
+} /* clamp_adpcm_sample */
 
-    for (i = 0; i < max; i++)
-        BAIL_IF_MACRO(!read_uint8(rw, &headers[i].bPredictor), NULL, 0);
 
-    for (i = 0; i < max; i++)
-        BAIL_IF_MACRO(!read_le16(rw, &headers[i].iDelta), NULL, 0);
+/* The headers alone hold this many sample frames; no block can have fewer. */
+static SDL_INLINE Uint32 adpcm_min_block_frames(const fmt_t *fmt)
+{
+    return (fmt->wFormatTag == FMT_IMA_ADPCM) ? 1 : 2;
+} /* adpcm_min_block_frames */
 
-    for (i = 0; i < max; i++)
-        BAIL_IF_MACRO(!read_le16s(rw, &headers[i].iSamp1), NULL, 0);
 
-    for (i = 0; i < max; i++)
-        BAIL_IF_MACRO(!read_le16s(rw, &headers[i].iSamp2), NULL, 0);
+/* Sample frames in a block of (len) bytes; (len) covers the headers. */
+static Uint32 adpcm_block_frames(const fmt_t *fmt, Uint32 len)
+{
+    const Uint32 data = len - fmt->fmt.adpcm.header_size;
+    Uint32 retval;
 
-    fmt->fmt.adpcm.samples_left_in_block = fmt->fmt.adpcm.wSamplesPerBlock;
-    fmt->fmt.adpcm.nibble_state = 0;
-    return 1;
-} /* read_adpcm_block_headers */
+    SDL_assert(len >= fmt->fmt.adpcm.header_size);
 
+    if (fmt->wFormatTag == FMT_IMA_ADPCM)  /* eight codes per 4 bytes per channel. */
+        retval = 1 + ((data / (4 * fmt->wChannels)) * 8);
+    else  /* two codes per byte, shared between the channels. */
+        retval = 2 + ((data * 2) / fmt->wChannels);
 
-static SDL_INLINE void do_adpcm_nibble(Uint8 nib,
-                                       ADPCMBLOCKHEADER *header,
-                                       Sint32 lPredSamp)
-{
-	static const Sint32 max_audioval = ((1<<(16-1))-1);
-	static const Sint32 min_audioval = -(1<<(16-1));
-	static const Sint32 AdaptionTable[] =
-    {
-		230, 230, 230, 230, 307, 409, 512, 614,
-		768, 614, 512, 409, 307, 230, 230, 230
-	};
+    return (retval < fmt->fmt.adpcm.wSamplesPerBlock) ?
+            retval : fmt->fmt.adpcm.wSamplesPerBlock;
+} /* adpcm_block_frames */
 
-    Sint32 lNewSamp;
-    Sint32 delta;
 
-    if (nib & 0x08)
-        lNewSamp = lPredSamp + (header->iDelta * (nib - 0x10));
-	else
-        lNewSamp = lPredSamp + (header->iDelta * nib);
+static void decode_ms_adpcm_block(const fmt_t *fmt, const Uint8 *block,
+                                  Uint32 frames, Sint16 *dst)
+{
+    static const Sint32 AdaptionTable[] =
+    {
+        230, 230, 230, 230, 307, 409, 512, 614,
+        768, 614, 512, 409, 307, 230, 230, 230
+    };
 
-        /* clamp value... */
-    if (lNewSamp < min_audioval)
-        lNewSamp = min_audioval;
-    else if (lNewSamp > max_audioval)
-        lNewSamp = max_audioval;
+    const Uint32 max = fmt->wChannels;
+    const Uint8 *codes = block + fmt->fmt.adpcm.header_size;
+    Uint32 chan;
 
-    delta = ((Sint32) header->iDelta * AdaptionTable[nib]) /
-              FIXED_POINT_ADAPTION_BASE;
+    for (chan = 0; chan < max; chan++)
+    {
+        const ADPCMCOEFSET *coef = &fmt->fmt.adpcm.aCoef[block[chan]];
+        const Sint32 iCoef1 = coef->iCoef1;
+        const Sint32 iCoef2 = coef->iCoef2;
+        Sint32 iDelta = (Uint16) adpcm_le16s(block + max + (chan * 2));
+        Sint32 iSamp1 = adpcm_le16s(block + (max * 3) + (chan * 2));
+        Sint32 iSamp2 = adpcm_le16s(block + (max * 5) + (chan * 2));
+        Sint16 *out = dst + chan;
+        Uint32 nib = chan;  /* codes are interleaved by channel, high nibble first. */
+        Uint32 i;
 
-	if (delta < SMALLEST_ADPCM_DELTA)
-	    delta = SMALLEST_ADPCM_DELTA;
+        out[0] = (Sint16) iSamp2;  /* the header has the first two frames. */
+        out[max] = (Sint16) iSamp1;
+        out += max * 2;
 
-    header->iDelta = delta;
-	header->iSamp2 = header->iSamp1;
-	header->iSamp1 = lNewSamp;
-} /* do_adpcm_nibble */
+        for (i = 2; i < frames; i++, nib += max, out += max)
+        {
+            const Uint8 byte = codes[nib >> 1];
+            const Sint32 code = (nib & 1) ? (byte & 0x0F) : (byte >> 4);
+            const Sint32 lPredSamp = ((iSamp1 * iCoef1) + (iSamp2 * iCoef2)) /
+                                      FIXED_POINT_COEF_BASE;
+            const Sint32 lNewSamp = clamp_adpcm_sample(lPredSamp +
+                                        (iDelta * ((code & 0x08) ? (code - 0x10) : code)));
+            Sint32 delta = (iDelta * AdaptionTable[code]) / FIXED_POINT_ADAPTION_BASE;
+
+            if (delta < SMALLEST_ADPCM_DELTA)
+                delta = SMALLEST_ADPCM_DELTA;
+
+            iDelta = (Uint16) delta;
+            iSamp2 = iSamp1;
+            iSamp1 = lNewSamp;
+            *out = (Sint16) lNewSamp;
+        } /* for */
+    } /* for */
+} /* decode_ms_adpcm_block */
 
 
-static SDL_INLINE int decode_adpcm_sample_frame(Sound_Sample *sample)
+static void decode_ima_adpcm_block(const fmt_t *fmt, const Uint8 *block,
+                                   Uint32 frames, Sint16 *dst)
 {
-    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
-    wav_t *w = (wav_t *) internal->decoder_private;
-    fmt_t *fmt = w->fmt;
-    ADPCMBLOCKHEADER *headers = fmt->fmt.adpcm.blockheaders;
-    SDL_RWops *rw = internal->rw;
-    int i;
-    int max = fmt->wChannels;
-    Uint8 nib = fmt->fmt.adpcm.nibble;
+    static const Sint32 IndexTable[] =
+    {
+        -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+    };
 
-    for (i = 0; i < max; i++)
+    static const Sint32 StepTable[IMA_ADPCM_MAX_INDEX + 1] =
     {
-        Sint16 iCoef1 = fmt->fmt.adpcm.aCoef[headers[i].bPredictor].iCoef1;
-        Sint16 iCoef2 = fmt->fmt.adpcm.aCoef[headers[i].bPredictor].iCoef2;
-        Sint32 lPredSamp = ((headers[i].iSamp1 * iCoef1) +
-                            (headers[i].iSamp2 * iCoef2)) / 
-                             FIXED_POINT_COEF_BASE;
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34,
+        37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+        157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494,
+        544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552,
+        1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428,
+        4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+        12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086,
+        29794, 32767
+    };
+
+    const Uint32 max = fmt->wChannels;
+    const Uint32 stride = 4 * max;  /* each channel gets 4 bytes in turn. */
+    Uint32 chan;
+
+    for (chan = 0; chan < max; chan++)
+    {
+        const Uint8 *codes = block + fmt->fmt.adpcm.header_size + (chan * 4);
+        Sint32 sample = adpcm_le16s(block + (chan * 4));
+        Sint32 index = block[(chan * 4) + 2];
+        Sint16 *out = dst + chan;
+        Uint32 i;
 
-        if (fmt->fmt.adpcm.nibble_state == 0)
-        {
-            BAIL_IF_MACRO(!read_uint8(rw, &nib), NULL, 0);
-            fmt->fmt.adpcm.nibble_state = 1;
-            do_adpcm_nibble(nib >> 4, &headers[i], lPredSamp);
-        } /* if */
-        else
+        *out = (Sint16) sample;  /* the header has the first frame. */
+        out += max;
+
+        for (i = 0; i < frames - 1; i++, out += max)
         {
-            fmt->fmt.adpcm.nibble_state = 0;
-            do_adpcm_nibble(nib & 0x0F, &headers[i], lPredSamp);
-        } /* else */
-    } /* for */
+            const Uint8 byte = codes[((i >> 3) * stride) + ((i & 7) >> 1)];
+            const Sint32 code = (i & 1) ? (byte >> 4) : (byte & 0x0F);
+            const Sint32 step = StepTable[index];
+            Sint32 diff = step >> 3;
 
-    fmt->fmt.adpcm.nibble = nib;
-    return 1;
-} /* decode_adpcm_sample_frame */
+            if (code & 1) diff += step >> 2;
+            if (code & 2) diff += step >> 1;
+            if (code & 4) diff += step;
+
+            sample = clamp_adpcm_sample((code & 8) ? (sample - diff) : (sample + diff));
+
+            index += IndexTable[code];
+            if (index < 0)
+                index = 0;
+            else if (index > IMA_ADPCM_MAX_INDEX)
+                index = IMA_ADPCM_MAX_INDEX;
+
+            *out = (Sint16) sample;
+        } /* for */
+    } /* for */
+} /* decode_ima_adpcm_block */
 
 
-static SDL_INLINE void put_adpcm_sample_frame1(void *_buf, fmt_t *fmt)
+static SDL_INLINE void decode_adpcm_block(const fmt_t *fmt, Uint32 frames,
+                                          Sint16 *dst)
 {
-    Uint16 *buf = (Uint16 *) _buf;
-    ADPCMBLOCKHEADER *headers = fmt->fmt.adpcm.blockheaders;
-    int i;
-    for (i = 0; i < fmt->wChannels; i++)
-        *(buf++) = headers[i].iSamp1;
-} /* put_adpcm_sample_frame1 */
+    if (fmt->wFormatTag == FMT_IMA_ADPCM)
+        decode_ima_adpcm_block(fmt, fmt->fmt.adpcm.block, frames, dst);
+    else
+        decode_ms_adpcm_block(fmt, fmt->fmt.adpcm.block, frames, dst);
+} /* decode_adpcm_block */
 
 
-static SDL_INLINE void put_adpcm_sample_frame2(void *_buf, fmt_t *fmt)
+/*
+ * Read the next block from disk, and check its headers, so decoding it
+ *  can't fail. Returns the number of sample frames in it, zero on EOF or
+ *  error (with the sample's flags set accordingly).
+ */
+static Uint32 read_adpcm_block(Sound_Sample *sample)
 {
-    Uint16 *buf = (Uint16 *) _buf;
-    ADPCMBLOCKHEADER *headers = fmt->fmt.adpcm.blockheaders;
-    int i;
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    wav_t *w = (wav_t *) internal->decoder_private;
+    fmt_t *fmt = w->fmt;
+    const Uint8 *block = fmt->fmt.adpcm.block;
+    Uint32 len = fmt->wBlockAlign;
+    Uint32 frames;
+    Uint32 i;
+
+    if (w->bytesLeft < (Sint32) len)
+        len = (w->bytesLeft > 0) ? (Uint32) w->bytesLeft : 0;
+
+    if (len > 0)
+    {
+        len = (Uint32) SDL_RWread(internal->rw, fmt->fmt.adpcm.block, 1, len);
+        w->bytesLeft -= len;
+    } /* if */
+
+    if (len < fmt->fmt.adpcm.header_size)  /* no more complete blocks. */
+    {
+        sample->flags |= SOUND_SAMPLEFLAG_EOF;
+        return 0;
+    } /* if */
+
+    frames = adpcm_block_frames(fmt, len);
+    if (frames < adpcm_min_block_frames(fmt))  /* decoders need the headers' frames. */
+    {
+        sample->flags |= SOUND_SAMPLEFLAG_ERROR;
+        BAIL_MACRO("WAV: Corrupt ADPCM block", 0);
+    } /* if */
+
     for (i = 0; i < fmt->wChannels; i++)
-        *(buf++) = headers[i].iSamp2;
-} /* put_adpcm_sample_frame2 */
+    {
+        const SDL_bool bogus = (fmt->wFormatTag == FMT_IMA_ADPCM) ?
+                                 (block[(i * 4) + 2] > IMA_ADPCM_MAX_INDEX) :
+                                 (block[i] >= fmt->fmt.adpcm.wNumCoef);
+        if (bogus)
+        {
+            sample->flags |= SOUND_SAMPLEFLAG_ERROR;
+            BAIL_MACRO("WAV: Corrupt ADPCM block header", 0);
+        } /* if */
+    } /* for */
+
+    return frames;
+} /* read_adpcm_block */
 
 
 /*
  * Sound_Decode() lands here for ADPCM-encoded WAVs...
  */
-static Uint32 read_sample_fmt_adpcm(Sound_Sample *sample)
+static Uint32 read_sample_fmt_adpcm(Sound_Sample *sample, void *buf,
+                                    Uint32 buflen)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     wav_t *w = (wav_t *) internal->decoder_private;
     fmt_t *fmt = w->fmt;
+    const Uint32 framesize = fmt->sample_frame_size;
     Uint32 bw = 0;
 
-    while (bw < internal->buffer_size)
+    while ((buflen - bw) >= framesize)
     {
-        /* write ongoing sample frame before reading more data... */
-        switch (fmt->fmt.adpcm.samples_left_in_block)
+        Uint32 avail = fmt->fmt.adpcm.block_frames - fmt->fmt.adpcm.block_pos;
+        Uint32 frames;
+
+        if (avail == 0)  /* need to read a new block... */
         {
-            case 0:  /* need to read a new block... */
-                if (!read_adpcm_block_headers(sample))
-                {
-                    if ((sample->flags & SOUND_SAMPLEFLAG_EOF) == 0)
-                        sample->flags |= SOUND_SAMPLEFLAG_ERROR;
-                    return bw;
-                } /* if */
-
-                /* only write first sample frame for now. */
-                put_adpcm_sample_frame2((Uint8 *) internal->buffer + bw, fmt);
-                fmt->fmt.adpcm.samples_left_in_block--;
-                bw += fmt->sample_frame_size;
-                break;
-
-            case 1:  /* output last sample frame of block... */
-                put_adpcm_sample_frame1((Uint8 *) internal->buffer + bw, fmt);
-                fmt->fmt.adpcm.samples_left_in_block--;
-                bw += fmt->sample_frame_size;
-                break;
-
-            default: /* output latest sample frame and read a new one... */
-                put_adpcm_sample_frame1((Uint8 *) internal->buffer + bw, fmt);
-                fmt->fmt.adpcm.samples_left_in_block--;
-                bw += fmt->sample_frame_size;
-
-                if (!decode_adpcm_sample_frame(sample))
-                {
-                    sample->flags |= SOUND_SAMPLEFLAG_ERROR;
-                    return bw;
-                } /* if */
-        } /* switch */
+            frames = read_adpcm_block(sample);
+            if (frames == 0)
+                return bw;  /* (EOF or ERROR flag is already set.) */
+
+            /* if the whole block fits, decode it straight into the output,
+               unless the caller's buffer isn't aligned for Sint16 there. */
+            if (((frames * framesize) <= (buflen - bw)) &&
+                ((((uintptr_t) ((Uint8 *) buf + bw)) & 1) == 0))
+            {
+                decode_adpcm_block(fmt, frames, (Sint16 *) ((Uint8 *) buf + bw));
+                fmt->fmt.adpcm.block_frames = fmt->fmt.adpcm.block_pos = 0;
+                bw += frames * framesize;
+                continue;
+            } /* if */
+
+            decode_adpcm_block(fmt, frames, fmt->fmt.adpcm.decoded);
+            fmt->fmt.adpcm.block_frames = avail = frames;
+            fmt->fmt.adpcm.block_pos = 0;
+        } /* if */
+
+        frames = (buflen - bw) / framesize;
+        if (frames > avail)
+            frames = avail;
+
+        SDL_memcpy((Uint8 *) buf + bw,
+                   fmt->fmt.adpcm.decoded + (fmt->fmt.adpcm.block_pos * fmt->wChannels),
+                   frames * framesize);
+        fmt->fmt.adpcm.block_pos += frames;
+        bw += frames * framesize;
     } /* while */
 
     return bw;
@@ -497,8 +589,11 @@ static void free_fmt_adpcm(fmt_t *fmt)
     if (fmt->fmt.adpcm.aCoef != NULL)
         SDL_free(fmt->fmt.adpcm.aCoef);
 
-    if (fmt->fmt.adpcm.blockheaders != NULL)
-        SDL_free(fmt->fmt.adpcm.blockheaders);
+    if (fmt->fmt.adpcm.block != NULL)
+        SDL_free(fmt->fmt.adpcm.block);
+
+    if (fmt->fmt.adpcm.decoded != NULL)
+        SDL_free(fmt->fmt.adpcm.decoded);
 } /* free_fmt_adpcm */
 
 
@@ -506,53 +601,54 @@ static int rewind_sample_fmt_adpcm(Sound_Sample *sample)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     wav_t *w = (wav_t *) internal->decoder_private;
-    w->fmt->fmt.adpcm.samples_left_in_block = 0;
+    w->fmt->fmt.adpcm.block_frames = w->fmt->fmt.adpcm.block_pos = 0;
     return 1;
 } /* rewind_sample_fmt_adpcm */
 
 
-static int seek_sample_fmt_adpcm(Sound_Sample *sample, Uint32 ms)
+static int seek_sample_frame_fmt_adpcm(Sound_Sample *sample, Uint64 frame)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     wav_t *w = (wav_t *) internal->decoder_private;
     fmt_t *fmt = w->fmt;
-    const Uint32 origsampsleft = fmt->fmt.adpcm.samples_left_in_block;
+    const Sint32 origbytesleft = w->bytesLeft;
     const Sint64 origpos = SDL_RWtell(internal->rw);
-    const Sint64 offset = __Sound_convertMsToBytePos(&sample->actual, ms);
-    const Sint64 bpb = (fmt->fmt.adpcm.wSamplesPerBlock * fmt->sample_frame_size);
-    Sint64 skipsize = (offset / bpb) * fmt->wBlockAlign;
+    const Uint32 origflags = sample->flags;
+    const Uint64 block = frame / fmt->fmt.adpcm.wSamplesPerBlock;
+    const Sint64 skipsize = (Sint64) (block * fmt->wBlockAlign);
     const Sint64 pos = skipsize + fmt->data_starting_offset;
-    Sint64 rc = SDL_RWseek(internal->rw, pos, RW_SEEK_SET);
+    const Uint32 framesinto = (Uint32) (frame % fmt->fmt.adpcm.wSamplesPerBlock);
+    Uint32 frames;
+    Sint64 rc;
+
+    BAIL_IF_MACRO(skipsize > (Sint64) fmt->total_bytes, ERR_INVALID_ARGUMENT, 0);
+    rc = SDL_RWseek(internal->rw, pos, RW_SEEK_SET);
     BAIL_IF_MACRO(rc != pos, ERR_IO_ERROR, 0);
+    w->bytesLeft = (Sint32) (fmt->total_bytes - (Uint32) skipsize);
 
-    /* The offset we need is in this block, so we need to decode to there. */
-    skipsize += (offset % bpb);
-    rc = (offset % bpb);  /* bytes into this block we need to decode */
-    if (!read_adpcm_block_headers(sample))
+    if (framesinto == 0)
     {
-        SDL_RWseek(internal->rw, origpos, RW_SEEK_SET);  /* try to make sane. */
-        return 0;
+        fmt->fmt.adpcm.block_frames = fmt->fmt.adpcm.block_pos = 0;
+        return 1;  /* success; next read starts the block. */
     } /* if */
 
-    /* first sample frame of block is a freebie. :) */
-    fmt->fmt.adpcm.samples_left_in_block--;
-    rc -= fmt->sample_frame_size;
-    while (rc > 0)
+    /* The frame we need is in this block, so decode it and skip to there. */
+    frames = read_adpcm_block(sample);
+    if (frames < framesinto)
     {
-        if (!decode_adpcm_sample_frame(sample))
-        {
-            SDL_RWseek(internal->rw, origpos, RW_SEEK_SET);
-            fmt->fmt.adpcm.samples_left_in_block = origsampsleft;
-            return 0;
-        } /* if */
-
-        fmt->fmt.adpcm.samples_left_in_block--;
-        rc -= fmt->sample_frame_size;
-    } /* while */
+        const int failed = (sample->flags & SOUND_SAMPLEFLAG_ERROR) != 0;
+        SDL_RWseek(internal->rw, origpos, RW_SEEK_SET);  /* try to make sane. */
+        w->bytesLeft = origbytesleft;
+        sample->flags = origflags;
+        BAIL_IF_MACRO(!failed, ERR_INVALID_ARGUMENT, 0);  /* past the end. */
+        return 0;  /* (read_adpcm_block() set the error.) */
+    } /* if */
 
-    w->bytesLeft = fmt->total_bytes - skipsize;
+    decode_adpcm_block(fmt, frames, fmt->fmt.adpcm.decoded);
+    fmt->fmt.adpcm.block_frames = frames;
+    fmt->fmt.adpcm.block_pos = framesinto;
     return 1;  /* success. */
-} /* seek_sample_fmt_adpcm */
+} /* seek_sample_frame_fmt_adpcm */
 
 
 /*
@@ -562,33 +658,55 @@ static int seek_sample_fmt_adpcm(Sound_Sample *sample, Uint32 ms)
  */
 static int read_fmt_adpcm(SDL_RWops *rw, fmt_t *fmt)
 {
+    Uint32 frames;
     size_t i;
 
     SDL_memset(&fmt->fmt.adpcm, '\0', sizeof (fmt->fmt.adpcm));
     fmt->free = free_fmt_adpcm;
     fmt->read_sample = read_sample_fmt_adpcm;
     fmt->rewind_sample = rewind_sample_fmt_adpcm;
-    fmt->seek_sample = seek_sample_fmt_adpcm;
+    fmt->seek_sample_frame = seek_sample_frame_fmt_adpcm;
 
+    BAIL_IF_MACRO(fmt->wChannels == 0, "WAV: Invalid channel count", 0);
+    BAIL_IF_MACRO(fmt->wBitsPerSample != 4, "WAV: Unsupported sample size.", 0);
     BAIL_IF_MACRO(!read_le16(rw, &fmt->fmt.adpcm.cbSize), NULL, 0);
     BAIL_IF_MACRO(!read_le16(rw, &fmt->fmt.adpcm.wSamplesPerBlock), NULL, 0);
-    BAIL_IF_MACRO(!read_le16(rw, &fmt->fmt.adpcm.wNumCoef), NULL, 0);
 
-    /* fmt->free() is always called, so these malloc()s will be cleaned up. */
+    if (fmt->wFormatTag == FMT_IMA_ADPCM)
+        fmt->fmt.adpcm.header_size = 4 * fmt->wChannels;
+    else
+    {
+        fmt->fmt.adpcm.header_size = 7 * fmt->wChannels;
 
-    i = sizeof (ADPCMCOEFSET) * fmt->fmt.adpcm.wNumCoef;
-    fmt->fmt.adpcm.aCoef = (ADPCMCOEFSET *) SDL_malloc(i);
-    BAIL_IF_MACRO(fmt->fmt.adpcm.aCoef == NULL, ERR_OUT_OF_MEMORY, 0);
+        BAIL_IF_MACRO(!read_le16(rw, &fmt->fmt.adpcm.wNumCoef), NULL, 0);
 
-    for (i = 0; i < fmt->fmt.adpcm.wNumCoef; i++)
-    {
-        BAIL_IF_MACRO(!read_le16s(rw, &fmt->fmt.adpcm.aCoef[i].iCoef1), NULL, 0);
-        BAIL_IF_MACRO(!read_le16s(rw, &fmt->fmt.adpcm.aCoef[i].iCoef2), NULL, 0);
-    } /* for */
+        /* fmt->free() is always called, so these malloc()s will be cleaned up. */
+
+        i = sizeof (ADPCMCOEFSET) * fmt->fmt.adpcm.wNumCoef;
+        fmt->fmt.adpcm.aCoef = (ADPCMCOEFSET *) SDL_malloc(i);
+        BAIL_IF_MACRO(fmt->fmt.adpcm.aCoef == NULL, ERR_OUT_OF_MEMORY, 0);
+
+        for (i = 0; i < fmt->fmt.adpcm.wNumCoef; i++)
+        {
+            BAIL_IF_MACRO(!read_le16s(rw, &fmt->fmt.adpcm.aCoef[i].iCoef1), NULL, 0);
+            BAIL_IF_MACRO(!read_le16s(rw, &fmt->fmt.adpcm.aCoef[i].iCoef2), NULL, 0);
+        } /* for */
+    } /* else */
+
+    BAIL_IF_MACRO(fmt->wBlockAlign < fmt->fmt.adpcm.header_size,
+                  "WAV: Invalid ADPCM block size", 0);
+
+    /* don't trust wSamplesPerBlock to fit in wBlockAlign. */
+    frames = adpcm_block_frames(fmt, fmt->wBlockAlign);
+    BAIL_IF_MACRO(frames < adpcm_min_block_frames(fmt), "WAV: Invalid ADPCM block size", 0);
+    fmt->fmt.adpcm.wSamplesPerBlock = (Uint16) frames;
 
-    i = sizeof (ADPCMBLOCKHEADER) * fmt->wChannels;
-    fmt->fmt.adpcm.blockheaders = (ADPCMBLOCKHEADER *) SDL_malloc(i);
-    BAIL_IF_MACRO(fmt->fmt.adpcm.blockheaders == NULL, ERR_OUT_OF_MEMORY, 0);
+    fmt->fmt.adpcm.block = (Uint8 *) SDL_malloc(fmt->wBlockAlign);
+    BAIL_IF_MACRO(fmt->fmt.adpcm.block == NULL, ERR_OUT_OF_MEMORY, 0);
+
+    i = sizeof (Sint16) * frames * fmt->wChannels;
+    fmt->fmt.adpcm.decoded = (Sint16 *) SDL_malloc(i);
+    BAIL_IF_MACRO(fmt->fmt.adpcm.decoded == NULL, ERR_OUT_OF_MEMORY, 0);
 
     return 1;
 } /* read_fmt_adpcm */
@@ -625,6 +743,10 @@ static int read_fmt(SDL_RWops *rw, fmt_t *fmt)
             SNDDBG(("WAV: Appears to be ADPCM compressed audio.\n"));
             return read_fmt_adpcm(rw, fmt);
 
+        case FMT_IMA_ADPCM:
+            SNDDBG(("WAV: Appears to be IMA ADPCM compressed audio.\n"));
+            return read_fmt_adpcm(rw, fmt);
+
         case FMT_IEEE_FLOAT:
             SNDDBG(("WAV: Appears to be IEEE float uncompressed audio.\n"));
             return read_fmt_normal(rw, fmt);  /* just normal PCM, otherwise. */
@@ -720,8 +842,11 @@ static int WAV_open_internal(Sound_Sample *sample, const char *ext, fmt_t *fmt)
                               *  1000 / fmt->dwAvgBytesPerSec;
 
     sample->flags = SOUND_SAMPLEFLAG_NONE;
-    if (fmt->seek_sample != NULL)
+    if (fmt->seek_sample_frame != NULL)
+    {
         sample->flags |= SOUND_SAMPLEFLAG_CANSEEK;
+        internal->fast_seek_frame = SDL_TRUE;  /* straight to the byte (or ADPCM block). */
+    } /* if */
 
     SNDDBG(("WAV: Accepting data stream.\n"));
     return 1; /* we'll handle this data. */
@@ -760,11 +885,18 @@ static void WAV_close(Sound_Sample *sample)
 } /* WAV_close */
 
 
-static Uint32 WAV_read(Sound_Sample *sample)
+static Uint32 WAV_read_into(Sound_Sample *sample, void *buf, Uint32 buflen)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     wav_t *w = (wav_t *) internal->decoder_private;
-    return w->fmt->read_sample(sample);
+    return w->fmt->read_sample(sample, buf, buflen);
+} /* WAV_read_into */
+
+
+static Uint32 WAV_read(Sound_Sample *sample)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    return WAV_read_into(sample, internal->buffer, internal->buffer_size);
 } /* WAV_read */
 
 
@@ -784,10 +916,19 @@ static int WAV_seek(Sound_Sample *sample, Uint32 ms)
 {
     Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
     wav_t *w = (wav_t *) internal->decoder_private;
-    return w->fmt->seek_sample(sample, ms);
+    return w->fmt->seek_sample_frame(sample, __Sound_convertMsToFrames(sample->actual.rate, ms));
 } /* WAV_seek */
 
 
+static int WAV_seek_frame(Sound_Sample *sample, Uint64 frame)
+{
+    Sound_SampleInternal *internal = (Sound_SampleInternal *) sample->opaque;
+    wav_t *w = (wav_t *) internal->decoder_private;
+    BAIL_IF_MACRO(w->fmt->seek_sample_frame == NULL, ERR_CANNOT_SEEK, 0);
+    return w->fmt->seek_sample_frame(sample, frame);
+} /* WAV_seek_frame */
+
+
 static const char *extensions_wav[] = { "WAV", NULL };
 const Sound_DecoderFunctions __Sound_DecoderFunctions_WAV =
 {
@@ -804,7 +945,9 @@ const Sound_DecoderFunctions __Sound_DecoderFunctions_WAV =
     WAV_close,      /*  close() method */
     WAV_read,       /*   read() method */
     WAV_rewind,     /* rewind() method */
-    WAV_seek        /*   seek() method */
+    WAV_seek,       /*   seek() method */
+    WAV_read_into,  /* read_into() method */
+    WAV_seek_frame  /* seek_frame() method */
 };
 
 #endif /* SOUND_SUPPORTS_WAV */
@@ -1,16 +1,37 @@
 #include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN 1
+#include <windows.h>
+#endif
 #include "SDL.h"
 #include "SDL_sound.h"
 #include "physfs.h"
 #include "physfs/extras/physfsrwops.h"
 #include "physfs/extras/ignorecase.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SDLAMP_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SDLAMP_HAVE_AVX2 1  // we build this one with a target attribute and only call it if the CPU says it's okay.
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define SDLAMP_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
 typedef void (*ClickFn)(void);
 
 typedef struct
 {
-    SDL_Texture *texture;  // YOU DO NOT OWN THIS POINTER, DON'T FREE IT.
-    SDL_Rect srcrect_unpressed;
+    SDL_bool has_bitmap;  // SDL_FALSE if the skin didn't supply the bitmap; we draw a placeholder instead.
+    SDL_Rect srcrect_unpressed;  // source rects are in skin atlas coordinates.
     SDL_Rect srcrect_pressed;
     SDL_Rect dstrect;
     ClickFn clickfn;
@@ -33,10 +54,10 @@ typedef enum
 
 typedef struct
 {
-    SDL_Texture *texture;  // YOU DO NOT OWN THIS POINTER, DON'T FREE IT.
+    SDL_bool has_bitmap;
     WinAmpSkinButton knob;
     int num_frames;
-    int frame_x_offset;
+    int frame_x_offset;  // in skin atlas coordinates, like the knob's source rects.
     int frame_y_offset;
     int frame_width;
     int frame_height;
@@ -51,13 +72,27 @@ typedef enum
     WASSLD_TOTAL
 } WinAmpSkinSliderId;
 
+typedef enum
+{
+    WASBMP_MAIN=0,
+    WASBMP_CBUTTONS,
+    WASBMP_VOLUME,
+    WASBMP_BALANCE,
+    WASBMP_TITLEBAR,
+    WASBMP_TOTAL
+} WinAmpSkinBitmapId;
+
+// Every bitmap in the skin gets packed into one texture, so drawing a frame
+//  never has to switch textures and can go to the renderer as a single batch.
+//  A small block of white pixels is packed in too, so solid fills can go
+//  through the same batch (tinted by vertex color) instead of a separate call.
 typedef struct
 {
-    SDL_Texture *tex_main;
-    SDL_Texture *tex_cbuttons;
-    SDL_Texture *tex_volume;
-    SDL_Texture *tex_balance;
-    SDL_Texture *tex_titlebar;
+    SDL_Texture *atlas;
+    int atlas_w;
+    int atlas_h;
+    SDL_Rect bitmaps[WASBMP_TOTAL];  // where each bitmap lives in the atlas. Zero-sized if the skin didn't have it.
+    SDL_Rect white;  // solid white pixels in the atlas.
     WinAmpSkinButton buttons[WASBTN_TOTAL];
     WinAmpSkinSlider sliders[WASSLD_TOTAL];
     WinAmpSkinButton winshade_buttons[WASBTN_TOTAL];
@@ -66,15 +101,185 @@ typedef struct
     SDL_bool winshade_mode;
 } WinAmpSkin;
 
+// A skin that's been pulled out of its .wsz and packed into an atlas, but not
+//  uploaded to the GPU yet. The skin thread makes these, since it's all file i/o
+//  and BMP decoding, and the UI thread only has to turn the atlas into a texture.
+//  The last few are kept around, keyed by a hash of the .wsz's contents, so
+//  switching back to a skin you used recently doesn't decode anything at all.
+typedef struct DecodedSkin
+{
+    Uint64 hash;
+    SDL_Surface *atlas;  // NULL if we couldn't even allocate that.
+    SDL_Rect bitmaps[WASBMP_TOTAL];
+    SDL_Rect white;
+    int pins;  // nonzero while someone is using this, so it can't be evicted. Protected by skin_lock.
+    struct DecodedSkin *next;  // most recently used first.
+} DecodedSkin;
+
+// The decoder thread runs ahead of the audio device, filling this ring with
+//  float frames in the device's format, so the audio callback never has to
+//  call into SDL_sound. There is exactly one producer (the decoder thread) and
+//  one consumer (the audio callback), so the positions are just free-running
+//  counters that each side publishes atomically; the difference between them
+//  is the number of frames available, as long as `capacity` is a power of two.
+typedef struct
+{
+    float *frames;  // interleaved, `capacity` frames of `channels` floats each.
+    Uint32 capacity;  // in sample frames, always a power of two.
+    Uint32 mask;  // capacity - 1
+    int channels;
+    Uint32 prefill;  // frames we want queued before we (re)start playback.
+    Uint32 refill;  // wake the decoder thread when we drop below this many.
+    SDL_atomic_t write_pos;  // only the decoder thread changes this.
+    SDL_atomic_t read_pos;  // only the audio callback changes this.
+    SDL_atomic_t skip_pos;  // audio callback should jump its read_pos to here...
+    SDL_atomic_t skip_serial;  // ...when this changes (flushes queued audio).
+    SDL_atomic_t producing;  // nonzero while the decoder thread has a sample that isn't at EOF.
+    SDL_atomic_t underruns;  // times the callback ran dry while something was playing.
+} AudioRing;
+
+typedef enum
+{
+    DECODERCMD_NONE=0,
+    DECODERCMD_OPEN,  // start playing `pending_sample` (the decoder picks that up whatever the latest command is).
+    DECODERCMD_STOP,
+    DECODERCMD_REWIND,
+    DECODERCMD_QUIT
+} DecoderCommand;
+
+// Everything the UI thread tells the audio callback and the decoder thread.
+//  The UI thread is the only writer, and it never takes a lock to do it: it
+//  bumps `version` to an odd number, changes fields, and bumps it back to even.
+//  Readers take a snapshot with read_playback_params(), which tries again if
+//  the version was odd or changed while it was reading. Commands and seeks
+//  have their own serial numbers, so a reader can tell a new request from one
+//  it already handled; if the UI sends two before the reader looks, the last
+//  one wins. Floats are stored as their bits, since SDL_atomic_t is an int.
+typedef struct
+{
+    SDL_atomic_t version;
+    SDL_atomic_t volume;
+    SDL_atomic_t balance;
+    SDL_atomic_t paused;
+    SDL_atomic_t seek_serial;
+    SDL_atomic_t seek_ms;
+    SDL_atomic_t command_serial;
+    SDL_atomic_t command;
+} PlaybackParams;
+
+typedef struct
+{
+    int version;
+    float volume;
+    float balance;
+    SDL_bool paused;
+    int seek_serial;
+    Uint32 seek_ms;
+    int command_serial;
+    DecoderCommand command;
+} PlaybackParamsSnapshot;
+
+// What the indexer learned about a track. This is also what goes in the on-disk index cache.
+typedef struct
+{
+    Uint64 size;  // size and modification time, so we notice if the file changed since it was cached.
+    Sint64 mtime;
+    Sint32 duration_ms;  // -1 if the decoder can't know without decoding the whole thing.
+    Uint32 rate;
+    Uint16 format;
+    Uint8 channels;
+    SDL_bool playable;  // SDL_FALSE if no decoder would take it.
+    char decoder[8];  // the decoder's first file extension, like "MP3".
+} TrackInfo;
+
+typedef enum
+{
+    TRACK_UNINDEXED=0,
+    TRACK_INDEXING,
+    TRACK_INDEXED
+} TrackState;
+
+typedef struct
+{
+    char *path;
+    TrackState state;
+    TrackInfo info;  // only valid if state == TRACK_INDEXED.
+} PlaylistEntry;
+
+// How long seeks take, per decoder, from asking for it to having audio again. Decoder thread only.
+typedef struct
+{
+    const char *decoder;  // the decoder's first file extension; static string.
+    Uint32 count;
+    double total_ms;
+    double max_ms;
+} SeekStats;
+
+// One slot in the index cache's hash table; open addressing, linear probing.
+typedef struct
+{
+    char *path;  // NULL if the slot is empty.
+    Uint32 hash;
+    TrackInfo info;
+} IndexCacheEntry;
+
 static WinAmpSkin skin;
 static SDL_AudioDeviceID audio_device = 0;
 static Sound_AudioInfo audio_device_spec;
-static Sound_Sample *current_sample = NULL;
-static Uint32 sample_available = 0;
-static Uint32 sample_position = 0;
+static AudioRing ring;
+static SDL_Thread *decoder_thread = NULL;
+static SDL_sem *decoder_sem = NULL;  // posted to wake the decoder thread up.
+static SDL_mutex *decoder_lock = NULL;  // protects the next_sample and playing_* fields, never touched by the audio callback.
+static PlaybackParams params;
+static Sound_Sample *pending_sample = NULL;  // UI thread swaps a new sample in here atomically for DECODERCMD_OPEN.
+static Sound_Sample *next_sample = NULL;  // preload thread hands an opened, pre-rolled sample to the decoder thread here.
+static Uint32 next_sample_prerolled = 0;  // bytes already decoded into next_sample->buffer.
+static int next_sample_index = -1;  // playlist entry that next_sample came from.
+static SDL_atomic_t playing_index;  // playlist entry the decoder thread is playing, -1 if none.
+static Uint32 playing_base_pos = 0;  // ring position where the frame at playing_base_ms was queued. Protected by decoder_lock.
+static Uint32 playing_base_ms = 0;
+static Sint32 playing_duration_ms = -1;  // -1 if nothing is playing or the decoder can't tell.
+static SeekStats seek_stats[16];
+static int num_seek_stats = 0;
+static SDL_Thread *preload_thread = NULL;
+static SDL_sem *preload_sem = NULL;  // posted to wake the preload thread up.
+static SDL_mutex *playlist_lock = NULL;  // protects the playlist_*, preload_* and index_* fields.
+static SDL_mutex *scan_lock = NULL;  // held while a directory is mounted for scanning; see scan_directory().
+static PlaylistEntry *playlist = NULL;
+static int playlist_len = 0;
+static int playlist_capacity = 0;
+static SDL_atomic_t playlist_serial;  // bumped when the playlist is cleared, so workers can drop stale results.
+static int playlist_queued = -1;  // last entry handed to the decoder, by the UI or the preload thread. -1 if nothing yet.
+static int preload_serial = 0;  // bumped when what comes next changes, so the preload thread can drop stale work.
+static SDL_bool preload_quit = SDL_FALSE;
+static SDL_Thread *index_threads[8];
+static int num_index_threads = 0;
+static SDL_sem *index_sem = NULL;  // posted once per job (a track to index, or a directory to scan).
+static char **index_dirs = NULL;  // dropped directories waiting to be scanned.
+static int num_index_dirs = 0;
+static int index_cursor = 0;  // every playlist entry before this is indexed or being indexed.
+static SDL_bool index_quit = SDL_FALSE;
+static IndexCacheEntry *index_cache = NULL;  // what we know about every track we've ever indexed, by path.
+static Uint32 index_cache_capacity = 0;  // always zero or a power of two.
+static Uint32 index_cache_count = 0;
+static SDL_bool index_cache_dirty = SDL_FALSE;  // needs to be written back to disk.
+static char *index_cache_path = NULL;
+static Uint32 decoder_error_event = 0;  // SDL_RegisterEvents() id for errors that the UI thread should report.
+static SDL_Thread *skin_thread = NULL;
+static SDL_sem *skin_sem = NULL;  // posted to wake the skin thread up.
+static SDL_mutex *skin_lock = NULL;  // protects the decoded skin cache, pending_skin_fname and skin_quit.
+static DecodedSkin *decoded_skins = NULL;  // cache of recently used skins.
+static char *pending_skin_fname = NULL;  // skin the UI wants next; only the latest request matters.
+static SDL_bool skin_quit = SDL_FALSE;
+static Uint32 skin_ready_event = 0;  // SDL_RegisterEvents() id; data1 is a pinned DecodedSkin for the UI thread to apply.
+static Uint32 playlist_event = 0;  // SDL_RegisterEvents() id; a directory scan added tracks to the playlist.
 static SDL_Window *window = NULL;
 static SDL_Renderer *renderer = NULL;
-
+static SDL_Texture *canvas = NULL;  // we draw here and keep it between frames, so we only have to repaint what changed.
+static SDL_Rect dirty_rects[8];  // parts of `canvas` that need repainting before the next present.
+static int num_dirty_rects = 0;
+static Uint64 frames_presented = 0;  // render counters, so we can see what being idle costs.
+static Uint64 regions_painted = 0;
 
 #if defined(__GNUC__) || defined(__clang__)
 static void panic_and_abort(const char *title, const char *text) __attribute__((noreturn));
@@ -93,6 +298,19 @@ static const char *physfs_errstr(void)
     return PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode());
 }
 
+// FNV-1a. We just need to notice when two .wsz files are the same skin, not resist anyone.
+static Uint64 hash_bytes(const void *buf, const size_t len)
+{
+    const Uint8 *ptr = (const Uint8 *) buf;
+    Uint64 hash = 0xCBF29CE484222325ULL;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        hash ^= (Uint64) ptr[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
 static SDL_RWops *openrw(const char *_fname)
 {
     char *fname = SDL_strdup(_fname);
@@ -107,314 +325,2207 @@ static SDL_RWops *openrw(const char *_fname)
     return retval;
 }
 
+static Uint32 get_hint_uint(const char *name, const Uint32 default_value)
+{
+    const char *hint = SDL_GetHint(name);
+    const int val = hint ? SDL_atoi(hint) : 0;
+    return (val > 0) ? (Uint32) val : default_value;
+}
+
+static SDL_bool init_audio_ring(AudioRing *r, const int channels, const Uint32 device_frames)
+{
+    // these can be tweaked from the environment (or SDL_SetHint) if the defaults glitch on your hardware.
+    const Uint32 requested = get_hint_uint("SDLAMP_RING_FRAMES", 32768);
+    Uint32 capacity = 1;
+    while ((capacity < requested) || (capacity < (device_frames * 2))) {
+        capacity <<= 1;  // round up to a power of two.
+    }
+
+    SDL_zerop(r);
+    r->frames = (float *) SDL_calloc(capacity, sizeof (float) * channels);
+    if (!r->frames) {
+        SDL_OutOfMemory();
+        return SDL_FALSE;
+    }
+
+    r->capacity = capacity;
+    r->mask = capacity - 1;
+    r->channels = channels;
+    r->prefill = SDL_min(get_hint_uint("SDLAMP_PREFILL_FRAMES", capacity / 4), capacity - device_frames);
+    r->refill = SDL_min(get_hint_uint("SDLAMP_REFILL_FRAMES", capacity / 2), capacity);
+    return SDL_TRUE;
+}
+
+static void free_audio_ring(AudioRing *r)
+{
+    SDL_free(r->frames);
+    SDL_zerop(r);
+}
+
+// Called from the decoder thread only. Copies up to `frames` frames into the ring, returns number of frames queued.
+static Uint32 write_audio_ring(AudioRing *r, const float *src, const Uint32 frames)
+{
+    const Uint32 wpos = (Uint32) SDL_AtomicGet(&r->write_pos);
+    const Uint32 rpos = (Uint32) SDL_AtomicGet(&r->read_pos);
+    const Uint32 avail = r->capacity - (wpos - rpos);
+    const Uint32 total = SDL_min(avail, frames);
+    const Uint32 offset = wpos & r->mask;
+    const Uint32 first = SDL_min(total, r->capacity - offset);
+    const size_t framesize = sizeof (float) * r->channels;
+
+    SDL_memcpy(r->frames + (offset * r->channels), src, first * framesize);
+    if (first < total) {  // wrapped around the end of the buffer.
+        SDL_memcpy(r->frames, src + (first * r->channels), (total - first) * framesize);
+    }
+
+    SDL_MemoryBarrierRelease();  // make sure the frames land before the callback can see the new position.
+    SDL_AtomicSet(&r->write_pos, (int) (wpos + total));
+    return total;
+}
+
+// Called from the decoder thread only. Points `*dst` at the largest contiguous run of free frames in the ring and
+//  returns its length, so the decoder can write there directly. Follow up with commit_audio_ring().
+static Uint32 peek_audio_ring(AudioRing *r, float **dst)
+{
+    const Uint32 wpos = (Uint32) SDL_AtomicGet(&r->write_pos);
+    const Uint32 rpos = (Uint32) SDL_AtomicGet(&r->read_pos);
+    const Uint32 avail = r->capacity - (wpos - rpos);
+    const Uint32 offset = wpos & r->mask;
+    *dst = r->frames + (offset * r->channels);
+    return SDL_min(avail, r->capacity - offset);
+}
+
+// Called from the decoder thread only. Publishes `frames` frames written through peek_audio_ring().
+static void commit_audio_ring(AudioRing *r, const Uint32 frames)
+{
+    const Uint32 wpos = (Uint32) SDL_AtomicGet(&r->write_pos);
+    SDL_MemoryBarrierRelease();  // make sure the frames land before the callback can see the new position.
+    SDL_AtomicSet(&r->write_pos, (int) (wpos + frames));
+}
+
+// Called from the decoder thread only. Tells the callback to throw away everything queued so far.
+static void flush_audio_ring(AudioRing *r)
+{
+    SDL_AtomicSet(&r->skip_pos, SDL_AtomicGet(&r->write_pos));
+    SDL_AtomicAdd(&r->skip_serial, 1);
+}
+
+// The audio callback copies everything it plays in here, downmixed to mono, for the
+//  visualizer. Like AudioRing, there's one writer and a free-running position, but the
+//  reader never consumes anything or tells the writer where it is: it just copies out
+//  the newest frames whenever it draws, and if the callback lapped it mid-copy, it
+//  throws that away and tries again next frame. So the callback never waits on it.
+//  The callback announces how far it's about to write before it touches the buffer,
+//  so the reader can tell it was lapped even if the callback is still mid-write.
+#define AUDIO_DEVICE_FRAMES 4096  // frames per audio callback.
+#define VIS_FFT_SIZE 512  // must be a power of two.
+#define VIS_TAP_FRAMES 8192  // must be a power of two, and at least VIS_FFT_SIZE + AUDIO_DEVICE_FRAMES.
+SDL_COMPILE_TIME_ASSERT(vis_tap_size, VIS_TAP_FRAMES >= (VIS_FFT_SIZE + AUDIO_DEVICE_FRAMES));
+
+static float vis_tap[VIS_TAP_FRAMES];
+static SDL_atomic_t vis_tap_pos;  // everything before this is safe to read.
+static SDL_atomic_t vis_tap_write_end;  // the callback might be writing anything before this.
+
+// Audio callback only.
+static void write_vis_tap(const float *samples, Uint32 frames)
+{
+    Uint32 pos = (Uint32) SDL_AtomicGet(&vis_tap_pos);
+    if (frames > VIS_TAP_FRAMES) {  // only the newest ones matter.
+        samples += (frames - VIS_TAP_FRAMES) * 2;
+        pos += frames - VIS_TAP_FRAMES;
+        frames = VIS_TAP_FRAMES;
+    }
+
+    SDL_AtomicSet(&vis_tap_write_end, (int) (pos + frames));
+    SDL_MemoryBarrierRelease();  // make sure the reader can see what we're about to clobber before we clobber it.
+
+    for (Uint32 i = 0; i < frames; i++) {
+        vis_tap[(pos + i) & (VIS_TAP_FRAMES - 1)] = (samples[0] + samples[1]) * 0.5f;
+        samples += 2;
+    }
+
+    SDL_MemoryBarrierRelease();  // make sure the samples land before the reader can see the new position.
+    SDL_AtomicSet(&vis_tap_pos, (int) (pos + frames));
+}
+
+// Render thread only. Copies out the newest `frames` frames. Returns SDL_FALSE if the callback overwrote them while we were copying.
+static SDL_bool read_vis_tap(float *dst, const Uint32 frames)
+{
+    const Uint32 end = (Uint32) SDL_AtomicGet(&vis_tap_pos);
+    const Uint32 start = end - frames;
+    SDL_MemoryBarrierAcquire();
+
+    for (Uint32 i = 0; i < frames; i++) {
+        dst[i] = vis_tap[(start + i) & (VIS_TAP_FRAMES - 1)];
+    }
+
+    SDL_MemoryBarrierAcquire();
+    const Uint32 write_end = (Uint32) SDL_AtomicGet(&vis_tap_write_end);
+    return ((write_end - start) <= VIS_TAP_FRAMES) ? SDL_TRUE : SDL_FALSE;
+}
+
+typedef union
+{
+    float f;
+    int i;
+} FloatBits;
+
+static SDL_INLINE void set_atomic_float(SDL_atomic_t *a, const float f)
+{
+    FloatBits bits;
+    bits.f = f;
+    SDL_AtomicSet(a, bits.i);
+}
+
+static SDL_INLINE float get_atomic_float(SDL_atomic_t *a)
+{
+    FloatBits bits;
+    bits.i = SDL_AtomicGet(a);
+    return bits.f;
+}
+
+// UI thread only! Wrap changes to `params` in these.
+static void begin_params_update(void)
+{
+    SDL_AtomicAdd(&params.version, 1);  // now odd: readers will wait or retry.
+}
+
+static void end_params_update(void)
+{
+    SDL_AtomicAdd(&params.version, 1);  // even again: the new values are ready.
+}
+
+// Safe from any thread. Returns SDL_FALSE if the UI thread was busy updating; keep the old snapshot then.
+static SDL_bool read_playback_params(PlaybackParamsSnapshot *snapshot)
+{
+    for (int tries = 0; tries < 4; tries++) {
+        const int version = SDL_AtomicGet(&params.version);
+        if (version & 1) {
+            continue;  // writer is in the middle of an update.
+        }
+
+        PlaybackParamsSnapshot tmp;
+        tmp.version = version;
+        tmp.volume = get_atomic_float(&params.volume);
+        tmp.balance = get_atomic_float(&params.balance);
+        tmp.paused = SDL_AtomicGet(&params.paused) ? SDL_TRUE : SDL_FALSE;
+        tmp.seek_serial = SDL_AtomicGet(&params.seek_serial);
+        tmp.seek_ms = (Uint32) SDL_AtomicGet(&params.seek_ms);
+        tmp.command_serial = SDL_AtomicGet(&params.command_serial);
+        tmp.command = (DecoderCommand) SDL_AtomicGet(&params.command);
+
+        if (SDL_AtomicGet(&params.version) == version) {  // nothing changed while we were reading? We're good.
+            SDL_memcpy(snapshot, &tmp, sizeof (tmp));
+            return SDL_TRUE;
+        }
+    }
+
+    return SDL_FALSE;
+}
+
+// The gain stage: scale interleaved stereo float frames by a per-channel gain that
+//  moves linearly from `start` to `end` across the buffer, so volume and balance
+//  changes don't step (and click). Frame `i` gets `start + (step * (i + 1))`, with
+//  `step` being zero when the gain isn't changing, so every variant does exactly
+//  one multiply per sample in that case. All the variants produce bit-identical
+//  output as long as the compiler doesn't contract the scalar math into fused
+//  multiply-adds, which is why CMakeLists.txt builds this with -ffp-contract=off.
+typedef void (*ApplyGainFn)(float *samples, const Uint32 frames, const float *start, const float *end);
+static ApplyGainFn apply_gain = NULL;
+
+static void apply_gain_scalar(float *samples, const Uint32 frames, const float *start, const float *end)
+{
+    const float stepl = (end[0] - start[0]) / ((float) frames);
+    const float stepr = (end[1] - start[1]) / ((float) frames);
+    for (Uint32 i = 0; i < frames; i++) {
+        const float idx = (float) (i + 1);
+        samples[0] *= start[0] + (stepl * idx);
+        samples[1] *= start[1] + (stepr * idx);
+        samples += 2;
+    }
+}
+
+#if SDLAMP_HAVE_SSE2
+static void apply_gain_sse2(float *samples, const Uint32 frames, const float *start, const float *end)
+{
+    const float stepl = (end[0] - start[0]) / ((float) frames);
+    const float stepr = (end[1] - start[1]) / ((float) frames);
+    const __m128 base = _mm_setr_ps(start[0], start[1], start[0], start[1]);
+    const __m128 step = _mm_setr_ps(stepl, stepr, stepl, stepr);
+    const __m128 two = _mm_set1_ps(2.0f);
+    __m128 idx = _mm_setr_ps(1.0f, 1.0f, 2.0f, 2.0f);  // two frames per vector.
+    Uint32 i;
+
+    for (i = 0; (i + 2) <= frames; i += 2) {
+        const __m128 gain = _mm_add_ps(base, _mm_mul_ps(step, idx));
+        _mm_storeu_ps(samples, _mm_mul_ps(_mm_loadu_ps(samples), gain));
+        idx = _mm_add_ps(idx, two);
+        samples += 4;
+    }
+
+    if (i < frames) {  // odd frame at the end.
+        const float lidx = (float) (i + 1);
+        samples[0] *= start[0] + (stepl * lidx);
+        samples[1] *= start[1] + (stepr * lidx);
+    }
+}
+#endif
+
+#if SDLAMP_HAVE_AVX2
+__attribute__((target("avx2")))
+static void apply_gain_avx2(float *samples, const Uint32 frames, const float *start, const float *end)
+{
+    const float stepl = (end[0] - start[0]) / ((float) frames);
+    const float stepr = (end[1] - start[1]) / ((float) frames);
+    const __m256 base = _mm256_setr_ps(start[0], start[1], start[0], start[1], start[0], start[1], start[0], start[1]);
+    const __m256 step = _mm256_setr_ps(stepl, stepr, stepl, stepr, stepl, stepr, stepl, stepr);
+    const __m256 four = _mm256_set1_ps(4.0f);
+    __m256 idx = _mm256_setr_ps(1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f, 4.0f, 4.0f);  // four frames per vector.
+    Uint32 i;
+
+    for (i = 0; (i + 4) <= frames; i += 4) {
+        const __m256 gain = _mm256_add_ps(base, _mm256_mul_ps(step, idx));  // not FMA: stay bit-identical to the other paths.
+        _mm256_storeu_ps(samples, _mm256_mul_ps(_mm256_loadu_ps(samples), gain));
+        idx = _mm256_add_ps(idx, four);
+        samples += 8;
+    }
+
+    for (; i < frames; i++) {  // leftover frames at the end.
+        const float lidx = (float) (i + 1);
+        samples[0] *= start[0] + (stepl * lidx);
+        samples[1] *= start[1] + (stepr * lidx);
+        samples += 2;
+    }
+}
+#endif
+
+#if SDLAMP_HAVE_NEON
+static void apply_gain_neon(float *samples, const Uint32 frames, const float *start, const float *end)
+{
+    const float stepl = (end[0] - start[0]) / ((float) frames);
+    const float stepr = (end[1] - start[1]) / ((float) frames);
+    const float basearray[4] = { start[0], start[1], start[0], start[1] };
+    const float steparray[4] = { stepl, stepr, stepl, stepr };
+    const float idxarray[4] = { 1.0f, 1.0f, 2.0f, 2.0f };
+    const float32x4_t base = vld1q_f32(basearray);
+    const float32x4_t step = vld1q_f32(steparray);
+    const float32x4_t two = vdupq_n_f32(2.0f);
+    float32x4_t idx = vld1q_f32(idxarray);  // two frames per vector.
+    Uint32 i;
+
+    for (i = 0; (i + 2) <= frames; i += 2) {
+        const float32x4_t gain = vaddq_f32(base, vmulq_f32(step, idx));
+        vst1q_f32(samples, vmulq_f32(vld1q_f32(samples), gain));
+        idx = vaddq_f32(idx, two);
+        samples += 4;
+    }
+
+    if (i < frames) {  // odd frame at the end.
+        const float lidx = (float) (i + 1);
+        samples[0] *= start[0] + (stepl * lidx);
+        samples[1] *= start[1] + (stepr * lidx);
+    }
+}
+#endif
+
+static ApplyGainFn choose_apply_gain(void)
+{
+    #if SDLAMP_HAVE_AVX2
+    if (SDL_HasAVX2()) { return apply_gain_avx2; }
+    #endif
+    #if SDLAMP_HAVE_SSE2
+    if (SDL_HasSSE2()) { return apply_gain_sse2; }
+    #endif
+    #if SDLAMP_HAVE_NEON
+    if (SDL_HasNEON()) { return apply_gain_neon; }
+    #endif
+    return apply_gain_scalar;
+}
+
+// Turn the volume and balance sliders into a gain for each channel. Left is first, right is second.
+static void calculate_gains(const float volume, const float balance, float *gains)
+{
+    gains[0] = (balance > 0.5f) ? (volume * (1.0f - balance)) : volume;
+    gains[1] = (balance < 0.5f) ? (volume * balance) : volume;
+}
+
+// When the ring gets flushed (seek, new track, stop...), the audio that was about to play
+//  fades out over this many frames, mixed over whatever comes next, which fades in. That
+//  way nothing jumps straight from one waveform to another, which would click.
+#define CROSSFADE_FRAMES 512
+
 static void SDLCALL feed_audio_device_callback(void *userdata, Uint8 *output_stream, int len)
 {
-    Sound_Sample *sample = (Sound_Sample *) SDL_AtomicGetPtr((void **) &current_sample);
+    static int skip_serial = 0;  // only the audio thread touches these.
+    static SDL_bool primed = SDL_FALSE;
+    static float gains[2] = { 0.0f, 0.0f };  // what we ended the last callback with; ramp from here.
+    static float fadeout[CROSSFADE_FRAMES * 2];  // already scaled down to silence; just add it in.
+    static Uint32 fadeout_len = 0;
+    static Uint32 fadeout_pos = 0;
+    static PlaybackParamsSnapshot snapshot = { 0, 1.0f, 0.5f, SDL_TRUE, 0, 0, 0, DECODERCMD_NONE };
+    AudioRing *r = &ring;
+    const int serial = SDL_AtomicGet(&r->skip_serial);
+    Uint32 rpos = (Uint32) SDL_AtomicGet(&r->read_pos);
+
+    if (serial != skip_serial) {  // decoder thread wants us to drop what's queued (new track, stop, rewind, seek...)
+        const Uint32 skip = (Uint32) SDL_AtomicGet(&r->skip_pos);
+        skip_serial = serial;
+        if (((Sint32) (skip - rpos)) > 0) {  // only ever move forward.
+            // the frames we're skipping are still intact: the decoder thread only writes past `skip`, and can't
+            //  lap us until we move read_pos. Grab the start of them to fade out, if we're audible at all.
+            SDL_assert(r->channels == 2);
+            fadeout_len = ((gains[0] != 0.0f) || (gains[1] != 0.0f)) ? SDL_min(skip - rpos, CROSSFADE_FRAMES) : 0;
+            fadeout_pos = 0;
+            if (fadeout_len > 0) {
+                const float silence[2] = { 0.0f, 0.0f };
+                const Uint32 offset = rpos & r->mask;
+                const Uint32 first = SDL_min(fadeout_len, r->capacity - offset);
+                SDL_memcpy(fadeout, r->frames + (offset * r->channels), first * sizeof (float) * r->channels);
+                if (first < fadeout_len) {  // wrapped around the end of the buffer.
+                    SDL_memcpy(fadeout + (first * r->channels), r->frames, (fadeout_len - first) * sizeof (float) * r->channels);
+                }
+                apply_gain(fadeout, fadeout_len, gains, silence);
+            }
+            gains[0] = gains[1] = 0.0f;  // and whatever comes next ramps up from silence.
+            rpos = skip;
+            SDL_AtomicSet(&r->read_pos, (int) rpos);
+        }
+        primed = SDL_FALSE;
+    }
+
+    const SDL_bool producing = SDL_AtomicGet(&r->producing) ? SDL_TRUE : SDL_FALSE;
+    const Uint32 wpos = (Uint32) SDL_AtomicGet(&r->write_pos);
+    SDL_MemoryBarrierAcquire();  // make sure we see the frames the decoder thread wrote before moving write_pos.
 
-    if (sample == NULL) {  // nothing playing, just write silence and bail.
+    const Uint32 available = wpos - rpos;
+    const Uint32 framesize = sizeof (float) * r->channels;
+    const Uint32 wanted = ((Uint32) len) / framesize;
+
+    read_playback_params(&snapshot);  // if this fails, the UI is mid-update; use last period's values.
+
+    // Pausing ramps down to silence over one period, and then we stop pulling from the ring until unpaused.
+    float target[2] = { 0.0f, 0.0f };
+    if (!snapshot.paused) {
+        calculate_gains(snapshot.volume, snapshot.balance, target);
+    } else if ((gains[0] == 0.0f) && (gains[1] == 0.0f)) {
         SDL_memset(output_stream, '\0', len);
+        fadeout_len = 0;  // paused is silent; don't let a fade-out leak through.
         return;
     }
 
-    const float volume = skin.sliders[WASSLD_VOLUME].value;
-    const float balance = skin.sliders[WASSLD_BALANCE].value;
+    // after a flush or an underrun, wait until we've got a healthy amount queued (or the track is done) before playing.
+    if (!primed && ((available >= r->prefill) || !producing)) {
+        primed = SDL_TRUE;
+    }
 
-    while (len > 0) {
-        if (sample_available == 0) {
-            const Uint32 br = Sound_Decode(sample);
-            if (br == 0) {
-                // !!! FIXME: rework stop_audio and use it here.
-                Sound_FreeSample(current_sample);
-                SDL_AtomicSetPtr((void **) &current_sample, NULL);
-                sample_available = 0;
-                sample_position = 0;
-                SDL_memset(output_stream, '\0', len);  // write silence and bail.
-                return;
-            }
+    const Uint32 total = primed ? SDL_min(available, wanted) : 0;
+    if (total > 0) {
+        const Uint32 offset = rpos & r->mask;
+        const Uint32 first = SDL_min(total, r->capacity - offset);
+        SDL_memcpy(output_stream, r->frames + (offset * r->channels), first * framesize);
+        if (first < total) {  // wrapped around the end of the buffer.
+            SDL_memcpy(output_stream + (first * framesize), r->frames, (total - first) * framesize);
+        }
+
+        SDL_assert(r->channels == 2);  // this should always be stereo data (at least for now).
+
+        // change the volume and balance of the audio we're playing, in one pass.
+        if ((gains[0] != 1.0f) || (gains[1] != 1.0f) || (target[0] != 1.0f) || (target[1] != 1.0f)) {
+            apply_gain((float *) output_stream, total, gains, target);
+        }
+        gains[0] = target[0];
+        gains[1] = target[1];
+
+        SDL_AtomicSet(&r->read_pos, (int) (rpos + total));
+    }
+
+    if (total < wanted) {
+        SDL_memset(output_stream + (total * framesize), '\0', (wanted - total) * framesize);  // write silence for the rest.
+        if (primed && producing) {  // the decoder thread didn't keep up!
+            SDL_AtomicAdd(&r->underruns, 1);
+            primed = SDL_FALSE;
+        }
+    }
+
+    // mix in whatever's left of the audio we skipped, fading out underneath what's fading in.
+    if (fadeout_pos < fadeout_len) {
+        const Uint32 frames = SDL_min(wanted, fadeout_len - fadeout_pos);
+        const float *src = fadeout + (fadeout_pos * 2);
+        float *dst = (float *) output_stream;
+        for (Uint32 i = 0; i < frames * 2; i++) {
+            dst[i] += src[i];
+        }
+        fadeout_pos += frames;
+    }
 
-            sample_available = br;
-            sample_position = 0;
+    write_vis_tap((const float *) output_stream, wanted);  // let the visualizer see what we actually played.
+
+    // getting low? Wake up the decoder thread. Otherwise it'll notice on its own soon enough.
+    if ((available - total) < r->refill) {
+        SDL_SemPost(decoder_sem);
+    }
+}
+
+static void report_decoder_error(const char *title)
+{
+    const char *err = Sound_GetError();
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = decoder_error_event;
+    event.user.data1 = (void *) title;  // static string, don't free.
+    event.user.data2 = SDL_strdup(err ? err : "Unknown error");  // UI thread frees this.
+    SDL_PushEvent(&event);
+}
+
+// Decoder thread only. Note where `sample` starts in the ring, so the UI can work out the playback position.
+static void set_playing_position(Sound_Sample *sample, const Uint32 ms)
+{
+    const Sint32 duration = sample ? Sound_GetDuration(sample) : -1;
+    SDL_LockMutex(decoder_lock);
+    playing_base_pos = (Uint32) SDL_AtomicGet(&ring.write_pos);
+    playing_base_ms = ms;
+    playing_duration_ms = duration;
+    SDL_UnlockMutex(decoder_lock);
+}
+
+// Decoder thread only.
+static void record_seek_latency(Sound_Sample *sample, const Uint64 started)
+{
+    const char *decoder = (sample->decoder && sample->decoder->extensions[0]) ? sample->decoder->extensions[0] : "???";
+    const double ms = ((double) (SDL_GetPerformanceCounter() - started) * 1000.0) / ((double) SDL_GetPerformanceFrequency());
+    SeekStats *stats = NULL;
+    int i;
+
+    for (i = 0; i < num_seek_stats; i++) {
+        if (seek_stats[i].decoder == decoder) {  // same decoder, same static string.
+            stats = &seek_stats[i];
+            break;
+        }
+    }
+
+    if (!stats) {
+        if (num_seek_stats == SDL_arraysize(seek_stats)) {
+            return;  // more decoders than we have room for? Just don't count it.
+        }
+        stats = &seek_stats[num_seek_stats++];
+        stats->decoder = decoder;
+    }
+
+    stats->count++;
+    stats->total_ms += ms;
+    stats->max_ms = SDL_max(stats->max_ms, ms);
+}
+
+static int SDLCALL decoder_thread_entry(void *userdata)
+{
+    Sound_Sample *sample = NULL;
+    Uint32 decoded_available = 0;  // in sample frames.
+    Uint32 decoded_position = 0;  // in sample frames.
+    SDL_bool stopped = SDL_TRUE;  // SDL_TRUE if the user stopped playback, vs. just running out of things to play.
+    PlaybackParamsSnapshot snapshot;
+    int command_serial = 0;
+    int seek_serial = 0;
+    Uint64 seek_started = 0;  // performance counter when the last seek was requested, zero once we have audio again.
+    AudioRing *r = &ring;
+    const Uint32 framesize = sizeof (float) * r->channels;
+
+    while (SDL_TRUE) {
+        while (!read_playback_params(&snapshot)) {
+            SDL_Delay(1);  // UI thread is mid-update, give it a moment.
+        }
+
+        DecoderCommand cmd = DECODERCMD_NONE;
+        if (snapshot.command_serial != command_serial) {
+            command_serial = snapshot.command_serial;
+            cmd = snapshot.command;
+        }
+
+        // Check for a new sample every time, not just on DECODERCMD_OPEN: the command slot only holds the
+        //  latest command, so an OPEN followed quickly by a REWIND would otherwise strand the new sample.
+        //  Anything still pending here was sent after any STOP we're seeing, since STOP clears it.
+        Sound_Sample *new_sample = NULL;
+        if (cmd != DECODERCMD_QUIT) {  // on QUIT, the UI thread frees whatever is still pending.
+            new_sample = (Sound_Sample *) SDL_AtomicSetPtr((void **) &pending_sample, NULL);
         }
 
-        float *samples = (float *) output_stream;
-        const Uint32 cpy = SDL_min(sample_available, (Uint32) len);
-        SDL_assert(cpy > 0);
-        SDL_memcpy(samples, ((const Uint8 *) sample->buffer) + sample_position, (size_t) cpy);
+        if ((cmd == DECODERCMD_STOP) || (cmd == DECODERCMD_QUIT) || new_sample) {
+            SDL_AtomicSet(&r->producing, 0);
+            flush_audio_ring(r);
+            if (sample) {
+                Sound_FreeSample(sample);
+            }
+            sample = new_sample;
+            decoded_available = decoded_position = 0;
+            seek_started = 0;
+            stopped = sample ? SDL_FALSE : SDL_TRUE;
+            set_playing_position(sample, 0);
+            if (sample) {
+                SDL_AtomicSet(&r->producing, 1);
+            }
+        } else if ((cmd == DECODERCMD_REWIND) && sample) {
+            flush_audio_ring(r);
+            decoded_available = decoded_position = 0;
+            if (!Sound_Rewind(sample)) {
+                report_decoder_error("Couldn't rewind audio file!");
+            }
+            set_playing_position(sample, 0);
+            SDL_AtomicSet(&r->producing, 1);
+        }
 
-        const int num_samples = (int) (cpy / sizeof (float));
-        SDL_assert((num_samples % 2) == 0);  // this should always be stereo data (at least for now).
+        if (cmd == DECODERCMD_QUIT) {
+            break;
+        }
 
-        // change the volume of the audio we're playing.
-        if (volume != 1.0f) {
-            for (int i = 0; i < num_samples; i++) {
-                samples[i] *= volume;
+        if (snapshot.seek_serial != seek_serial) {
+            seek_serial = snapshot.seek_serial;
+            if (sample) {
+                // this can take a while (some formats have to decode their way to the new spot), but it's
+                //  not holding anything the audio callback needs; it keeps playing, then crossfades over.
+                seek_started = SDL_GetPerformanceCounter();
+                flush_audio_ring(r);
+                decoded_available = decoded_position = 0;
+                if (!Sound_Seek(sample, snapshot.seek_ms)) {
+                    report_decoder_error("Couldn't seek in audio file!");
+                    seek_started = 0;
+                }
+                set_playing_position(sample, snapshot.seek_ms);
+                SDL_AtomicSet(&r->producing, 1);
             }
         }
 
-        // first sample is left, second is right.
-        // change the balance of the audio we're playing.
-        if (balance > 0.5f) {
-            for (int i = 0; i < num_samples; i += 2) {
-                samples[i] *= 1.0f - balance;
+        SDL_bool ring_full = SDL_FALSE;
+        while (!ring_full) {
+            if (!sample && !stopped) {  // ran out before the preload thread finished the next track? See if it's ready now.
+                SDL_LockMutex(decoder_lock);
+                sample = next_sample;
+                decoded_available = next_sample_prerolled / framesize;
+                decoded_position = 0;
+                if (sample) {
+                    SDL_AtomicSet(&playing_index, next_sample_index);
+                }
+                next_sample = NULL;
+                next_sample_prerolled = 0;
+                next_sample_index = -1;
+                SDL_UnlockMutex(decoder_lock);
+                if (sample) {
+                    set_playing_position(sample, 0);
+                    SDL_AtomicSet(&r->producing, 1);
+                    SDL_SemPost(preload_sem);
+                }
+            }
+
+            if (!sample) {
+                break;
+            }
+
+            if (decoded_available > 0) {  // still draining what the preload thread pre-rolled into sample->buffer.
+                const float *src = ((const float *) sample->buffer) + (decoded_position * r->channels);
+                const Uint32 queued = write_audio_ring(r, src, decoded_available);
+                decoded_available -= queued;
+                decoded_position += queued;
+                ring_full = (decoded_available > 0) ? SDL_TRUE : SDL_FALSE;
+                continue;
+            }
+
+            // decode straight into the free part of the ring, so there's no trip through sample->buffer.
+            float *dst = NULL;
+            const Uint32 space = peek_audio_ring(r, &dst);
+            if (space == 0) {
+                ring_full = SDL_TRUE;
+                continue;
+            }
+
+            const Uint32 br = (sample->flags & (SOUND_SAMPLEFLAG_EOF | SOUND_SAMPLEFLAG_ERROR)) ? 0 : Sound_DecodeInto(sample, dst, space * framesize);
+            const Uint32 frames = br / framesize;
+            if (frames > 0) {
+                commit_audio_ring(r, frames);
+                if (seek_started) {
+                    record_seek_latency(sample, seek_started);
+                    seek_started = 0;
+                }
+                continue;
+            }
+
+            if (sample->flags & SOUND_SAMPLEFLAG_EAGAIN) {
+                break;  // try again next time we wake up.
             }
-        } else if (balance < 0.5f) {
-            for (int i = 0; i < num_samples; i += 2) {
-                samples[i+1] *= balance;
+
+            // EOF or error. If the preload thread has the next track ready, its first frames go
+            //  right after this one's last in the ring, so there's no gap. It was opened and
+            //  pre-rolled elsewhere, so this is just a pointer swap at the top of the loop.
+            Sound_FreeSample(sample);
+            sample = NULL;
+            seek_started = 0;
+            SDL_LockMutex(decoder_lock);
+            const SDL_bool have_next = next_sample ? SDL_TRUE : SDL_FALSE;
+            SDL_UnlockMutex(decoder_lock);
+
+            if (!have_next) {  // nothing else ready; let the callback drain what's left without calling it an underrun.
+                SDL_AtomicSet(&r->producing, 0);
             }
         }
 
-        len -= cpy;
-        output_stream += cpy;
-        sample_available -= cpy;
-        sample_position += cpy;
+        // sleep until the callback wants more, or something comes in from the UI. The timeout is just a safety net.
+        SDL_SemWaitTimeout(decoder_sem, 100);
     }
-}
 
-static void stop_audio(void)
-{
-    Sound_Sample *sample = current_sample;
-    // make sure the audio callback can't touch `sample` while we're freeing it.
     if (sample) {
-        SDL_LockAudioDevice(audio_device);
-        SDL_AtomicSetPtr((void **) &current_sample, NULL);
-        SDL_UnlockAudioDevice(audio_device);
         Sound_FreeSample(sample);
     }
 
-    sample_available = 0;
-    sample_position = 0;
+    return 0;
 }
 
-static SDL_bool open_new_audio_file(const char *fname)
+// UI thread only.
+static void send_decoder_command(const DecoderCommand cmd, Sound_Sample *sample)
 {
-    stop_audio();
+    SDL_assert((cmd == DECODERCMD_OPEN) == (sample != NULL));
+    if (sample || (cmd == DECODERCMD_STOP)) {
+        // decoder thread never picked up the last one? It's still ours, get rid of it. A STOP cancels it, too.
+        Sound_Sample *unused = (Sound_Sample *) SDL_AtomicSetPtr((void **) &pending_sample, sample);
+        if (unused) {
+            Sound_FreeSample(unused);
+        }
+    }
+
+    begin_params_update();
+    SDL_AtomicSet(&params.command, (int) cmd);
+    SDL_AtomicAdd(&params.command_serial, 1);
+    end_params_update();
+
+    SDL_SemPost(decoder_sem);
+}
+
+// UI thread only. Push the current slider positions out to the audio callback.
+static void publish_mixer_params(void)
+{
+    begin_params_update();
+    set_atomic_float(&params.volume, skin.sliders[WASSLD_VOLUME].value);
+    set_atomic_float(&params.balance, skin.sliders[WASSLD_BALANCE].value);
+    end_params_update();
+}
 
-    SDL_assert(current_sample == NULL);  // stop_audio should have set this to NULL.
+// UI thread only. The decoder thread does the actual seeking, and the audio callback crossfades over to it.
+static void request_seek(const Uint32 ms)
+{
+    begin_params_update();
+    SDL_AtomicSet(&params.seek_ms, (int) ms);
+    SDL_AtomicAdd(&params.seek_serial, 1);
+    end_params_update();
+    SDL_SemPost(decoder_sem);
+}
+
+static void stop_audio(void)
+{
+    send_decoder_command(DECODERCMD_STOP, NULL);
+}
 
+static SDL_bool open_new_audio_file(const char *fname)
+{
     Sound_Sample *sample = Sound_NewSampleFromFile(fname, &audio_device_spec, 64 * 1024);
     if (!sample) {
         SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Couldn't load audio file!", Sound_GetError(), window);
         return SDL_FALSE;
     }
 
-    // make new `sample` available to the audio callback thread.
-    SDL_LockAudioDevice(audio_device);
-    SDL_AtomicSetPtr((void **) &current_sample, sample);
-    SDL_UnlockAudioDevice(audio_device);
+    // hand the new `sample` to the decoder thread; it'll drop whatever was playing before.
+    send_decoder_command(DECODERCMD_OPEN, sample);
 
     return SDL_TRUE;
 }
 
-static SDL_HitTestResult SDLCALL hit_test_callback(SDL_Window *win, const SDL_Point *area, void *data)
+static int SDLCALL preload_thread_entry(void *userdata)
 {
-    if (area->y < 14) {
-        int i;
-        /* !!! FIXME: code duplication */
-        WinAmpSkinButton *buttons = skin.winshade_mode ? skin.winshade_buttons : skin.buttons;
-        const int num_buttons = skin.winshade_mode ? SDL_arraysize(skin.winshade_buttons) : SDL_arraysize(skin.buttons);
-        WinAmpSkinSlider *sliders = skin.winshade_mode ? &skin.winshade_position_slider : skin.sliders;
-        const int num_sliders = skin.winshade_mode ? 1 : SDL_arraysize(skin.sliders);
+    while (SDL_TRUE) {
+        char *fname = NULL;
+        int index = -1;
+        int serial;
 
-        /* we are in the titlebar, make sure we're not in a button or a slider. */
-        for (i = 0; i < num_buttons; i++) {
-            if (SDL_PointInRect(area, &buttons[i].dstrect)) {
-                return SDL_HITTEST_NORMAL;  /* we're in a button, don't drag from the buttons! */
-            }
+        SDL_SemWait(preload_sem);
+
+        SDL_LockMutex(playlist_lock);
+        if (preload_quit) {
+            SDL_UnlockMutex(playlist_lock);
+            break;
         }
 
-        for (i = 0; i < num_sliders; i++) {
-            if (SDL_PointInRect(area, &sliders[i].dstrect)) {
-                return SDL_HITTEST_NORMAL;  /* we're in a slider, don't drag from the buttons! */
+        SDL_LockMutex(decoder_lock);
+        const SDL_bool slot_is_free = next_sample ? SDL_FALSE : SDL_TRUE;
+        SDL_UnlockMutex(decoder_lock);
+
+        // nothing is queued until the UI starts something; after that, we keep going down the playlist.
+        if (slot_is_free && (playlist_queued >= 0)) {
+            for (index = playlist_queued + 1; index < playlist_len; index++) {
+                const PlaylistEntry *entry = &playlist[index];
+                if ((entry->state != TRACK_INDEXED) || entry->info.playable) {
+                    break;  // skip anything the indexer already knows we can't play.
+                }
+            }
+
+            if (index < playlist_len) {
+                fname = SDL_strdup(playlist[index].path);
+                playlist_queued = index;
+            } else {
+                playlist_queued = playlist_len - 1;  // wait at the end; a directory scan might add more.
             }
         }
+        serial = preload_serial;
+        SDL_UnlockMutex(playlist_lock);
 
-        return SDL_HITTEST_DRAGGABLE;  /* everything else in the titlebar, treat as a window drag. */
+        if (!fname) {
+            continue;  // nothing to do right now.
+        }
+
+        // open, probe, and decode the first buffer now, so the decoder thread doesn't have to do any of it at the track change.
+        Sound_Sample *sample = Sound_NewSampleFromFile(fname, &audio_device_spec, 64 * 1024);
+        SDL_free(fname);
+
+        if (!sample) {
+            report_decoder_error("Couldn't load audio file!");
+            SDL_SemPost(preload_sem);  // try the next one in the playlist.
+            continue;
+        }
+
+        const Uint32 prerolled = Sound_Decode(sample);
+
+        SDL_LockMutex(playlist_lock);
+        const SDL_bool stale = (serial != preload_serial) ? SDL_TRUE : SDL_FALSE;
+        if (!stale) {
+            SDL_LockMutex(decoder_lock);
+            SDL_assert(next_sample == NULL);  // we only fill the slot when it's empty, and only we fill it.
+            next_sample = sample;
+            next_sample_prerolled = prerolled;
+            next_sample_index = index;
+            SDL_UnlockMutex(decoder_lock);
+        }
+        SDL_UnlockMutex(playlist_lock);
+
+        if (stale) {  // what comes next changed while we were working; throw this away.
+            Sound_FreeSample(sample);
+        } else {
+            SDL_SemPost(decoder_sem);  // in case the decoder thread already ran out.
+        }
+    }
+
+    return 0;
+}
+
+// Throw away whatever the preload thread prepared, and have it carry on from the entry after `queued`.
+static void requeue_playlist(const int queued)
+{
+    SDL_LockMutex(playlist_lock);
+    playlist_queued = queued;
+    preload_serial++;
+
+    SDL_LockMutex(decoder_lock);
+    Sound_Sample *sample = next_sample;
+    next_sample = NULL;
+    next_sample_prerolled = 0;
+    next_sample_index = -1;
+    SDL_UnlockMutex(decoder_lock);
+    SDL_UnlockMutex(playlist_lock);
+
+    if (sample) {
+        Sound_FreeSample(sample);
+    }
+
+    SDL_SemPost(preload_sem);
+}
+
+static void clear_playlist(void)
+{
+    int i;
+
+    SDL_LockMutex(playlist_lock);
+    for (i = 0; i < playlist_len; i++) {
+        SDL_free(playlist[i].path);
+    }
+    playlist_len = 0;
+    for (i = 0; i < num_index_dirs; i++) {
+        SDL_free(index_dirs[i]);
+    }
+    num_index_dirs = 0;
+    index_cursor = 0;
+    SDL_AtomicAdd(&playlist_serial, 1);
+    SDL_UnlockMutex(playlist_lock);
+
+    requeue_playlist(-1);
+}
+
+// Call with playlist_lock held. Takes ownership of `path`, even on failure.
+static SDL_bool append_playlist_entry_locked(char *path)
+{
+    if (playlist_len == playlist_capacity) {
+        const int newcap = playlist_capacity ? (playlist_capacity * 2) : 256;
+        void *ptr = SDL_realloc(playlist, sizeof (PlaylistEntry) * newcap);
+        if (!ptr) {
+            SDL_free(path);
+            return SDL_FALSE;  // out of memory; just drop it.
+        }
+        playlist = (PlaylistEntry *) ptr;
+        playlist_capacity = newcap;
+    }
+
+    PlaylistEntry *entry = &playlist[playlist_len++];
+    SDL_zerop(entry);
+    entry->path = path;
+    entry->state = TRACK_UNINDEXED;
+    return SDL_TRUE;
+}
+
+#ifdef _WIN32
+// Our paths are UTF-8, but the narrow Win32 APIs want the system codepage. Caller must SDL_free() the result.
+static WCHAR *utf8_to_wide(const char *str)
+{
+    return (WCHAR *) SDL_iconv_string("UTF-16LE", "UTF-8", str, SDL_strlen(str) + 1);
+}
+#endif
+
+static SDL_bool stat_file(const char *fname, Uint64 *size, Sint64 *mtime, SDL_bool *is_dir)
+{
+#ifdef _WIN32
+    struct _stat64 statbuf;
+    WCHAR *wfname = utf8_to_wide(fname);
+    const int rc = wfname ? _wstat64(wfname, &statbuf) : -1;
+    SDL_free(wfname);
+    if (rc == -1) {
+        return SDL_FALSE;
+    }
+#else
+    struct stat statbuf;
+    if (stat(fname, &statbuf) == -1) {
+        return SDL_FALSE;
+    }
+#endif
+    *size = (Uint64) statbuf.st_size;
+    *mtime = (Sint64) statbuf.st_mtime;
+    *is_dir = ((statbuf.st_mode & S_IFMT) == S_IFDIR) ? SDL_TRUE : SDL_FALSE;
+    return SDL_TRUE;
+}
+
+// Add a file to the end of the playlist, or a directory to be scanned for files. Returns
+//  the new entry's index, or -1 for directories (their tracks show up later) and failures.
+static int add_to_playlist(const char *path)
+{
+    Uint64 size = 0;
+    Sint64 mtime = 0;
+    SDL_bool is_dir = SDL_FALSE;
+    int retval = -1;
+
+    char *dup = SDL_strdup(path);
+    if (!dup) {
+        return -1;  // out of memory; just drop it.
+    }
+
+    stat_file(path, &size, &mtime, &is_dir);  // if this fails, it's not a directory; the indexer will decide if it's playable.
+
+    SDL_LockMutex(playlist_lock);
+    if (is_dir) {
+        void *ptr = SDL_realloc(index_dirs, sizeof (char *) * (num_index_dirs + 1));
+        if (ptr) {
+            index_dirs = (char **) ptr;
+            index_dirs[num_index_dirs++] = dup;
+        } else {
+            SDL_free(dup);
+        }
+    } else if (append_playlist_entry_locked(dup)) {
+        retval = playlist_len - 1;
+    }
+    SDL_UnlockMutex(playlist_lock);
+
+    SDL_SemPost(index_sem);
+    SDL_SemPost(preload_sem);  // in case we were waiting at the end of the playlist.
+    return retval;
+}
+
+// Start playing a playlist entry right now. UI thread only.
+static SDL_bool play_playlist_entry(const int index)
+{
+    SDL_LockMutex(playlist_lock);
+    char *fname = ((index >= 0) && (index < playlist_len)) ? SDL_strdup(playlist[index].path) : NULL;
+    SDL_UnlockMutex(playlist_lock);
+
+    if (!fname) {
+        return SDL_FALSE;
+    }
+
+    requeue_playlist(index);  // the preload thread should prepare whatever follows this one.
+    const SDL_bool retval = open_new_audio_file(fname);
+    SDL_free(fname);
+    if (retval) {
+        SDL_AtomicSet(&playing_index, index);
+    }
+    return retval;
+}
+
+// The index cache is a hash table of everything we've ever indexed, keyed by path. Call these with playlist_lock held.
+static IndexCacheEntry *find_index_cache_slot_locked(const char *path, const Uint32 hash)
+{
+    const Uint32 mask = index_cache_capacity - 1;
+    Uint32 i;
+
+    SDL_assert(index_cache_capacity > 0);
+    for (i = hash & mask; index_cache[i].path != NULL; i = (i + 1) & mask) {
+        if ((index_cache[i].hash == hash) && (SDL_strcmp(index_cache[i].path, path) == 0)) {
+            break;
+        }
+    }
+    return &index_cache[i];  // either the match, or the empty slot where it would go.
+}
+
+// Takes ownership of `path`, even on failure.
+static void store_index_cache_locked(char *path, const TrackInfo *info)
+{
+    const Uint32 hash = (Uint32) hash_bytes(path, SDL_strlen(path));
+
+    // keep it at most half full, so probes stay short.
+    if ((index_cache_count + 1) * 2 > index_cache_capacity) {
+        const Uint32 newcap = index_cache_capacity ? (index_cache_capacity * 2) : 1024;
+        IndexCacheEntry *newtable = (IndexCacheEntry *) SDL_calloc(newcap, sizeof (IndexCacheEntry));
+        if (!newtable) {
+            SDL_free(path);
+            return;
+        }
+        IndexCacheEntry *oldtable = index_cache;
+        const Uint32 oldcap = index_cache_capacity;
+        Uint32 i;
+        index_cache = newtable;
+        index_cache_capacity = newcap;
+        for (i = 0; i < oldcap; i++) {
+            if (oldtable[i].path) {
+                *find_index_cache_slot_locked(oldtable[i].path, oldtable[i].hash) = oldtable[i];
+            }
+        }
+        SDL_free(oldtable);
+    }
+
+    IndexCacheEntry *slot = find_index_cache_slot_locked(path, hash);
+    if (slot->path) {
+        SDL_free(path);  // replacing an existing entry, keep its copy of the path.
+    } else {
+        slot->path = path;
+        slot->hash = hash;
+        index_cache_count++;
+    }
+    SDL_memcpy(&slot->info, info, sizeof (TrackInfo));
+}
+
+static SDL_bool lookup_index_cache(const char *path, const Uint64 size, const Sint64 mtime, TrackInfo *info)
+{
+    SDL_bool retval = SDL_FALSE;
+    SDL_LockMutex(playlist_lock);
+    if (index_cache_count > 0) {
+        const IndexCacheEntry *slot = find_index_cache_slot_locked(path, (Uint32) hash_bytes(path, SDL_strlen(path)));
+        if (slot->path && (slot->info.size == size) && (slot->info.mtime == mtime)) {
+            SDL_memcpy(info, &slot->info, sizeof (TrackInfo));
+            retval = SDL_TRUE;
+        }
+    }
+    SDL_UnlockMutex(playlist_lock);
+    return retval;
+}
+
+// The on-disk cache is just the hash table's contents, packed:
+//  "SDLAMPIX", Uint32 version, Uint32 count, then for each track:
+//  Uint16 pathlen, path, Uint64 size, Sint64 mtime, Sint32 duration_ms,
+//  Uint32 rate, Uint16 format, Uint8 channels, Uint8 playable, Uint8 decoderlen, decoder.
+//  Everything is littleendian. It's all read in one gulp at startup.
+#define INDEX_CACHE_MAGIC "SDLAMPIX"
+#define INDEX_CACHE_VERSION 1
+
+typedef struct
+{
+    const Uint8 *ptr;
+    size_t avail;
+} CacheReader;
+
+static SDL_bool read_cache_bytes(CacheReader *reader, void *dst, const size_t len)
+{
+    if (reader->avail < len) {
+        return SDL_FALSE;
+    }
+    SDL_memcpy(dst, reader->ptr, len);
+    reader->ptr += len;
+    reader->avail -= len;
+    return SDL_TRUE;
+}
+
+#define READ_CACHE_INT(reader, type, swap, dst) { type val; if (!read_cache_bytes(reader, &val, sizeof (val))) { break; } dst = (type) swap(val); }
+
+static void load_index_cache(void)
+{
+    char *prefpath = SDL_GetPrefPath("icculus.org", "sdlamp");
+    if (!prefpath) {
+        return;  // we just won't have a cache.
+    }
+
+    const size_t pathlen = SDL_strlen(prefpath) + 16;
+    index_cache_path = (char *) SDL_malloc(pathlen);
+    if (index_cache_path) {
+        SDL_snprintf(index_cache_path, pathlen, "%sindex.cache", prefpath);
+    }
+    SDL_free(prefpath);
+
+    size_t len = 0;
+    void *buf = index_cache_path ? SDL_LoadFile(index_cache_path, &len) : NULL;
+    if (!buf) {
+        return;  // first run, or it went away. We'll write a new one.
+    }
+
+    CacheReader reader = { (const Uint8 *) buf, len };
+    char magic[8];
+    Uint32 version = 0, count = 0, i;
+    if (read_cache_bytes(&reader, magic, sizeof (magic)) && (SDL_memcmp(magic, INDEX_CACHE_MAGIC, sizeof (magic)) == 0) &&
+        read_cache_bytes(&reader, &version, sizeof (version)) && (SDL_SwapLE32(version) == INDEX_CACHE_VERSION) &&
+        read_cache_bytes(&reader, &count, sizeof (count))) {
+        count = SDL_SwapLE32(count);
+        SDL_LockMutex(playlist_lock);
+        for (i = 0; i < count; i++) {
+            TrackInfo info;
+            Uint16 pathlen16 = 0;
+            Uint8 playable = 0, decoderlen = 0;
+            SDL_zero(info);
+            READ_CACHE_INT(&reader, Uint16, SDL_SwapLE16, pathlen16);
+            char *path = (char *) SDL_malloc(pathlen16 + 1);
+            if (!path || !read_cache_bytes(&reader, path, pathlen16)) {
+                SDL_free(path);
+                break;
+            }
+            path[pathlen16] = '\0';
+            SDL_bool okay = SDL_FALSE;
+            do {
+                READ_CACHE_INT(&reader, Uint64, SDL_SwapLE64, info.size);
+                READ_CACHE_INT(&reader, Sint64, SDL_SwapLE64, info.mtime);
+                READ_CACHE_INT(&reader, Sint32, SDL_SwapLE32, info.duration_ms);
+                READ_CACHE_INT(&reader, Uint32, SDL_SwapLE32, info.rate);
+                READ_CACHE_INT(&reader, Uint16, SDL_SwapLE16, info.format);
+                READ_CACHE_INT(&reader, Uint8, , info.channels);
+                READ_CACHE_INT(&reader, Uint8, , playable);
+                READ_CACHE_INT(&reader, Uint8, , decoderlen);
+                if ((decoderlen >= sizeof (info.decoder)) || !read_cache_bytes(&reader, info.decoder, decoderlen)) {
+                    break;
+                }
+                info.playable = playable ? SDL_TRUE : SDL_FALSE;
+                okay = SDL_TRUE;
+            } while (SDL_FALSE);
+
+            if (!okay) {  // truncated or corrupt; keep what we got so far.
+                SDL_free(path);
+                break;
+            }
+            store_index_cache_locked(path, &info);
+        }
+        SDL_UnlockMutex(playlist_lock);
+    }
+
+    SDL_free(buf);
+}
+
+// Atomically replace `dst` with `src`. Both are UTF-8 paths.
+static SDL_bool replace_file(const char *src, const char *dst)
+{
+#ifdef _WIN32
+    // rename() won't replace an existing file here, and remove()ing it first would leave a window with no cache at all.
+    WCHAR *wsrc = utf8_to_wide(src);
+    WCHAR *wdst = utf8_to_wide(dst);
+    const SDL_bool retval = (wsrc && wdst && MoveFileExW(wsrc, wdst, MOVEFILE_REPLACE_EXISTING)) ? SDL_TRUE : SDL_FALSE;
+    SDL_free(wsrc);
+    SDL_free(wdst);
+    return retval;
+#else
+    return (rename(src, dst) == 0) ? SDL_TRUE : SDL_FALSE;
+#endif
+}
+
+static void delete_file(const char *fname)
+{
+#ifdef _WIN32
+    WCHAR *wfname = utf8_to_wide(fname);
+    if (wfname) {
+        DeleteFileW(wfname);
+        SDL_free(wfname);
+    }
+#else
+    remove(fname);
+#endif
+}
+
+static void save_index_cache(void)
+{
+    if (!index_cache_dirty || !index_cache_path) {
+        return;
+    }
+
+    const size_t tmplen = SDL_strlen(index_cache_path) + 8;
+    char *tmppath = (char *) SDL_malloc(tmplen);
+    if (!tmppath) {
+        return;
+    }
+    SDL_snprintf(tmppath, tmplen, "%s.tmp", index_cache_path);
+
+    // write it somewhere else and rename it over the old one, so a crash halfway through doesn't lose the whole thing.
+    SDL_RWops *rw = SDL_RWFromFile(tmppath, "wb");
+    if (rw) {
+        SDL_bool okay = (SDL_RWwrite(rw, INDEX_CACHE_MAGIC, 8, 1) == 1) ? SDL_TRUE : SDL_FALSE;
+        okay = okay && SDL_WriteLE32(rw, INDEX_CACHE_VERSION);
+        okay = okay && SDL_WriteLE32(rw, index_cache_count);
+        for (Uint32 i = 0; okay && (i < index_cache_capacity); i++) {
+            const IndexCacheEntry *slot = &index_cache[i];
+            if (slot->path) {
+                const size_t pathlen = SDL_min(SDL_strlen(slot->path), 0xFFFF);
+                const size_t decoderlen = SDL_strlen(slot->info.decoder);
+                okay = okay && SDL_WriteLE16(rw, (Uint16) pathlen);
+                okay = okay && (SDL_RWwrite(rw, slot->path, pathlen, 1) == 1);
+                okay = okay && SDL_WriteLE64(rw, slot->info.size);
+                okay = okay && SDL_WriteLE64(rw, (Uint64) slot->info.mtime);
+                okay = okay && SDL_WriteLE32(rw, (Uint32) slot->info.duration_ms);
+                okay = okay && SDL_WriteLE32(rw, slot->info.rate);
+                okay = okay && SDL_WriteLE16(rw, slot->info.format);
+                okay = okay && SDL_WriteU8(rw, slot->info.channels);
+                okay = okay && SDL_WriteU8(rw, slot->info.playable ? 1 : 0);
+                okay = okay && SDL_WriteU8(rw, (Uint8) decoderlen);
+                okay = okay && ((decoderlen == 0) || (SDL_RWwrite(rw, slot->info.decoder, decoderlen, 1) == 1));
+            }
+        }
+        okay = (SDL_RWclose(rw) == 0) && okay;
+
+        if (okay) {
+            okay = replace_file(tmppath, index_cache_path);
+        }
+        if (!okay) {
+            delete_file(tmppath);
+        }
+    }
+
+    SDL_free(tmppath);
+}
+
+static SDL_bool is_audio_filename(const char *fname)
+{
+    const char *ext = SDL_strrchr(fname, '.');
+    const Sound_DecoderInfo **info;
+
+    if (!ext) {
+        return SDL_FALSE;
+    }
+
+    ext++;
+    for (info = Sound_AvailableDecoders(); *info != NULL; info++) {
+        const char **decext;
+        for (decext = (*info)->extensions; *decext != NULL; decext++) {
+            if (SDL_strcasecmp(ext, *decext) == 0) {
+                return SDL_TRUE;
+            }
+        }
+    }
+    return SDL_FALSE;
+}
+
+// !!! FIXME: this doesn't handle the path being too long, but neither does the rest of the program.
+typedef struct
+{
+    char **paths;
+    int len;
+    int capacity;
+} PathList;
+
+static void scan_physfs_dir(const char *physdir, const char *nativedir, PathList *list)
+{
+    char **files = PHYSFS_enumerateFiles(physdir);
+    char **i;
+
+    if (!files) {
+        return;
+    }
+
+    // PhysFS hands these back sorted, so a directory comes out in a sensible order.
+    for (i = files; *i != NULL; i++) {
+        const size_t physlen = SDL_strlen(physdir) + SDL_strlen(*i) + 2;
+        const size_t nativelen = SDL_strlen(nativedir) + SDL_strlen(PHYSFS_getDirSeparator()) + SDL_strlen(*i) + 1;
+        char *physpath = (char *) SDL_malloc(physlen);
+        char *nativepath = (char *) SDL_malloc(nativelen);
+        PHYSFS_Stat statbuf;
+
+        if (physpath && nativepath) {
+            SDL_snprintf(physpath, physlen, "%s/%s", physdir, *i);
+            SDL_snprintf(nativepath, nativelen, "%s%s%s", nativedir, PHYSFS_getDirSeparator(), *i);
+            if (!PHYSFS_stat(physpath, &statbuf)) {
+                // just skip it.
+            } else if (statbuf.filetype == PHYSFS_FILETYPE_DIRECTORY) {
+                scan_physfs_dir(physpath, nativepath, list);  // PhysFS doesn't follow symlinks by default, so this can't loop forever.
+            } else if ((statbuf.filetype == PHYSFS_FILETYPE_REGULAR) && is_audio_filename(*i)) {
+                if (list->len == list->capacity) {
+                    const int newcap = list->capacity ? (list->capacity * 2) : 64;
+                    void *ptr = SDL_realloc(list->paths, sizeof (char *) * newcap);
+                    if (ptr) {
+                        list->paths = (char **) ptr;
+                        list->capacity = newcap;
+                    }
+                }
+                if (list->len < list->capacity) {
+                    list->paths[list->len++] = nativepath;
+                    nativepath = NULL;  // the list owns it now.
+                }
+            }
+        }
+
+        SDL_free(physpath);
+        SDL_free(nativepath);
+    }
+
+    PHYSFS_freeList(files);
+}
+
+// Find every audio file under `dir`, and add them all to the end of the playlist.
+static void scan_directory(const char *dir, const int serial)
+{
+    static SDL_atomic_t mount_counter;
+    char mountpoint[32];
+    PathList list;
+    int i;
+
+    // mount it somewhere off to the side, so it can't get mixed up with a skin being loaded at the same time.
+    //  PhysFS won't mount the same directory twice, and unmounts by directory, so if the same one got
+    //  queued twice, two index threads could step on each other here. Only scan one at a time.
+    SDL_snprintf(mountpoint, sizeof (mountpoint), "/scan%d", SDL_AtomicAdd(&mount_counter, 1));
+    SDL_LockMutex(scan_lock);
+    if (!PHYSFS_mount(dir, mountpoint, 1)) {
+        SDL_UnlockMutex(scan_lock);
+        return;
+    }
+
+    SDL_zero(list);
+    scan_physfs_dir(mountpoint, dir, &list);
+    PHYSFS_unmount(dir);
+    SDL_UnlockMutex(scan_lock);
+
+    SDL_LockMutex(playlist_lock);
+    for (i = 0; i < list.len; i++) {
+        if (serial == SDL_AtomicGet(&playlist_serial)) {
+            append_playlist_entry_locked(list.paths[i]);
+        } else {
+            SDL_free(list.paths[i]);  // the playlist got cleared while we were working.
+        }
+    }
+    SDL_UnlockMutex(playlist_lock);
+    SDL_free(list.paths);
+
+    if ((list.len > 0) && (serial == SDL_AtomicGet(&playlist_serial))) {
+        SDL_Event event;
+        for (i = 0; i < list.len; i++) {
+            SDL_SemPost(index_sem);
+        }
+        SDL_SemPost(preload_sem);  // in case we were waiting at the end of the playlist.
+        SDL_zero(event);
+        event.type = playlist_event;
+        SDL_PushEvent(&event);
+    }
+}
+
+static void index_track(const char *fname, TrackInfo *info)
+{
+    SDL_bool is_dir = SDL_FALSE;
+
+    SDL_zerop(info);
+    info->duration_ms = -1;
+
+    if (!stat_file(fname, &info->size, &info->mtime, &is_dir) || is_dir) {
+        return;  // not playable, and not worth caching.
+    } else if (lookup_index_cache(fname, info->size, info->mtime, info)) {
+        return;  // we've seen this one before, and it hasn't changed.
+    }
+
+    // this opens a decoder, but doesn't decode anything, and doesn't need to convert to the device format.
+    Sound_Sample *sample = Sound_NewSampleFromFile(fname, NULL, 4096);
+    if (sample) {
+        info->playable = SDL_TRUE;
+        info->duration_ms = Sound_GetDuration(sample);
+        info->rate = sample->actual.rate;
+        info->format = sample->actual.format;
+        info->channels = sample->actual.channels;
+        if (sample->decoder->extensions[0]) {
+            SDL_strlcpy(info->decoder, sample->decoder->extensions[0], sizeof (info->decoder));
+        }
+        Sound_FreeSample(sample);
+    }
+
+    char *path = SDL_strdup(fname);
+    if (path) {
+        SDL_LockMutex(playlist_lock);
+        store_index_cache_locked(path, info);
+        index_cache_dirty = SDL_TRUE;
+        SDL_UnlockMutex(playlist_lock);
+    }
+}
+
+// A small pool of these scan dropped directories and fill in TrackInfo for every playlist entry, in playlist order.
+static int SDLCALL index_thread_entry(void *userdata)
+{
+    while (SDL_TRUE) {
+        char *dir = NULL;
+        char *fname = NULL;
+        int index = -1;
+
+        SDL_SemWait(index_sem);
+
+        SDL_LockMutex(playlist_lock);
+        if (index_quit) {
+            SDL_UnlockMutex(playlist_lock);
+            break;
+        }
+
+        const int serial = SDL_AtomicGet(&playlist_serial);
+        if (num_index_dirs > 0) {
+            dir = index_dirs[0];
+            num_index_dirs--;
+            SDL_memmove(index_dirs, index_dirs + 1, sizeof (char *) * num_index_dirs);
+        } else {
+            while ((index_cursor < playlist_len) && (playlist[index_cursor].state != TRACK_UNINDEXED)) {
+                index_cursor++;
+            }
+            if (index_cursor < playlist_len) {
+                index = index_cursor++;
+                fname = SDL_strdup(playlist[index].path);
+                playlist[index].state = fname ? TRACK_INDEXING : TRACK_UNINDEXED;
+            }
+        }
+        SDL_UnlockMutex(playlist_lock);
+
+        if (dir) {
+            scan_directory(dir, serial);
+            SDL_free(dir);
+        } else if (fname) {
+            TrackInfo info;
+            index_track(fname, &info);
+            SDL_free(fname);
+
+            SDL_LockMutex(playlist_lock);
+            if (serial == SDL_AtomicGet(&playlist_serial)) {  // entries only go away when the whole playlist is cleared.
+                SDL_memcpy(&playlist[index].info, &info, sizeof (TrackInfo));
+                playlist[index].state = TRACK_INDEXED;
+            }
+            SDL_UnlockMutex(playlist_lock);
+        }
+    }
+
+    return 0;
+}
+
+static SDL_HitTestResult SDLCALL hit_test_callback(SDL_Window *win, const SDL_Point *area, void *data)
+{
+    if (area->y < 14) {
+        int i;
+        /* !!! FIXME: code duplication */
+        WinAmpSkinButton *buttons = skin.winshade_mode ? skin.winshade_buttons : skin.buttons;
+        const int num_buttons = skin.winshade_mode ? SDL_arraysize(skin.winshade_buttons) : SDL_arraysize(skin.buttons);
+        WinAmpSkinSlider *sliders = skin.winshade_mode ? &skin.winshade_position_slider : skin.sliders;
+        const int num_sliders = skin.winshade_mode ? 1 : SDL_arraysize(skin.sliders);
+
+        /* we are in the titlebar, make sure we're not in a button or a slider. */
+        for (i = 0; i < num_buttons; i++) {
+            if (SDL_PointInRect(area, &buttons[i].dstrect)) {
+                return SDL_HITTEST_NORMAL;  /* we're in a button, don't drag from the buttons! */
+            }
+        }
+
+        for (i = 0; i < num_sliders; i++) {
+            if (SDL_PointInRect(area, &sliders[i].dstrect)) {
+                return SDL_HITTEST_NORMAL;  /* we're in a slider, don't drag from the buttons! */
+            }
+        }
+
+        return SDL_HITTEST_DRAGGABLE;  /* everything else in the titlebar, treat as a window drag. */
+    }
+
+    return SDL_HITTEST_NORMAL;  /* nothing magic about the mouse click. */
+}
+
+
+
+// !!! FIXME: maybe a better name.
+
+// Note that part of the window needs to be repainted. NULL means all of it.
+static void mark_dirty(const SDL_Rect *rect)
+{
+    const SDL_Rect everything = { 0, 0, 275, 116 };
+    SDL_Rect area;
+
+    if (!rect || !canvas) {  // without a canvas to keep between frames, we have to redraw the whole thing anyhow.
+        rect = &everything;
+    }
+
+    SDL_memcpy(&area, rect, sizeof (area));
+
+    // merge with anything it touches, so we never paint the same pixels twice.
+    for (int i = 0; i < num_dirty_rects; i++) {
+        if (SDL_HasIntersection(&area, &dirty_rects[i])) {
+            SDL_UnionRect(&area, &dirty_rects[i], &area);
+            dirty_rects[i--] = dirty_rects[--num_dirty_rects];  // remove it; look at the one we moved into this slot next.
+        }
+    }
+
+    if (num_dirty_rects == SDL_arraysize(dirty_rects)) {  // out of space? Just fold everything into one big rect.
+        for (int i = 1; i < num_dirty_rects; i++) {
+            SDL_UnionRect(&dirty_rects[0], &dirty_rects[i], &dirty_rects[0]);
+        }
+        SDL_UnionRect(&dirty_rects[0], &area, &dirty_rects[0]);
+        num_dirty_rects = 1;
+    } else {
+        dirty_rects[num_dirty_rects++] = area;
+    }
+}
+
+static void set_pressed(WinAmpSkinButton *btn)
+{
+    if (skin.pressed != btn) {
+        if (skin.pressed) {
+            mark_dirty(&skin.pressed->dstrect);
+        }
+        if (btn) {
+            mark_dirty(&btn->dstrect);
+        }
+        skin.pressed = btn;
+    }
+}
+
+static void minimize_clicked(void)
+{
+    SDL_MinimizeWindow(window);
+}
+
+static void winshade_clicked(void)
+{
+    skin.winshade_mode = SDL_TRUE;
+    SDL_SetWindowSize(window, 275, 14);
+    mark_dirty(NULL);
+}
+
+static void unwinshade_clicked(void)
+{
+SDL_Log("UNWINSHADE!");
+    skin.winshade_mode = SDL_FALSE;
+    SDL_SetWindowSize(window, 275, 116);
+    mark_dirty(NULL);
+}
+
+static void close_clicked(void)
+{
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = SDL_QUIT;
+    SDL_PushEvent(&event);
+}
+
+static void previous_clicked(void)
+{
+    send_decoder_command(DECODERCMD_REWIND, NULL);
+}
+
+static void pause_clicked(void)
+{
+    // the audio device keeps running; the callback fades out and plays silence until we unpause.
+    begin_params_update();
+    SDL_AtomicSet(&params.paused, SDL_AtomicGet(&params.paused) ? 0 : 1);
+    end_params_update();
+}
+
+static void stop_clicked(void)
+{
+    stop_audio();
+}
+
+static void next_clicked(void)
+{
+    int index;
+
+    // skip anything the indexer already knows we can't play.
+    SDL_LockMutex(playlist_lock);
+    for (index = SDL_AtomicGet(&playing_index) + 1; index < playlist_len; index++) {
+        if ((playlist[index].state != TRACK_INDEXED) || playlist[index].info.playable) {
+            break;
+        }
+    }
+    SDL_UnlockMutex(playlist_lock);
+
+    play_playlist_entry(index);  // does nothing if we're at the end.
+}
+
+// There's no file dialog to pop up, so this just empties the playlist.
+static void eject_clicked(void)
+{
+    stop_audio();
+    clear_playlist();
+    SDL_AtomicSet(&playing_index, -1);
+}
+
+static SDL_Surface *load_bitmap(const char *fname)
+{
+    SDL_RWops *rw = openrw(fname);
+    return rw ? SDL_LoadBMP_RW(rw, 1) : NULL;  // MAY BE NULL.
+}
+
+// Pack the skin's bitmaps into one surface, filling in where each one landed.
+//  This is a simple shelf packer: tallest bitmaps first, left to right, starting a
+//  new shelf when a row fills up. There are only a handful of bitmaps and they
+//  come in a few known shapes, so this doesn't need to be clever.
+static SDL_Surface *pack_skin_atlas(SDL_Surface **bitmaps, SDL_Rect *rects, SDL_Rect *white)
+{
+    int order[WASBMP_TOTAL];
+    int atlas_w = 512;
+    int x = 0, y = 0, shelf_h = 0;
+    int i, j;
+
+    // the white block goes first, in the top-left corner of the first shelf.
+    white->x = white->y = 0;
+    white->w = white->h = 4;
+
+    for (i = 0; i < WASBMP_TOTAL; i++) {
+        order[i] = i;
+        SDL_zerop(&rects[i]);
+        if (bitmaps[i] && (bitmaps[i]->w > atlas_w)) {
+            atlas_w = bitmaps[i]->w;
+        }
+    }
+
+    // insertion sort by height, tallest first. It's five items.
+    for (i = 1; i < WASBMP_TOTAL; i++) {
+        const int id = order[i];
+        const int h = bitmaps[id] ? bitmaps[id]->h : 0;
+        for (j = i; (j > 0) && ((bitmaps[order[j-1]] ? bitmaps[order[j-1]]->h : 0) < h); j--) {
+            order[j] = order[j-1];
+        }
+        order[j] = id;
+    }
+
+    x = white->w;
+    shelf_h = white->h;
+    for (i = 0; i < WASBMP_TOTAL; i++) {
+        const SDL_Surface *bmp = bitmaps[order[i]];
+        if (!bmp) {
+            continue;
+        } else if ((x + bmp->w) > atlas_w) {
+            y += shelf_h;
+            x = shelf_h = 0;
+        }
+        rects[order[i]].x = x;
+        rects[order[i]].y = y;
+        rects[order[i]].w = bmp->w;
+        rects[order[i]].h = bmp->h;
+        x += bmp->w;
+        shelf_h = SDL_max(shelf_h, bmp->h);
+    }
+
+    // no alpha channel, so the texture doesn't get a blend mode we'd pay for on every pixel.
+    SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(0, atlas_w, y + shelf_h, 32, SDL_PIXELFORMAT_RGB888);
+    if (!atlas) {
+        return NULL;
+    }
+
+    SDL_FillRect(atlas, NULL, SDL_MapRGB(atlas->format, 0, 0, 0));
+    SDL_FillRect(atlas, white, SDL_MapRGB(atlas->format, 255, 255, 255));
+    for (i = 0; i < WASBMP_TOTAL; i++) {
+        if (bitmaps[i]) {
+            SDL_SetSurfaceBlendMode(bitmaps[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(bitmaps[i], NULL, atlas, &rects[i]);
+        }
+    }
+
+    return atlas;
+}
+
+
+static SDL_INLINE void init_skin_button(WinAmpSkinButton *btn, const WinAmpSkin *skin, const WinAmpSkinBitmapId bmp, ClickFn clickfn,
+                                        const int w, const int h,
+                                        const int dx, const int dy,
+                                        const int sxu, const int syu,
+                                        const int sxp, const int syp)
+{
+    // source coordinates are relative to the skin's .bmp file; move them to where it lives in the atlas.
+    const SDL_Rect *origin = &skin->bitmaps[bmp];
+    btn->has_bitmap = (skin->atlas && (origin->w > 0)) ? SDL_TRUE : SDL_FALSE;
+    btn->srcrect_unpressed.x = origin->x + sxu;
+    btn->srcrect_unpressed.y = origin->y + syu;
+    btn->srcrect_unpressed.w = w;
+    btn->srcrect_unpressed.h = h;
+    btn->srcrect_pressed.x = origin->x + sxp;
+    btn->srcrect_pressed.y = origin->y + syp;
+    btn->srcrect_pressed.w = w;
+    btn->srcrect_pressed.h = h;
+    btn->dstrect.x = dx;
+    btn->dstrect.y = dy;
+    btn->dstrect.w = w;
+    btn->dstrect.h = h;
+    btn->clickfn = clickfn;
+}
+
+// Move a slider's knob to match `value`. Returns SDL_TRUE if that moved anything on screen.
+static SDL_bool set_slider_value(WinAmpSkinSlider *slider, const float value)
+{
+    const int x = slider->dstrect.x;
+    const int w = slider->dstrect.w;
+    const int knobw = slider->knob.dstrect.w;
+    SDL_assert(value >= 0.0f);
+    SDL_assert(value <= 1.0f);
+    const int knobx = x + (int) ( ( ((((float) w) * value) - (((float) knobw) / 2.0f)) + 0.5f ) );
+    const int oldx = slider->knob.dstrect.x;
+    const int oldframe = (int) (((float) slider->num_frames) * slider->value);
+    slider->value = value;
+    slider->knob.dstrect.x = SDL_clamp(knobx, x, ((x + w) - knobw));
+    return ((slider->knob.dstrect.x != oldx) || (((int) (((float) slider->num_frames) * value)) != oldframe)) ? SDL_TRUE : SDL_FALSE;
+}
+
+static SDL_INLINE void init_skin_slider(WinAmpSkinSlider *slider, const WinAmpSkin *skin, const WinAmpSkinBitmapId bmp,
+                                        const int w, const int h,
+                                        const int dx, const int dy,
+                                        const int knobw, const int knobh,
+                                        const int sxu, const int syu,
+                                        const int sxp, const int syp,
+                                        const int num_frames,
+                                        const int frame_x_offset,
+                                        const int frame_y_offset,
+                                        const int frame_width, const int frame_height,
+                                        const float initial_value)
+{
+    init_skin_button(&slider->knob, skin, bmp, NULL, knobw, knobh, dx, dy, sxu, syu, sxp, syp);
+    slider->has_bitmap = slider->knob.has_bitmap;
+    slider->num_frames = num_frames;
+    slider->frame_x_offset = skin->bitmaps[bmp].x + frame_x_offset;
+    slider->frame_y_offset = skin->bitmaps[bmp].y + frame_y_offset;
+    slider->frame_width = frame_width;
+    slider->frame_height = frame_height;
+    slider->dstrect.x = dx;
+    slider->dstrect.y = dy;
+    slider->dstrect.w = w;
+    slider->dstrect.h = h;
+    set_slider_value(slider, initial_value);
+}
+
+static void free_skin(WinAmpSkin *skin)
+{
+    if (skin->atlas) { SDL_DestroyTexture(skin->atlas); }
+    SDL_zerop(skin);
+}
+
+// This mounts things in PhysFS, so only one thread may be in here at a time: the UI
+//  thread during startup, before the skin thread exists, and the skin thread after that.
+static DecodedSkin *decode_skin(const char *fname, const void *buf, const size_t len, const Uint64 hash)
+{
+    static const char *bitmap_filenames[WASBMP_TOTAL] = {
+        "main.bmp", "cbuttons.bmp", "volume.bmp", "balance.bmp", "titlebar.bmp"
+    };
+    SDL_Surface *bitmaps[WASBMP_TOTAL];
+    int i;
+
+    DecodedSkin *decoded = (DecodedSkin *) SDL_calloc(1, sizeof (DecodedSkin));
+    if (!decoded) {
+        return NULL;
+    }
+
+    decoded->hash = hash;
+
+    // we already have the whole file in memory for the hash, so mount that instead of reading it all again.
+    SDL_zero(bitmaps);
+    if (buf && PHYSFS_mountMemory(buf, (PHYSFS_uint64) len, NULL, fname, NULL, 1)) {
+        for (i = 0; i < WASBMP_TOTAL; i++) {
+            bitmaps[i] = load_bitmap(bitmap_filenames[i]);
+        }
+        PHYSFS_unmount(fname);
+    }
+
+    // even with no bitmaps at all, we still want an atlas for the white block, so the placeholders draw in one batch too.
+    decoded->atlas = pack_skin_atlas(bitmaps, decoded->bitmaps, &decoded->white);
+    for (i = 0; i < WASBMP_TOTAL; i++) {
+        if (bitmaps[i]) { SDL_FreeSurface(bitmaps[i]); }
+    }
+
+    return decoded;
+}
+
+static void free_decoded_skin(DecodedSkin *decoded)
+{
+    if (decoded->atlas) { SDL_FreeSurface(decoded->atlas); }
+    SDL_free(decoded);
+}
+
+// Find (or decode and cache) the skin in `fname`. The result is pinned; unpin_decoded_skin() it when done.
+static DecodedSkin *get_decoded_skin(const char *fname)
+{
+    const Uint32 max_cached = SDL_max(get_hint_uint("SDLAMP_SKIN_CACHE", 4), 1);
+    DecodedSkin *decoded = NULL;
+    DecodedSkin *prev = NULL;
+    size_t len = 0;
+    Uint32 total = 0;
+
+    void *buf = SDL_LoadFile(fname, &len);  // if this fails, we'll end up with the "no skin" placeholders.
+    const Uint64 hash = hash_bytes(buf, buf ? len : 0);
+
+    SDL_LockMutex(skin_lock);
+    for (decoded = decoded_skins; decoded != NULL; prev = decoded, decoded = decoded->next) {
+        if (decoded->hash == hash) {
+            if (prev) {  // move it to the front, it's the most recently used now.
+                prev->next = decoded->next;
+                decoded->next = decoded_skins;
+                decoded_skins = decoded;
+            }
+            decoded->pins++;
+            break;
+        }
+    }
+    SDL_UnlockMutex(skin_lock);
+
+    if (decoded) {
+        SDL_free(buf);
+        return decoded;  // cache hit, nothing else to do.
+    }
+
+    decoded = decode_skin(fname, buf, len, hash);
+    SDL_free(buf);
+    if (!decoded) {
+        return NULL;
+    }
+
+    SDL_LockMutex(skin_lock);
+    decoded->pins = 1;
+    decoded->next = decoded_skins;
+    decoded_skins = decoded;
+
+    // trim the cache, but leave anything that's still pinned.
+    prev = NULL;
+    DecodedSkin *cached = decoded_skins;
+    while (cached != NULL) {
+        DecodedSkin *next = cached->next;
+        if ((++total > max_cached) && (cached->pins == 0)) {
+            if (prev) { prev->next = next; } else { decoded_skins = next; }
+            free_decoded_skin(cached);
+        } else {
+            prev = cached;
+        }
+        cached = next;
+    }
+    SDL_UnlockMutex(skin_lock);
+
+    return decoded;
+}
+
+static void unpin_decoded_skin(DecodedSkin *decoded)
+{
+    SDL_LockMutex(skin_lock);
+    SDL_assert(decoded->pins > 0);
+    decoded->pins--;
+    SDL_UnlockMutex(skin_lock);
+}
+
+// Upload a decoded skin and set up the buttons and sliders to use it. This is the only part of loading a skin that has to happen on the UI thread.
+static void apply_decoded_skin(WinAmpSkin *skin, const DecodedSkin *decoded)
+{
+    free_skin(skin);
+
+    if (decoded->atlas) {
+        skin->atlas = SDL_CreateTextureFromSurface(renderer, decoded->atlas);  // MAY BE NULL.
+        skin->atlas_w = decoded->atlas->w;
+        skin->atlas_h = decoded->atlas->h;
+    }
+
+    if (skin->atlas) {
+        SDL_memcpy(skin->bitmaps, decoded->bitmaps, sizeof (skin->bitmaps));
+        skin->white = decoded->white;
+    }  // else everything falls back to placeholders.
+
+    // normal ("main") window mode...
+    init_skin_button(&skin->buttons[WASBTN_SYSTEM], skin, WASBMP_TITLEBAR, NULL, 9, 9, 6, 3, 0, 0, 0, 9);
+    init_skin_button(&skin->buttons[WASBTN_MINIMIZE], skin, WASBMP_TITLEBAR, minimize_clicked, 9, 9, 244, 3, 9, 0, 9, 9);
+    init_skin_button(&skin->buttons[WASBTN_WINSHADE], skin, WASBMP_TITLEBAR, winshade_clicked, 9, 9, 254, 3, 0, 18, 9, 18);
+    init_skin_button(&skin->buttons[WASBTN_CLOSE], skin, WASBMP_TITLEBAR, close_clicked, 9, 9, 264, 3, 18, 0, 18, 9);
+    init_skin_button(&skin->buttons[WASBTN_PREV], skin, WASBMP_CBUTTONS, previous_clicked, 23, 18, 16, 88, 0, 0, 0, 18);
+    init_skin_button(&skin->buttons[WASBTN_PLAY], skin, WASBMP_CBUTTONS, NULL, 23, 18, 39, 88, 23, 0, 23, 18);
+    init_skin_button(&skin->buttons[WASBTN_PAUSE], skin, WASBMP_CBUTTONS, pause_clicked, 23, 18, 62, 88, 46, 0, 46, 18);
+    init_skin_button(&skin->buttons[WASBTN_STOP], skin, WASBMP_CBUTTONS, stop_clicked, 23, 18, 85, 88, 69, 0, 69, 18);
+    init_skin_button(&skin->buttons[WASBTN_NEXT], skin, WASBMP_CBUTTONS, next_clicked, 22, 18, 108, 88, 92, 0, 92, 18);
+    init_skin_button(&skin->buttons[WASBTN_EJECT], skin, WASBMP_CBUTTONS, eject_clicked, 22, 16, 136, 89, 114, 0, 114, 16);
+    init_skin_slider(&skin->sliders[WASSLD_VOLUME], skin, WASBMP_VOLUME, 68, 13, 107, 57, 14, 11, 15, 422, 0, 422, 28, 0, 0, 68, 15, 1.0f);
+    init_skin_slider(&skin->sliders[WASSLD_BALANCE], skin, WASBMP_BALANCE, 38, 13, 177, 57, 14, 11, 15, 422, 0, 422, 28, 9, 0, 47, 15, 0.5f);
+
+    // winshade mode...
+    init_skin_button(&skin->winshade_buttons[WASBTN_SYSTEM], skin, WASBMP_TITLEBAR, NULL, 9, 9, 6, 3, 0, 0, 0, 9);
+    init_skin_button(&skin->winshade_buttons[WASBTN_MINIMIZE], skin, WASBMP_TITLEBAR, minimize_clicked, 9, 9, 244, 3, 9, 0, 9, 9);
+    init_skin_button(&skin->winshade_buttons[WASBTN_WINSHADE], skin, WASBMP_TITLEBAR, unwinshade_clicked, 9, 9, 254, 3, 0, 27, 9, 27);
+    init_skin_button(&skin->winshade_buttons[WASBTN_CLOSE], skin, WASBMP_TITLEBAR, close_clicked, 9, 9, 264, 3, 18, 0, 18, 9);
+    init_skin_button(&skin->winshade_buttons[WASBTN_PREV], skin, WASBMP_TITLEBAR, previous_clicked, 8, 10, 168, 2, 195, 31, 195, 31);
+    init_skin_button(&skin->winshade_buttons[WASBTN_PLAY], skin, WASBMP_TITLEBAR, NULL, 10, 10, 176, 2, 203, 31, 203, 31);
+    init_skin_button(&skin->winshade_buttons[WASBTN_PAUSE], skin, WASBMP_TITLEBAR, pause_clicked, 9, 10, 186, 2, 213, 31, 213, 31);
+    init_skin_button(&skin->winshade_buttons[WASBTN_STOP], skin, WASBMP_TITLEBAR, stop_clicked, 9, 10, 195, 2, 222, 31, 222, 31);
+    init_skin_button(&skin->winshade_buttons[WASBTN_NEXT], skin, WASBMP_TITLEBAR, next_clicked, 11, 10, 204, 2, 231, 31, 231, 31);
+    init_skin_button(&skin->winshade_buttons[WASBTN_EJECT], skin, WASBMP_TITLEBAR, eject_clicked, 10, 10, 215, 2, 242, 31, 242, 31);
+    init_skin_slider(&skin->winshade_position_slider, skin, WASBMP_TITLEBAR, 17, 7, 27, 29, 3, 7, 17, 36, 17, 36, 1, 0, 36, 17, 7, 0.0f);
+}
+
+// Load a skin right now, on this thread. Only for startup; after that, use request_skin().
+static void load_skin(WinAmpSkin *skin, const char *fname)
+{
+    DecodedSkin *decoded = get_decoded_skin(fname);
+    if (decoded) {
+        apply_decoded_skin(skin, decoded);
+        unpin_decoded_skin(decoded);
+    } else {
+        free_skin(skin);
+    }
+}
+
+static int SDLCALL skin_thread_entry(void *userdata)
+{
+    while (SDL_TRUE) {
+        SDL_SemWait(skin_sem);
+
+        SDL_LockMutex(skin_lock);
+        if (skin_quit) {
+            SDL_UnlockMutex(skin_lock);
+            break;
+        }
+        char *fname = pending_skin_fname;
+        pending_skin_fname = NULL;
+        SDL_UnlockMutex(skin_lock);
+
+        if (!fname) {
+            continue;  // someone asked for a skin and we already handled it.
+        }
+
+        DecodedSkin *decoded = get_decoded_skin(fname);
+        SDL_free(fname);
+
+        if (decoded) {
+            SDL_Event event;
+            SDL_zero(event);
+            event.type = skin_ready_event;
+            event.user.data1 = decoded;  // UI thread unpins this.
+            if (SDL_PushEvent(&event) != 1) {
+                unpin_decoded_skin(decoded);
+            }
+        }
     }
 
-    return SDL_HITTEST_NORMAL;  /* nothing magic about the mouse click. */
+    return 0;
 }
 
+// Ask the skin thread to load a skin; it shows up as a skin_ready_event when it's ready.
+//  If you ask for another before that, the older request might be skipped.
+static void request_skin(const char *fname)
+{
+    char *dup = SDL_strdup(fname);
+    if (!dup) {
+        return;  // out of memory; just drop it.
+    }
 
+    SDL_LockMutex(skin_lock);
+    SDL_free(pending_skin_fname);
+    pending_skin_fname = dup;
+    SDL_UnlockMutex(skin_lock);
 
-// !!! FIXME: maybe a better name.
-
-static void minimize_clicked(void)
-{
-    SDL_MinimizeWindow(window);
+    SDL_SemPost(skin_sem);
 }
 
-static void winshade_clicked(void)
-{
-    skin.winshade_mode = SDL_TRUE;
-    SDL_SetWindowSize(window, 275, 14);
-}
+// The visualizer, in the main window's display, like the real thing: a spectrum
+//  analyzer or an oscilloscope (click it to switch, or turn it off). It runs on the
+//  render thread, at most VIS_FPS times a second, from whatever's in the tap. All
+//  the work is a fixed size, so it costs the same every frame; we time it anyhow.
+#define VIS_FPS 30
+#define VIS_BARS 19
+#define VIS_HEIGHT 16
+#define VIS_FFT_HALF (VIS_FFT_SIZE / 2)
 
-static void unwinshade_clicked(void)
+typedef enum
 {
-SDL_Log("UNWINSHADE!");
-    skin.winshade_mode = SDL_FALSE;
-    SDL_SetWindowSize(window, 275, 116);
-}
+    VISMODE_SPECTRUM=0,
+    VISMODE_SCOPE,
+    VISMODE_OFF,
+    VISMODE_TOTAL
+} VisMode;
+
+// The real FFT packs the even samples into the real parts and the odd ones into the
+//  imaginary parts of a complex FFT half the size, then untangles the result. The
+//  complex FFT keeps real and imaginary parts in separate arrays, and each pass's
+//  twiddle factors are stored contiguously, so the butterflies vectorize cleanly.
+typedef void (*FFTPassesFn)(float *re, float *im);
 
-static void close_clicked(void)
+typedef struct
 {
-    SDL_Event event;
-    SDL_zero(event);
-    event.type = SDL_QUIT;
-    SDL_PushEvent(&event);
+    float window[VIS_FFT_SIZE];  // Hann window.
+    int bitrev[VIS_FFT_HALF];
+    float twiddle_re[VIS_FFT_HALF];  // for the pass that combines pairs of size N: entries (N - 1) to (2N - 2).
+    float twiddle_im[VIS_FFT_HALF];
+    float split_re[VIS_FFT_HALF];  // for untangling the real FFT.
+    float split_im[VIS_FFT_HALF];
+    int bar_edges[VIS_BARS + 1];  // which FFT bins go in each bar; log spaced, since that's how we hear.
+    FFTPassesFn passes;
+} VisTables;
+
+static const SDL_Rect vis_rect = { 24, 43, 76, 16 };
+static VisTables vis_tables;
+static VisMode vis_mode = VISMODE_SPECTRUM;
+static float vis_bars[VIS_BARS];  // in pixels, falling off gradually.
+static float vis_scope[76];  // one sample per column, -1.0f to 1.0f.
+static SDL_bool vis_animating = SDL_FALSE;  // SDL_TRUE if the visualizer wants to keep getting frames.
+static Uint32 vis_last_update = 0;
+static Uint32 vis_last_tap_pos = 0;
+static Uint64 vis_updates = 0;  // cost accounting, in performance counter ticks.
+static Uint64 vis_total_ticks = 0;
+static Uint64 vis_max_ticks = 0;
+
+static void fft_passes_scalar(float *re, float *im)
+{
+    for (int half = 1; half < VIS_FFT_HALF; half <<= 1) {
+        const float *wr = vis_tables.twiddle_re + (half - 1);
+        const float *wi = vis_tables.twiddle_im + (half - 1);
+        for (int base = 0; base < VIS_FFT_HALF; base += half * 2) {
+            float *are = re + base, *aim = im + base;
+            float *bre = are + half, *bim = aim + half;
+            for (int j = 0; j < half; j++) {
+                const float tr = (bre[j] * wr[j]) - (bim[j] * wi[j]);
+                const float ti = (bre[j] * wi[j]) + (bim[j] * wr[j]);
+                bre[j] = are[j] - tr;
+                bim[j] = aim[j] - ti;
+                are[j] += tr;
+                aim[j] += ti;
+            }
+        }
+    }
 }
 
-static void previous_clicked(void)
+#if SDLAMP_HAVE_SSE2
+static void fft_passes_sse2(float *re, float *im)
 {
-    int rc = 1;
-    SDL_LockAudioDevice(audio_device);
-    if (current_sample) {
-        rc = Sound_Rewind(current_sample);
+    int half;
+
+    // the first two passes are too narrow for four lanes, do them the slow way.
+    for (half = 1; half < 4; half <<= 1) {
+        const float *wr = vis_tables.twiddle_re + (half - 1);
+        const float *wi = vis_tables.twiddle_im + (half - 1);
+        for (int base = 0; base < VIS_FFT_HALF; base += half * 2) {
+            float *are = re + base, *aim = im + base;
+            float *bre = are + half, *bim = aim + half;
+            for (int j = 0; j < half; j++) {
+                const float tr = (bre[j] * wr[j]) - (bim[j] * wi[j]);
+                const float ti = (bre[j] * wi[j]) + (bim[j] * wr[j]);
+                bre[j] = are[j] - tr;
+                bim[j] = aim[j] - ti;
+                are[j] += tr;
+                aim[j] += ti;
+            }
+        }
     }
-    sample_available = 0;
-    sample_position = 0;
-    SDL_UnlockAudioDevice(audio_device);
-    if (!rc) {
-        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Couldn't rewind audio file!", Sound_GetError(), window);
+
+    for (; half < VIS_FFT_HALF; half <<= 1) {
+        const float *wr = vis_tables.twiddle_re + (half - 1);
+        const float *wi = vis_tables.twiddle_im + (half - 1);
+        for (int base = 0; base < VIS_FFT_HALF; base += half * 2) {
+            float *are = re + base, *aim = im + base;
+            float *bre = are + half, *bim = aim + half;
+            for (int j = 0; j < half; j += 4) {
+                const __m128 twr = _mm_loadu_ps(wr + j);
+                const __m128 twi = _mm_loadu_ps(wi + j);
+                const __m128 br = _mm_loadu_ps(bre + j);
+                const __m128 bi = _mm_loadu_ps(bim + j);
+                const __m128 ar = _mm_loadu_ps(are + j);
+                const __m128 ai = _mm_loadu_ps(aim + j);
+                const __m128 tr = _mm_sub_ps(_mm_mul_ps(br, twr), _mm_mul_ps(bi, twi));
+                const __m128 ti = _mm_add_ps(_mm_mul_ps(br, twi), _mm_mul_ps(bi, twr));
+                _mm_storeu_ps(bre + j, _mm_sub_ps(ar, tr));
+                _mm_storeu_ps(bim + j, _mm_sub_ps(ai, ti));
+                _mm_storeu_ps(are + j, _mm_add_ps(ar, tr));
+                _mm_storeu_ps(aim + j, _mm_add_ps(ai, ti));
+            }
+        }
     }
 }
+#endif
 
-static SDL_bool paused = SDL_TRUE;  // !!! FIXME: move this later.
-
-static void pause_clicked(void)
+#if SDLAMP_HAVE_NEON
+static void fft_passes_neon(float *re, float *im)
 {
-    paused = paused ? SDL_FALSE : SDL_TRUE;
-    SDL_PauseAudioDevice(audio_device, paused);
-}
+    int half;
+
+    // the first two passes are too narrow for four lanes, do them the slow way.
+    for (half = 1; half < 4; half <<= 1) {
+        const float *wr = vis_tables.twiddle_re + (half - 1);
+        const float *wi = vis_tables.twiddle_im + (half - 1);
+        for (int base = 0; base < VIS_FFT_HALF; base += half * 2) {
+            float *are = re + base, *aim = im + base;
+            float *bre = are + half, *bim = aim + half;
+            for (int j = 0; j < half; j++) {
+                const float tr = (bre[j] * wr[j]) - (bim[j] * wi[j]);
+                const float ti = (bre[j] * wi[j]) + (bim[j] * wr[j]);
+                bre[j] = are[j] - tr;
+                bim[j] = aim[j] - ti;
+                are[j] += tr;
+                aim[j] += ti;
+            }
+        }
+    }
 
-static void stop_clicked(void)
-{
-    stop_audio();
+    for (; half < VIS_FFT_HALF; half <<= 1) {
+        const float *wr = vis_tables.twiddle_re + (half - 1);
+        const float *wi = vis_tables.twiddle_im + (half - 1);
+        for (int base = 0; base < VIS_FFT_HALF; base += half * 2) {
+            float *are = re + base, *aim = im + base;
+            float *bre = are + half, *bim = aim + half;
+            for (int j = 0; j < half; j += 4) {
+                const float32x4_t twr = vld1q_f32(wr + j);
+                const float32x4_t twi = vld1q_f32(wi + j);
+                const float32x4_t br = vld1q_f32(bre + j);
+                const float32x4_t bi = vld1q_f32(bim + j);
+                const float32x4_t ar = vld1q_f32(are + j);
+                const float32x4_t ai = vld1q_f32(aim + j);
+                const float32x4_t tr = vsubq_f32(vmulq_f32(br, twr), vmulq_f32(bi, twi));
+                const float32x4_t ti = vaddq_f32(vmulq_f32(br, twi), vmulq_f32(bi, twr));
+                vst1q_f32(bre + j, vsubq_f32(ar, tr));
+                vst1q_f32(bim + j, vsubq_f32(ai, ti));
+                vst1q_f32(are + j, vaddq_f32(ar, tr));
+                vst1q_f32(aim + j, vaddq_f32(ai, ti));
+            }
+        }
+    }
 }
+#endif
 
-static SDL_Texture *load_texture(SDL_RWops *rw)
+static void init_visualizer(void)
 {
-    if (rw == NULL) {
-        return NULL;
-    }
+    const double pi = 3.14159265358979323846;
+    VisTables *t = &vis_tables;
+    int bits = 0;
+    int i;
 
-    SDL_Surface *surface = SDL_LoadBMP_RW(rw, 1);
-    if (!surface) {
-        return NULL;
+    while ((1 << bits) < VIS_FFT_HALF) {
+        bits++;
     }
 
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FreeSurface(surface);
-    return texture;  // MAY BE NULL.
-}
+    for (i = 0; i < VIS_FFT_SIZE; i++) {
+        t->window[i] = (float) (0.5 - (0.5 * SDL_cos((2.0 * pi * i) / (VIS_FFT_SIZE - 1))));
+    }
 
+    for (i = 0; i < VIS_FFT_HALF; i++) {
+        int rev = 0;
+        for (int b = 0; b < bits; b++) {
+            rev |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        t->bitrev[i] = rev;
+        t->split_re[i] = (float) SDL_cos((-2.0 * pi * i) / VIS_FFT_SIZE);
+        t->split_im[i] = (float) SDL_sin((-2.0 * pi * i) / VIS_FFT_SIZE);
+    }
 
-static SDL_INLINE void init_skin_button(WinAmpSkinButton *btn, SDL_Texture *tex, ClickFn clickfn,
-                                        const int w, const int h,
-                                        const int dx, const int dy,
-                                        const int sxu, const int syu,
-                                        const int sxp, const int syp)
-{
-    btn->texture = tex;
-    btn->srcrect_unpressed.x = sxu;
-    btn->srcrect_unpressed.y = syu;
-    btn->srcrect_unpressed.w = w;
-    btn->srcrect_unpressed.h = h;
-    btn->srcrect_pressed.x = sxp;
-    btn->srcrect_pressed.y = syp;
-    btn->srcrect_pressed.w = w;
-    btn->srcrect_pressed.h = h;
-    btn->dstrect.x = dx;
-    btn->dstrect.y = dy;
-    btn->dstrect.w = w;
-    btn->dstrect.h = h;
-    btn->clickfn = clickfn;
-}
+    for (int half = 1; half < VIS_FFT_HALF; half <<= 1) {
+        for (i = 0; i < half; i++) {
+            t->twiddle_re[(half - 1) + i] = (float) SDL_cos((-pi * i) / half);
+            t->twiddle_im[(half - 1) + i] = (float) SDL_sin((-pi * i) / half);
+        }
+    }
 
-static SDL_INLINE void init_skin_slider(WinAmpSkinSlider *slider, SDL_Texture *tex,
-                                        const int w, const int h,
-                                        const int dx, const int dy,
-                                        const int knobw, const int knobh,
-                                        const int sxu, const int syu,
-                                        const int sxp, const int syp,
-                                        const int num_frames,
-                                        const int frame_x_offset,
-                                        const int frame_y_offset,
-                                        const int frame_width, const int frame_height,
-                                        const float initial_value)
-{
-    init_skin_button(&slider->knob, tex, NULL, knobw, knobh, dx, dy, sxu, syu, sxp, syp);
-    slider->texture = tex;
-    slider->num_frames = num_frames;
-    slider->frame_x_offset = frame_x_offset;
-    slider->frame_y_offset = frame_y_offset;
-    slider->frame_width = frame_width;
-    slider->frame_height = frame_height;
-    slider->dstrect.x = dx;
-    slider->dstrect.y = dy;
-    slider->dstrect.w = w;
-    slider->dstrect.h = h;
-    slider->value = initial_value;
+    // bin 0 is DC, skip it. Make sure every bar gets at least one bin of its own.
+    t->bar_edges[0] = 1;
+    for (i = 1; i <= VIS_BARS; i++) {
+        const int edge = (int) SDL_pow((double) VIS_FFT_HALF, ((double) i) / ((double) VIS_BARS));
+        t->bar_edges[i] = SDL_clamp(edge, t->bar_edges[i - 1] + 1, VIS_FFT_HALF);
+    }
 
-    SDL_assert(initial_value >= 0.0f);
-    SDL_assert(initial_value <= 1.0f);
-    const int knobx = dx + (int) ( ( ((((float) w) * initial_value) - (((float) knobw) / 2.0f)) + 0.5f ) );
-    slider->knob.dstrect.x = SDL_clamp(knobx, dx, ((dx + w) - knobw));
+    t->passes = fft_passes_scalar;
+    #if SDLAMP_HAVE_SSE2
+    if (SDL_HasSSE2()) { t->passes = fft_passes_sse2; }
+    #endif
+    #if SDLAMP_HAVE_NEON
+    if (SDL_HasNEON()) { t->passes = fft_passes_neon; }
+    #endif
 }
 
-static void free_skin(WinAmpSkin *skin)
+// Turn VIS_FFT_SIZE samples into VIS_FFT_HALF magnitudes.
+static void real_fft_magnitudes(const float *samples, float *magnitudes)
 {
-    if (skin->tex_main) { SDL_DestroyTexture(skin->tex_main); }
-    if (skin->tex_cbuttons) { SDL_DestroyTexture(skin->tex_cbuttons); };
-    if (skin->tex_volume) { SDL_DestroyTexture(skin->tex_volume); };
-    if (skin->tex_balance) { SDL_DestroyTexture(skin->tex_balance); };
-    if (skin->tex_titlebar) { SDL_DestroyTexture(skin->tex_titlebar); };
+    const VisTables *t = &vis_tables;
+    float re[VIS_FFT_HALF];
+    float im[VIS_FFT_HALF];
+    int i;
 
-    SDL_zerop(skin);
+    for (i = 0; i < VIS_FFT_HALF; i++) {
+        const int src = t->bitrev[i] * 2;
+        re[i] = samples[src] * t->window[src];
+        im[i] = samples[src + 1] * t->window[src + 1];
+    }
+
+    t->passes(re, im);
+
+    // untangle: X[k] = E[k] + W^k * O[k], where E and O are the FFTs of the even and odd samples.
+    for (i = 0; i < VIS_FFT_HALF; i++) {
+        const int j = (VIS_FFT_HALF - i) & (VIS_FFT_HALF - 1);
+        const float er = (re[i] + re[j]) * 0.5f;
+        const float ei = (im[i] - im[j]) * 0.5f;
+        const float or_ = (im[i] + im[j]) * 0.5f;
+        const float oi = (re[j] - re[i]) * 0.5f;
+        const float xr = er + ((or_ * t->split_re[i]) - (oi * t->split_im[i]));
+        const float xi = ei + ((or_ * t->split_im[i]) + (oi * t->split_re[i]));
+        magnitudes[i] = SDL_sqrtf((xr * xr) + (xi * xi));
+    }
 }
 
-static void load_skin(WinAmpSkin *skin, const char *fname)
+// Render thread. Returns SDL_TRUE if the visualizer needs repainting.
+static SDL_bool update_visualizer(void)
 {
-    free_skin(skin);
+    float samples[VIS_FFT_SIZE];
+    int i;
 
-    if (!PHYSFS_mount(fname, NULL, 1)) {
-        return;
+    if (vis_mode == VISMODE_OFF) {
+        return SDL_FALSE;
     }
 
-    skin->tex_main = load_texture(openrw("main.bmp"));
-    skin->tex_cbuttons = load_texture(openrw("cbuttons.bmp"));
-    skin->tex_volume = load_texture(openrw("volume.bmp"));
-    skin->tex_balance = load_texture(openrw("balance.bmp"));
-    skin->tex_titlebar = load_texture(openrw("titlebar.bmp"));
+    const Uint32 now = SDL_GetTicks();
+    if ((now - vis_last_update) < (1000 / VIS_FPS)) {
+        return SDL_FALSE;  // not time yet.
+    }
+    vis_last_update = now;
 
-    PHYSFS_unmount(fname);
+    const Uint64 started = SDL_GetPerformanceCounter();
 
-    // normal ("main") window mode...
-    init_skin_button(&skin->buttons[WASBTN_SYSTEM], skin->tex_titlebar, NULL, 9, 9, 6, 3, 0, 0, 0, 9);
-    init_skin_button(&skin->buttons[WASBTN_MINIMIZE], skin->tex_titlebar, minimize_clicked, 9, 9, 244, 3, 9, 0, 9, 9);
-    init_skin_button(&skin->buttons[WASBTN_WINSHADE], skin->tex_titlebar, winshade_clicked, 9, 9, 254, 3, 0, 18, 9, 18);
-    init_skin_button(&skin->buttons[WASBTN_CLOSE], skin->tex_titlebar, close_clicked, 9, 9, 264, 3, 18, 0, 18, 9);
-    init_skin_button(&skin->buttons[WASBTN_PREV], skin->tex_cbuttons, previous_clicked, 23, 18, 16, 88, 0, 0, 0, 18);
-    init_skin_button(&skin->buttons[WASBTN_PLAY], skin->tex_cbuttons, NULL, 23, 18, 39, 88, 23, 0, 23, 18);
-    init_skin_button(&skin->buttons[WASBTN_PAUSE], skin->tex_cbuttons, pause_clicked, 23, 18, 62, 88, 46, 0, 46, 18);
-    init_skin_button(&skin->buttons[WASBTN_STOP], skin->tex_cbuttons, stop_clicked, 23, 18, 85, 88, 69, 0, 69, 18);
-    init_skin_button(&skin->buttons[WASBTN_NEXT], skin->tex_cbuttons, NULL, 22, 18, 108, 88, 92, 0, 92, 18);
-    init_skin_button(&skin->buttons[WASBTN_EJECT], skin->tex_cbuttons, NULL, 22, 16, 136, 89, 114, 0, 114, 16);
-    init_skin_slider(&skin->sliders[WASSLD_VOLUME], skin->tex_volume, 68, 13, 107, 57, 14, 11, 15, 422, 0, 422, 28, 0, 0, 68, 15, 1.0f);
-    init_skin_slider(&skin->sliders[WASSLD_BALANCE], skin->tex_balance, 38, 13, 177, 57, 14, 11, 15, 422, 0, 422, 28, 9, 0, 47, 15, 0.5f);
+    // nothing new played (paused, stopped)? Treat it as silence, so the bars fall off.
+    const Uint32 tap_pos = (Uint32) SDL_AtomicGet(&vis_tap_pos);
+    if ((tap_pos == vis_last_tap_pos) || !read_vis_tap(samples, VIS_FFT_SIZE)) {
+        SDL_zero(samples);
+    }
+    vis_last_tap_pos = tap_pos;
+
+    SDL_bool changed = SDL_FALSE;
+    SDL_bool visible = SDL_FALSE;  // anything not flat on screen?
+    if (vis_mode == VISMODE_SPECTRUM) {
+        float magnitudes[VIS_FFT_HALF];
+        real_fft_magnitudes(samples, magnitudes);
+        for (i = 0; i < VIS_BARS; i++) {
+            float peak = 0.0f;
+            for (int bin = vis_tables.bar_edges[i]; bin < vis_tables.bar_edges[i + 1]; bin++) {
+                peak = SDL_max(peak, magnitudes[bin]);
+            }
+            // a full-scale sine wave peaks at about a quarter of the FFT size, with the window; show the top 60dB of that.
+            const float db = 20.0f * SDL_log10f((peak / (VIS_FFT_SIZE / 4.0f)) + 1e-6f);
+            const float height = SDL_clamp(((db + 60.0f) / 60.0f) * VIS_HEIGHT, 0.0f, (float) VIS_HEIGHT);
+            const float fallen = vis_bars[i] - 1.0f;  // drop a pixel a frame, like the real thing.
+            const float newval = SDL_max(height, fallen);
+            const float clamped = SDL_max(newval, 0.0f);
+            changed = changed || ((int) clamped != (int) vis_bars[i]);
+            visible = visible || (clamped >= 1.0f);
+            vis_bars[i] = clamped;
+        }
+    } else {
+        const int step = VIS_FFT_SIZE / SDL_arraysize(vis_scope);
+        for (i = 0; i < SDL_arraysize(vis_scope); i++) {
+            const float val = SDL_clamp(samples[i * step], -1.0f, 1.0f);
+            changed = changed || (val != vis_scope[i]);
+            visible = visible || (val != 0.0f);
+            vis_scope[i] = val;
+        }
+    }
 
-    // winshade mode...
-    init_skin_button(&skin->winshade_buttons[WASBTN_SYSTEM], skin->tex_titlebar, NULL, 9, 9, 6, 3, 0, 0, 0, 9);
-    init_skin_button(&skin->winshade_buttons[WASBTN_MINIMIZE], skin->tex_titlebar, minimize_clicked, 9, 9, 244, 3, 9, 0, 9, 9);
-    init_skin_button(&skin->winshade_buttons[WASBTN_WINSHADE], skin->tex_titlebar, unwinshade_clicked, 9, 9, 254, 3, 0, 27, 9, 27);
-    init_skin_button(&skin->winshade_buttons[WASBTN_CLOSE], skin->tex_titlebar, close_clicked, 9, 9, 264, 3, 18, 0, 18, 9);
-    init_skin_button(&skin->winshade_buttons[WASBTN_PREV], skin->tex_titlebar, previous_clicked, 8, 10, 168, 2, 195, 31, 195, 31);
-    init_skin_button(&skin->winshade_buttons[WASBTN_PLAY], skin->tex_titlebar, NULL, 10, 10, 176, 2, 203, 31, 203, 31);
-    init_skin_button(&skin->winshade_buttons[WASBTN_PAUSE], skin->tex_titlebar, pause_clicked, 9, 10, 186, 2, 213, 31, 213, 31);
-    init_skin_button(&skin->winshade_buttons[WASBTN_STOP], skin->tex_titlebar, stop_clicked, 9, 10, 195, 2, 222, 31, 222, 31);
-    init_skin_button(&skin->winshade_buttons[WASBTN_NEXT], skin->tex_titlebar, NULL, 11, 10, 204, 2, 231, 31, 231, 31);
-    init_skin_button(&skin->winshade_buttons[WASBTN_EJECT], skin->tex_titlebar, NULL, 10, 10, 215, 2, 242, 31, 242, 31);
-    init_skin_slider(&skin->winshade_position_slider, skin->tex_titlebar, 17, 7, 27, 29, 3, 7, 17, 36, 17, 36, 1, 0, 36, 17, 7, 0.0f);
+    const Uint64 elapsed = SDL_GetPerformanceCounter() - started;
+    vis_updates++;
+    vis_total_ticks += elapsed;
+    vis_max_ticks = SDL_max(vis_max_ticks, elapsed);
+
+    // once it's gone flat, stop asking for frames; the main loop can go back to sleeping.
+    vis_animating = (changed || visible) ? SDL_TRUE : SDL_FALSE;
+    return changed;
 }
 
 static void init_everything(int argc, char **argv)
@@ -445,17 +2556,60 @@ static void init_everything(int argc, char **argv)
         panic_and_abort("SDL_CreateRenderer failed", SDL_GetError());
     }
 
+    // if the renderer can't do render targets, we'll just repaint the whole window whenever anything changes.
+    canvas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, 275, 116);
+
     SDL_ShowWindow(window);
 
+    skin_sem = SDL_CreateSemaphore(0);
+    skin_lock = SDL_CreateMutex();
+    if (!skin_sem || !skin_lock) {
+        panic_and_abort("Couldn't create skin thread state!", SDL_GetError());
+    }
+
     load_skin(&skin, "classic.wsz");
+    publish_mixer_params();
+    mark_dirty(NULL);
+    SDL_AtomicSet(&params.paused, 1);  // we start out paused (no readers exist yet, so no need for a version bump).
 
     SDL_zero(desired);
     desired.freq = 48000;
     desired.format = AUDIO_F32;
     desired.channels = 2;
-    desired.samples = 4096;
+    desired.samples = AUDIO_DEVICE_FRAMES;
     desired.callback = feed_audio_device_callback;
 
+    apply_gain = choose_apply_gain();
+    init_visualizer();
+
+    if (!init_audio_ring(&ring, desired.channels, desired.samples)) {
+        panic_and_abort("Couldn't allocate audio buffer!", SDL_GetError());
+    }
+
+    decoder_sem = SDL_CreateSemaphore(0);
+    decoder_lock = SDL_CreateMutex();
+    if (!decoder_sem || !decoder_lock) {
+        panic_and_abort("Couldn't create decoder thread state!", SDL_GetError());
+    }
+
+    preload_sem = SDL_CreateSemaphore(0);
+    index_sem = SDL_CreateSemaphore(0);
+    playlist_lock = SDL_CreateMutex();
+    scan_lock = SDL_CreateMutex();
+    if (!preload_sem || !index_sem || !playlist_lock || !scan_lock) {
+        panic_and_abort("Couldn't create playlist thread state!", SDL_GetError());
+    }
+
+    SDL_AtomicSet(&playing_index, -1);
+    load_index_cache();
+
+    decoder_error_event = SDL_RegisterEvents(3);
+    if (decoder_error_event == ((Uint32) -1)) {
+        panic_and_abort("Couldn't register decoder events!", SDL_GetError());
+    }
+    skin_ready_event = decoder_error_event + 1;
+    playlist_event = decoder_error_event + 2;
+
     audio_device = SDL_OpenAudioDevice(NULL, 0, &desired, NULL, 0);
     if (audio_device == 0) {
         panic_and_abort("Couldn't audio device!", SDL_GetError());
@@ -466,101 +2620,419 @@ static void init_everything(int argc, char **argv)
     audio_device_spec.channels = desired.channels;
     audio_device_spec.rate = desired.freq;
 
+    SDL_PauseAudioDevice(audio_device, 0);  // always running; pausing is handled in the callback, see pause_clicked().
+
+    decoder_thread = SDL_CreateThread(decoder_thread_entry, "decoder", NULL);
+    if (!decoder_thread) {
+        panic_and_abort("Couldn't start decoder thread!", SDL_GetError());
+    }
+
+    preload_thread = SDL_CreateThread(preload_thread_entry, "preload", NULL);
+    if (!preload_thread) {
+        panic_and_abort("Couldn't start preload thread!", SDL_GetError());
+    }
+
+    // indexing is mostly waiting on the disk, but probing a file can burn some CPU, so don't take over the machine.
+    num_index_threads = (int) get_hint_uint("SDLAMP_INDEX_THREADS", (Uint32) SDL_clamp(SDL_GetCPUCount() - 1, 1, 4));
+    num_index_threads = SDL_clamp(num_index_threads, 1, (int) SDL_arraysize(index_threads));
+    for (int i = 0; i < num_index_threads; i++) {
+        index_threads[i] = SDL_CreateThread(index_thread_entry, "index", NULL);
+        if (!index_threads[i]) {
+            panic_and_abort("Couldn't start index thread!", SDL_GetError());
+        }
+    }
+
+    skin_thread = SDL_CreateThread(skin_thread_entry, "skin", NULL);
+    if (!skin_thread) {
+        panic_and_abort("Couldn't start skin thread!", SDL_GetError());
+    }
+
     SDL_EventState(SDL_DROPFILE, SDL_ENABLE);  // tell SDL we want this event that is disabled by default.
+    SDL_EventState(SDL_DROPBEGIN, SDL_ENABLE);
+    SDL_EventState(SDL_DROPCOMPLETE, SDL_ENABLE);
+
+    play_playlist_entry(add_to_playlist("music.wav"));
+}
+
+// Everything on screen is a rectangle out of the skin atlas, so a frame is
+//  collected here as a list of quads and handed to the renderer in one call,
+//  instead of one SDL_RenderCopy per element.
+#define MAX_SKIN_QUADS 128
+
+typedef struct
+{
+    SDL_Rect srcrect;  // in atlas coordinates.
+    SDL_Rect dstrect;
+    SDL_Color color;
+    SDL_Color bottom_color;  // usually the same as `color`, but solid quads can be a vertical gradient.
+    SDL_bool solid;  // srcrect is the atlas's white block, tinted by color.
+} SkinQuad;
+
+static SkinQuad skin_quads[MAX_SKIN_QUADS];
+static int num_skin_quads = 0;
+
+static void flush_skin_quads(SDL_Renderer *renderer, const WinAmpSkin *skin)
+{
+    int i;
+
+    if (num_skin_quads == 0) {
+        return;
+    }
+
+    #if SDL_VERSION_ATLEAST(2, 0, 18)
+    {
+        static SDL_Vertex vertices[MAX_SKIN_QUADS * 4];
+        static int indices[MAX_SKIN_QUADS * 6];
+        const float tw = (float) skin->atlas_w;
+        const float th = (float) skin->atlas_h;
+        for (i = 0; i < num_skin_quads; i++) {
+            const SkinQuad *q = &skin_quads[i];
+            SDL_Vertex *v = &vertices[i * 4];
+            int *idx = &indices[i * 6];
+            const float x0 = (float) q->dstrect.x;
+            const float y0 = (float) q->dstrect.y;
+            const float x1 = (float) (q->dstrect.x + q->dstrect.w);
+            const float y1 = (float) (q->dstrect.y + q->dstrect.h);
+            const float u0 = ((float) q->srcrect.x) / tw;
+            const float v0 = ((float) q->srcrect.y) / th;
+            const float u1 = ((float) (q->srcrect.x + q->srcrect.w)) / tw;
+            const float v1 = ((float) (q->srcrect.y + q->srcrect.h)) / th;
+            const int base = i * 4;
+            v[0].position.x = x0; v[0].position.y = y0; v[0].tex_coord.x = u0; v[0].tex_coord.y = v0;
+            v[1].position.x = x1; v[1].position.y = y0; v[1].tex_coord.x = u1; v[1].tex_coord.y = v0;
+            v[2].position.x = x1; v[2].position.y = y1; v[2].tex_coord.x = u1; v[2].tex_coord.y = v1;
+            v[3].position.x = x0; v[3].position.y = y1; v[3].tex_coord.x = u0; v[3].tex_coord.y = v1;
+            v[0].color = v[1].color = q->color;
+            v[2].color = v[3].color = q->bottom_color;
+            idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+            idx[3] = base; idx[4] = base + 2; idx[5] = base + 3;
+        }
+
+        if (SDL_RenderGeometry(renderer, skin->atlas, vertices, num_skin_quads * 4, indices, num_skin_quads * 6) == 0) {
+            num_skin_quads = 0;
+            return;
+        }
+    }
+    #endif
+
+    // no geometry support (or it failed), do it the old way.
+    for (i = 0; i < num_skin_quads; i++) {
+        const SkinQuad *q = &skin_quads[i];
+        if (q->solid) {
+            SDL_SetRenderDrawColor(renderer, q->color.r, q->color.g, q->color.b, 255);
+            SDL_RenderFillRect(renderer, &q->dstrect);
+        } else {
+            SDL_RenderCopy(renderer, skin->atlas, &q->srcrect, &q->dstrect);
+        }
+    }
+    num_skin_quads = 0;
+}
+
+static void add_skin_quad(SDL_Renderer *renderer, const WinAmpSkin *skin, const SDL_Rect *srcrect, const SDL_Rect *dstrect)
+{
+    if (num_skin_quads == MAX_SKIN_QUADS) {
+        flush_skin_quads(renderer, skin);
+    }
+    SkinQuad *q = &skin_quads[num_skin_quads++];
+    q->srcrect = *srcrect;
+    q->dstrect = *dstrect;
+    q->color.r = q->color.g = q->color.b = q->color.a = 255;
+    q->bottom_color = q->color;
+    q->solid = SDL_FALSE;
+}
+
+// Without SDL_RenderGeometry, gradients just come out as the top color.
+static void add_gradient_quad(SDL_Renderer *renderer, const WinAmpSkin *skin, const SDL_Rect *dstrect, const SDL_Color *top, const SDL_Color *bottom)
+{
+    if (num_skin_quads == MAX_SKIN_QUADS) {
+        flush_skin_quads(renderer, skin);
+    }
+    SkinQuad *q = &skin_quads[num_skin_quads++];
+    // sample from the middle of the white block so filtering can't pull in a neighbor's pixels.
+    q->srcrect.x = skin->white.x + 1;
+    q->srcrect.y = skin->white.y + 1;
+    q->srcrect.w = skin->white.w - 2;
+    q->srcrect.h = skin->white.h - 2;
+    q->dstrect = *dstrect;
+    q->color = *top;
+    q->bottom_color = *bottom;
+    q->solid = SDL_TRUE;
+}
 
-    open_new_audio_file("music.wav");
+static void add_solid_quad(SDL_Renderer *renderer, const WinAmpSkin *skin, const SDL_Rect *dstrect, const Uint8 r, const Uint8 g, const Uint8 b)
+{
+    const SDL_Color color = { r, g, b, 255 };
+    add_gradient_quad(renderer, skin, dstrect, &color, &color);
 }
 
-static void draw_button(SDL_Renderer *renderer, WinAmpSkinButton *btn)
+static void draw_button(SDL_Renderer *renderer, const WinAmpSkin *skin, const WinAmpSkinButton *btn)
 {
-    const SDL_bool pressed = (skin.pressed == btn);
-    if (btn->texture == NULL) {
+    const SDL_bool pressed = (skin->pressed == btn);
+    if (!btn->has_bitmap) {
         if (pressed) {
-            SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255);
+            add_solid_quad(renderer, skin, &btn->dstrect, 0, 0, 255);
         } else {
-            SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+            add_solid_quad(renderer, skin, &btn->dstrect, 255, 0, 0);
         }
-        SDL_RenderFillRect(renderer, &btn->dstrect);
     } else {
-        SDL_RenderCopy(renderer, btn->texture, pressed ? &btn->srcrect_pressed : &btn->srcrect_unpressed, &btn->dstrect);
+        add_skin_quad(renderer, skin, pressed ? &btn->srcrect_pressed : &btn->srcrect_unpressed, &btn->dstrect);
     }
 }
 
-static void draw_slider(SDL_Renderer *renderer, WinAmpSkinSlider *slider)
+static void draw_slider(SDL_Renderer *renderer, const WinAmpSkin *skin, const WinAmpSkinSlider *slider)
 {
     SDL_assert(slider->value >= 0.0f);
     SDL_assert(slider->value <= 1.0f);
 
-    if (slider->texture == NULL) {
-        const int color = (int) (255.0f * slider->value);
-        SDL_SetRenderDrawColor(renderer, color, color, color, 255);
-        SDL_RenderFillRect(renderer, &slider->dstrect);
+    if (!slider->has_bitmap) {
+        const Uint8 color = (Uint8) (255.0f * slider->value);
+        add_solid_quad(renderer, skin, &slider->dstrect, color, color, color);
     } else {
         int frameidx = (int) (((float) slider->num_frames) * slider->value);
         frameidx = SDL_clamp(frameidx, 0, slider->num_frames - 1);
         const int srcy = slider->frame_y_offset + (slider->frame_height * frameidx);
         const SDL_Rect srcrect = { slider->frame_x_offset, srcy, slider->dstrect.w, slider->dstrect.h };
-        SDL_RenderCopy(renderer, slider->texture, &srcrect, &slider->dstrect);
+        add_skin_quad(renderer, skin, &srcrect, &slider->dstrect);
     }
-    draw_button(renderer, &slider->knob);
+    draw_button(renderer, skin, &slider->knob);
 }
 
-static void draw_frame(SDL_Renderer *renderer, WinAmpSkin *skin)
+// The classic skin's default visualizer colors: spectrum rows top to bottom, then the scope.
+static const SDL_Color vis_spectrum_top = { 239, 49, 16, 255 };
+static const SDL_Color vis_spectrum_bottom = { 24, 132, 8, 255 };
+static const SDL_Color vis_scope_color = { 255, 255, 255, 255 };
+
+static void draw_visualizer(SDL_Renderer *renderer, const WinAmpSkin *skin)
+{
+    int i;
+
+    if (vis_mode == VISMODE_SPECTRUM) {
+        for (i = 0; i < VIS_BARS; i++) {
+            const int height = (int) vis_bars[i];
+            if (height > 0) {
+                // the colors are fixed to the rows, not the bar, so a short bar is all green.
+                const float frac = ((float) (VIS_HEIGHT - height)) / ((float) (VIS_HEIGHT - 1));
+                SDL_Color top;
+                top.r = (Uint8) (vis_spectrum_top.r + ((vis_spectrum_bottom.r - vis_spectrum_top.r) * frac));
+                top.g = (Uint8) (vis_spectrum_top.g + ((vis_spectrum_bottom.g - vis_spectrum_top.g) * frac));
+                top.b = (Uint8) (vis_spectrum_top.b + ((vis_spectrum_bottom.b - vis_spectrum_top.b) * frac));
+                top.a = 255;
+                const SDL_Rect bar = { vis_rect.x + (i * 4), vis_rect.y + (VIS_HEIGHT - height), 3, height };
+                add_gradient_quad(renderer, skin, &bar, &top, &vis_spectrum_bottom);
+            }
+        }
+    } else if (vis_mode == VISMODE_SCOPE) {
+        for (i = 0; i < SDL_arraysize(vis_scope); i++) {
+            const int y = (int) ((1.0f - vis_scope[i]) * ((VIS_HEIGHT - 1) / 2.0f) + 0.5f);
+            const SDL_Rect dot = { vis_rect.x + i, vis_rect.y + y, 1, 1 };
+            add_gradient_quad(renderer, skin, &dot, &vis_scope_color, &vis_scope_color);
+        }
+    }
+}
+
+// Repaint the part of the window inside `region`. The caller sets the clip rect.
+static void paint_region(SDL_Renderer *renderer, WinAmpSkin *skin, const SDL_Rect *region)
 {
     WinAmpSkinButton *buttons = skin->winshade_mode ? skin->winshade_buttons : skin->buttons;
     const int num_buttons = skin->winshade_mode ? SDL_arraysize(skin->winshade_buttons) : SDL_arraysize(skin->buttons);
     WinAmpSkinSlider *sliders = skin->winshade_mode ? &skin->winshade_position_slider : skin->sliders;
     const int num_sliders = skin->winshade_mode ? 1 : SDL_arraysize(skin->sliders);
     const SDL_bool has_focus = (SDL_GetWindowFlags(window) & SDL_WINDOW_INPUT_FOCUS) ? SDL_TRUE : SDL_FALSE;
-    SDL_Rect src_rect = { 27, 0, 275, 14 };
+    const SDL_Rect *titlebar = &skin->bitmaps[WASBMP_TITLEBAR];
+    const SDL_Rect *mainbmp = &skin->bitmaps[WASBMP_MAIN];
+    SDL_Rect src_rect = { titlebar->x + 27, titlebar->y, 275, 14 };
     const SDL_Rect dst_rect = { 0, 0, 275, 14 };
     int i;
 
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderClear(renderer);
+    if (!skin->atlas) {
+        // couldn't even make a texture; just clear to black and draw nothing else.
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderFillRect(renderer, region);  // SDL_RenderClear ignores the clip rect, so do this instead.
+        return;
+    }
+
+    // this goes into the batch too, instead of a SDL_RenderClear, which ignores the clip rect.
+    add_solid_quad(renderer, skin, region, 0, 0, 0);
 
     if (skin->winshade_mode) {
         const int pixelpos = (int) (skin->winshade_position_slider.value * skin->winshade_position_slider.frame_width);
         if (pixelpos < 7) {
-            skin->winshade_position_slider.knob.srcrect_unpressed.x = 17;
+            skin->winshade_position_slider.knob.srcrect_unpressed.x = titlebar->x + 17;
         } else if (pixelpos < 10) {
-            skin->winshade_position_slider.knob.srcrect_unpressed.x = 20;
+            skin->winshade_position_slider.knob.srcrect_unpressed.x = titlebar->x + 20;
         } else {
-            skin->winshade_position_slider.knob.srcrect_unpressed.x = 23;
+            skin->winshade_position_slider.knob.srcrect_unpressed.x = titlebar->x + 23;
         }
         skin->winshade_position_slider.knob.srcrect_pressed.x = skin->winshade_position_slider.knob.srcrect_unpressed.x;
-        src_rect.y = has_focus ? 29 : 42;
+        src_rect.y += has_focus ? 29 : 42;
 
     // !!! FIXME: write this } else if (skin->easter_egg_mode) {
-    // !!! FIXME: write this   src_rect.y = has_focus ? 29 : 42;
+    // !!! FIXME: write this   src_rect.y += has_focus ? 29 : 42;
 
     } else {
-        src_rect.y = has_focus ? 0 : 15;
-        SDL_RenderCopy(renderer, skin->tex_main, NULL, NULL);
+        src_rect.y += has_focus ? 0 : 15;
+        if (mainbmp->w > 0) {
+            const SDL_Rect main_dst = { 0, 0, 275, 116 };
+            add_skin_quad(renderer, skin, mainbmp, &main_dst);
+        }
     }
 
-    SDL_RenderCopy(renderer, skin->tex_titlebar, &src_rect, &dst_rect);
+    if ((titlebar->w > 0) && SDL_HasIntersection(region, &dst_rect)) {
+        add_skin_quad(renderer, skin, &src_rect, &dst_rect);
+    }
 
     for (i = 0; i < num_buttons; i++) {
-        draw_button(renderer, &buttons[i]);
+        if (SDL_HasIntersection(region, &buttons[i].dstrect)) {
+            draw_button(renderer, skin, &buttons[i]);
+        }
     }
 
     for (i = 0; i < num_sliders; i++) {
-        draw_slider(renderer, &sliders[i]);
+        if (SDL_HasIntersection(region, &sliders[i].dstrect)) {
+            draw_slider(renderer, skin, &sliders[i]);
+        }
+    }
+
+    if (!skin->winshade_mode && SDL_HasIntersection(region, &vis_rect)) {
+        draw_visualizer(renderer, skin);
+    }
+
+    flush_skin_quads(renderer, skin);
+}
+
+// Repaint whatever changed since last time and present it. Does nothing at all if nothing changed.
+static void draw_frame(SDL_Renderer *renderer, WinAmpSkin *skin)
+{
+    const SDL_Rect winrect = { 0, 0, 275, skin->winshade_mode ? 14 : 116 };
+    int i;
+
+    if (num_dirty_rects == 0) {
+        return;  // nothing to do, don't even touch the GPU.
+    }
+
+    if (canvas) {
+        SDL_SetRenderTarget(renderer, canvas);
+    }
+
+    for (i = 0; i < num_dirty_rects; i++) {
+        SDL_RenderSetClipRect(renderer, &dirty_rects[i]);
+        paint_region(renderer, skin, &dirty_rects[i]);
+        regions_painted++;
+    }
+
+    SDL_RenderSetClipRect(renderer, NULL);
+    num_dirty_rects = 0;
+
+    if (canvas) {
+        SDL_SetRenderTarget(renderer, NULL);
+        SDL_RenderCopy(renderer, canvas, &winrect, &winrect);
     }
 
     SDL_RenderPresent(renderer);
+    frames_presented++;
 }
 
 static void deinit_everything(void)
 {
     SDL_CloseAudioDevice(audio_device);
-    if (current_sample) {
-        Sound_FreeSample(current_sample);
-        current_sample = NULL;
+
+    SDL_LockMutex(skin_lock);
+    skin_quit = SDL_TRUE;
+    SDL_UnlockMutex(skin_lock);
+    SDL_SemPost(skin_sem);
+    SDL_WaitThread(skin_thread, NULL);
+    skin_thread = NULL;
+    SDL_free(pending_skin_fname);
+    pending_skin_fname = NULL;
+    while (decoded_skins) {  // anything still pinned was in an event nobody will read now.
+        DecodedSkin *next = decoded_skins->next;
+        free_decoded_skin(decoded_skins);
+        decoded_skins = next;
+    }
+    SDL_DestroySemaphore(skin_sem);
+    skin_sem = NULL;
+    SDL_DestroyMutex(skin_lock);
+    skin_lock = NULL;
+
+    SDL_LockMutex(playlist_lock);
+    index_quit = SDL_TRUE;
+    preload_quit = SDL_TRUE;
+    SDL_UnlockMutex(playlist_lock);
+    for (int i = 0; i < num_index_threads; i++) {
+        SDL_SemPost(index_sem);
+    }
+    for (int i = 0; i < num_index_threads; i++) {
+        SDL_WaitThread(index_threads[i], NULL);
+        index_threads[i] = NULL;
+    }
+    num_index_threads = 0;
+    SDL_SemPost(preload_sem);
+    SDL_WaitThread(preload_thread, NULL);
+    preload_thread = NULL;
+
+    clear_playlist();
+    SDL_free(playlist);
+    playlist = NULL;
+    playlist_capacity = 0;
+    SDL_free(index_dirs);
+    index_dirs = NULL;
+
+    save_index_cache();
+    for (Uint32 i = 0; i < index_cache_capacity; i++) {
+        SDL_free(index_cache[i].path);
+    }
+    SDL_free(index_cache);
+    index_cache = NULL;
+    index_cache_capacity = index_cache_count = 0;
+    SDL_free(index_cache_path);
+    index_cache_path = NULL;
+
+    SDL_DestroySemaphore(index_sem);
+    index_sem = NULL;
+    SDL_DestroySemaphore(preload_sem);
+    preload_sem = NULL;
+    SDL_DestroyMutex(playlist_lock);
+    playlist_lock = NULL;
+    SDL_DestroyMutex(scan_lock);
+    scan_lock = NULL;
+
+    send_decoder_command(DECODERCMD_QUIT, NULL);
+    SDL_WaitThread(decoder_thread, NULL);  // decoder thread frees the current sample on its way out.
+    decoder_thread = NULL;
+
+    for (int i = 0; i < num_seek_stats; i++) {
+        const SeekStats *stats = &seek_stats[i];
+        SDL_Log("Seek latency for %s: %u seeks, %.2fms average, %.2fms worst.", stats->decoder,
+                (unsigned int) stats->count, stats->total_ms / ((double) stats->count), stats->max_ms);
+    }
+    SDL_DestroySemaphore(decoder_sem);
+    decoder_sem = NULL;
+    SDL_DestroyMutex(decoder_lock);
+    decoder_lock = NULL;
+
+    Sound_Sample *unused = (Sound_Sample *) SDL_AtomicSetPtr((void **) &pending_sample, NULL);
+    if (unused) {  // the decoder thread never picked this up.
+        Sound_FreeSample(unused);
+    }
+
+    if (SDL_AtomicGet(&ring.underruns) > 0) {
+        SDL_Log("Audio underruns this session: %d", SDL_AtomicGet(&ring.underruns));
+    }
+    free_audio_ring(&ring);
+
+    SDL_Log("Presented %u frames, painted %u regions.", (unsigned int) frames_presented, (unsigned int) regions_painted);
+    if (vis_updates > 0) {
+        const double freq = (double) SDL_GetPerformanceFrequency();
+        SDL_Log("Visualizer: %u updates, %.1fus average, %.1fus worst.", (unsigned int) vis_updates,
+                (((double) vis_total_ticks) * 1000000.0) / (freq * ((double) vis_updates)),
+                (((double) vis_max_ticks) * 1000000.0) / freq);
     }
 
     free_skin(&skin);
+    if (canvas) {
+        SDL_DestroyTexture(canvas);
+        canvas = NULL;
+    }
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     PHYSFS_deinit();
@@ -568,6 +3040,47 @@ static void deinit_everything(void)
     SDL_Quit();
 }
 
+// Where are we in the current track, as a fraction of its length? Zero if we can't tell.
+static float get_playback_position(void)
+{
+    SDL_LockMutex(decoder_lock);
+    const Uint32 base_pos = playing_base_pos;
+    const Uint32 base_ms = playing_base_ms;
+    const Sint32 duration = playing_duration_ms;
+    SDL_UnlockMutex(decoder_lock);
+
+    if (duration <= 0) {
+        return 0.0f;
+    }
+
+    // the ring is in device frames, so how far the callback has read past the base tells us how much has played since.
+    const Sint32 played = (Sint32) (((Uint32) SDL_AtomicGet(&ring.read_pos)) - base_pos);
+    const double ms = ((double) base_ms) + ((played > 0) ? ((((double) played) * 1000.0) / ((double) audio_device_spec.rate)) : 0.0);
+    return (float) SDL_clamp(ms / ((double) duration), 0.0, 1.0);
+}
+
+static void update_position_slider(WinAmpSkin *skin)
+{
+    WinAmpSkinSlider *slider = &skin->winshade_position_slider;
+    if (skin->pressed == &slider->knob) {
+        return;  // the user is dragging it; leave it alone.
+    } else if (set_slider_value(slider, get_playback_position()) && skin->winshade_mode) {
+        mark_dirty(&slider->dstrect);
+    }
+}
+
+// UI thread only. Seek to wherever the winshade position slider was dropped.
+static void seek_to_position_slider(WinAmpSkin *skin)
+{
+    SDL_LockMutex(decoder_lock);
+    const Sint32 duration = playing_duration_ms;
+    SDL_UnlockMutex(decoder_lock);
+
+    if (duration > 0) {  // can't seek if we don't know how long it is.
+        request_seek((Uint32) (((double) skin->winshade_position_slider.value) * ((double) duration)));
+    }
+}
+
 static void handle_slider_motion(WinAmpSkinSlider *slider, const SDL_Point *pt)
 {
     if (skin.pressed == &slider->knob) {
@@ -577,17 +3090,49 @@ static void handle_slider_motion(WinAmpSkinSlider *slider, const SDL_Point *pt)
         const int xfar = (slider->dstrect.x + slider->dstrect.w) - slider->knob.dstrect.w;
         slider->knob.dstrect.x = SDL_clamp(new_knob_x, xnear, xfar);
 
-        // make sure the mixer thread isn't running when this value changes.
-        SDL_LockAudioDevice(audio_device);
         slider->value = SDL_clamp(new_value, 0.0f, 1.0f);
-        SDL_UnlockAudioDevice(audio_device);
+        mark_dirty(&slider->dstrect);
+        publish_mixer_params();  // the audio callback picks this up on its next period; no lock needed.
     }
 }
 
 static SDL_bool handle_events(WinAmpSkin *skin)
 {
+    static SDL_bool drop_in_progress = SDL_FALSE;
+    static SDL_bool drop_cleared_playlist = SDL_FALSE;
+    static SDL_bool drop_opened_file = SDL_FALSE;
     SDL_Event e;
-    while (SDL_PollEvent(&e)) {
+
+    // sleep until something happens. The timeout is only so the main loop notices things that don't send events, like
+    //  underruns, and so the visualizer gets its frames while it's moving.
+    const SDL_bool animating = (vis_animating && (vis_mode != VISMODE_OFF) && !skin->winshade_mode) ? SDL_TRUE : SDL_FALSE;
+    if (!SDL_WaitEventTimeout(&e, animating ? (1000 / VIS_FPS) : 1000)) {
+        return SDL_TRUE;  // keep going.
+    }
+
+    do {
+        if (e.type == decoder_error_event) {  // can't be a case label, it's not a constant.
+            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, (const char *) e.user.data1, (const char *) e.user.data2, window);
+            SDL_free(e.user.data2);
+            continue;
+        } else if (e.type == skin_ready_event) {
+            DecodedSkin *decoded = (DecodedSkin *) e.user.data1;
+            apply_decoded_skin(skin, decoded);
+            unpin_decoded_skin(decoded);
+            publish_mixer_params();  // new skin resets the sliders.
+            mark_dirty(NULL);
+            continue;
+        } else if (e.type == playlist_event) {
+            // a directory scan came back. If nothing's been started from this playlist yet, start at the top.
+            SDL_LockMutex(playlist_lock);
+            const SDL_bool start = ((playlist_queued < 0) && (playlist_len > 0)) ? SDL_TRUE : SDL_FALSE;
+            SDL_UnlockMutex(playlist_lock);
+            if (start) {
+                play_playlist_entry(0);
+            }
+            continue;
+        }
+
         switch (e.type) {
             case SDL_QUIT:
                 return SDL_FALSE;  // don't keep going.
@@ -609,7 +3154,7 @@ static SDL_bool handle_events(WinAmpSkin *skin)
                     for (int i = 0; i < num_buttons; i++) {
                         WinAmpSkinButton *btn = &buttons[i];
                         if (SDL_PointInRect(&pt, &btn->dstrect)) {
-                            skin->pressed = btn;
+                            set_pressed(btn);
                             break;
                         }
                     }
@@ -619,8 +3164,8 @@ static SDL_bool handle_events(WinAmpSkin *skin)
                     for (int i = 0; i < num_sliders; i++) {
                         WinAmpSkinSlider *slider = &sliders[i];
                         if (SDL_PointInRect(&pt, &slider->dstrect)) {
-                            skin->pressed = &slider->knob;
-                            handle_slider_motion(sliders, &pt);
+                            set_pressed(&slider->knob);
+                            handle_slider_motion(slider, &pt);
                             break;
                         }
                     }
@@ -628,6 +3173,12 @@ static SDL_bool handle_events(WinAmpSkin *skin)
 
                 if (skin->pressed) {
                     SDL_CaptureMouse(SDL_TRUE);
+                } else if (!skin->winshade_mode && SDL_PointInRect(&pt, &vis_rect)) {
+                    vis_mode = (VisMode) ((vis_mode + 1) % VISMODE_TOTAL);  // click the visualizer to change what it shows.
+                    SDL_zero(vis_bars);
+                    SDL_zero(vis_scope);
+                    vis_animating = SDL_TRUE;
+                    mark_dirty(&vis_rect);
                 }
 
                 break;
@@ -640,13 +3191,15 @@ static SDL_bool handle_events(WinAmpSkin *skin)
 
                 if (skin->pressed) {
                     SDL_CaptureMouse(SDL_FALSE);
-                    if (skin->pressed->clickfn) {
+                    if (skin->pressed == &skin->winshade_position_slider.knob) {
+                        seek_to_position_slider(skin);
+                    } else if (skin->pressed->clickfn) {
                         const SDL_Point pt = { e.button.x, e.button.y };
                         if (SDL_PointInRect(&pt, &skin->pressed->dstrect)) {
                             skin->pressed->clickfn();
                         }
                     }
-                    skin->pressed = NULL;
+                    set_pressed(NULL);
                 }
                 break;
             }
@@ -656,30 +3209,89 @@ static SDL_bool handle_events(WinAmpSkin *skin)
                 for (int i = 0; i < SDL_arraysize(skin->sliders); i++) {
                     handle_slider_motion(&skin->sliders[i], &pt);
                 }
+                handle_slider_motion(&skin->winshade_position_slider, &pt);
                 break;
             }
 
+            case SDL_DROPBEGIN:
+                drop_in_progress = SDL_TRUE;
+                drop_cleared_playlist = SDL_FALSE;
+                drop_opened_file = SDL_FALSE;
+                break;
+
+            case SDL_DROPCOMPLETE:
+                drop_in_progress = SDL_FALSE;
+                break;
+
             case SDL_DROPFILE: {
                 const char *ptr = SDL_strrchr(e.drop.file, '.');
                 if (ptr && ((SDL_strcasecmp(ptr, ".wsz") == 0) || (SDL_strcasecmp(ptr, ".zip") == 0))) {
-                    load_skin(skin, e.drop.file);
+                    request_skin(e.drop.file);  // shows up later as a skin_ready_event.
                 } else {
-                    open_new_audio_file(e.drop.file);
+                    // a new drop replaces the playlist; if several things were dropped at once, they all go in it.
+                    if (!drop_in_progress || !drop_cleared_playlist) {
+                        clear_playlist();
+                        drop_cleared_playlist = drop_in_progress;
+                        drop_opened_file = SDL_FALSE;
+                    }
+
+                    const int index = add_to_playlist(e.drop.file);  // directories get scanned in the background.
+                    if ((index >= 0) && !drop_opened_file) {
+                        drop_opened_file = play_playlist_entry(index);
+                    }
                 }
                 SDL_free(e.drop.file);
                 break;
             }
+
+            case SDL_WINDOWEVENT:
+                switch (e.window.event) {
+                    case SDL_WINDOWEVENT_FOCUS_GAINED:
+                    case SDL_WINDOWEVENT_FOCUS_LOST: {
+                        const SDL_Rect titlebar = { 0, 0, 275, 14 };
+                        mark_dirty(&titlebar);  // titlebar art changes with focus.
+                        break;
+                    }
+
+                    case SDL_WINDOWEVENT_SHOWN:
+                    case SDL_WINDOWEVENT_EXPOSED:
+                    case SDL_WINDOWEVENT_SIZE_CHANGED:
+                    case SDL_WINDOWEVENT_RESTORED:
+                        mark_dirty(NULL);
+                        break;
+                }
+                break;
+
+            case SDL_RENDER_TARGETS_RESET:
+            case SDL_RENDER_DEVICE_RESET:
+                mark_dirty(NULL);  // the canvas contents are gone, start over.
+                break;
         }
-    }
+    } while (SDL_PollEvent(&e));
 
     return SDL_TRUE;  // keep going.
 }
 
+static void report_underruns(void)
+{
+    static int reported = 0;
+    const int underruns = SDL_AtomicGet(&ring.underruns);
+    if (underruns != reported) {
+        SDL_Log("Audio underrun! (%d so far)", underruns);
+        reported = underruns;
+    }
+}
+
 int main(int argc, char **argv)
 {
     init_everything(argc, argv);  // will panic_and_abort on issues.
 
     while (handle_events(&skin)) {
+        report_underruns();
+        update_position_slider(&skin);
+        if (!skin.winshade_mode && update_visualizer()) {
+            mark_dirty(&vis_rect);
+        }
         draw_frame(renderer, &skin);
     }
 